@@ -0,0 +1,191 @@
+#include "BlockCompress.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using vec3f = std::array< float, 3 >;
+
+//principal axis of a set of points (power iteration on the covariance matrix):
+// returns false if the points are all (nearly) the same
+bool principal_axis(vec3f const *points, uint32_t count, vec3f *mean_, vec3f *axis_) {
+	vec3f mean{0.0f, 0.0f, 0.0f};
+	for (uint32_t i = 0; i < count; ++i) {
+		for (uint32_t c = 0; c < 3; ++c) mean[c] += points[i][c];
+	}
+	for (uint32_t c = 0; c < 3; ++c) mean[c] /= float(count);
+
+	float cov[3][3] = {};
+	for (uint32_t i = 0; i < count; ++i) {
+		float d[3] = { points[i][0] - mean[0], points[i][1] - mean[1], points[i][2] - mean[2] };
+		for (uint32_t a = 0; a < 3; ++a) {
+			for (uint32_t b = 0; b < 3; ++b) cov[a][b] += d[a] * d[b];
+		}
+	}
+
+	//start from the largest-variance channel:
+	vec3f axis{0.0f, 0.0f, 0.0f};
+	uint32_t largest = 0;
+	for (uint32_t c = 1; c < 3; ++c) if (cov[c][c] > cov[largest][largest]) largest = c;
+	if (cov[largest][largest] <= 0.0f) return false;
+	axis[largest] = 1.0f;
+
+	for (uint32_t iter = 0; iter < 8; ++iter) {
+		vec3f next{0.0f, 0.0f, 0.0f};
+		for (uint32_t a = 0; a < 3; ++a) {
+			for (uint32_t b = 0; b < 3; ++b) next[a] += cov[a][b] * axis[b];
+		}
+		float len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		if (len <= 0.0f) break;
+		for (uint32_t c = 0; c < 3; ++c) axis[c] = next[c] / len;
+	}
+
+	*mean_ = mean;
+	*axis_ = axis;
+	return true;
+}
+
+//indices of the points with the smallest + largest projection onto the principal axis:
+void extremes(vec3f const *points, uint32_t count, uint32_t *lo, uint32_t *hi) {
+	*lo = *hi = 0;
+	vec3f mean, axis;
+	if (!principal_axis(points, count, &mean, &axis)) return;
+	float lo_t = INFINITY, hi_t = -INFINITY;
+	for (uint32_t i = 0; i < count; ++i) {
+		float t = (points[i][0] - mean[0]) * axis[0] + (points[i][1] - mean[1]) * axis[1] + (points[i][2] - mean[2]) * axis[2];
+		if (t < lo_t) { lo_t = t; *lo = i; }
+		if (t > hi_t) { hi_t = t; *hi = i; }
+	}
+}
+
+float distance2(vec3f const &a, vec3f const &b) {
+	return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]);
+}
+
+//little-endian bit writer for a 128-bit block:
+struct Bits {
+	uint8_t *out;
+	uint32_t at = 0;
+	void put(uint32_t value, uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i, ++at) {
+			if ((value >> i) & 1) out[at / 8] |= uint8_t(1 << (at % 8));
+		}
+	}
+};
+
+//float (>= 0) -> half-float bits, clamped to the largest finite half:
+uint16_t half_bits(float f) {
+	if (!(f > 0.0f)) return 0; //(also catches NaN)
+	if (f >= 65504.0f) return 0x7bff;
+	uint32_t bits;
+	std::memcpy(&bits, &f, 4);
+	int32_t exp = int32_t((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mant = bits & 0x7fffff;
+	if (exp <= 0) { //half subnormal
+		if (exp < -10) return 0;
+		mant |= 0x800000;
+		uint32_t shift = uint32_t(14 - exp);
+		return uint16_t((mant >> shift) + ((mant >> (shift - 1)) & 1));
+	}
+	uint32_t h = (uint32_t(exp) << 10) | (mant >> 13);
+	h += (mant >> 12) & 1; //(round; a carry into the exponent is still correct)
+	return uint16_t(std::min(h, 0x7bffu));
+}
+
+//BC6H (unsigned) endpoint dequantization for 10-bit endpoints:
+int32_t bc6h_unquantize(int32_t x) {
+	if (x == 0) return 0;
+	if (x == 1023) return 0xffff;
+	return ((x << 16) + 0x8000) >> 10;
+}
+
+constexpr int32_t BC6HWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+//gather one 4x4 block, repeating the last row / column past the edge of the image:
+template< typename T, uint32_t N >
+void gather(uint32_t width, uint32_t height, T const *data, uint32_t bx, uint32_t by, T *block) {
+	for (uint32_t y = 0; y < 4; ++y) {
+		uint32_t sy = std::min(by * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; ++x) {
+			uint32_t sx = std::min(bx * 4 + x, width - 1);
+			std::memcpy(block + (y * 4 + x) * N, data + (size_t(sy) * width + sx) * N, sizeof(T) * N);
+		}
+	}
+}
+
+template< typename T, uint32_t N >
+std::vector< uint8_t > compress(uint32_t width, uint32_t height, T const *data, uint32_t block_bytes, void (*encode)(T const *, uint8_t *)) {
+	uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+	std::vector< uint8_t > out(size_t(blocks_x) * blocks_y * block_bytes);
+	T block[16 * N];
+	for (uint32_t by = 0; by < blocks_y; ++by) {
+		for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+			gather< T, N >(width, height, data, bx, by, block);
+			encode(block, out.data() + (size_t(by) * blocks_x + bx) * block_bytes);
+		}
+	}
+	return out;
+}
+
+} //namespace
+
+void BlockCompress::bc6h_block(float const rgb[16 * 3], uint8_t out[16]) {
+	//work in the space the hardware interpolates in, where half-float bits h are u = h * 64 / 31:
+	vec3f points[16];
+	for (uint32_t i = 0; i < 16; ++i) {
+		for (uint32_t c = 0; c < 3; ++c) points[i][c] = float(half_bits(rgb[3 * i + c])) * 64.0f / 31.0f;
+	}
+
+	uint32_t lo, hi;
+	extremes(points, 16, &lo, &hi);
+	int32_t endpoints[2][3];
+	for (uint32_t c = 0; c < 3; ++c) {
+		endpoints[0][c] = std::clamp(int32_t(std::lround((points[lo][c] - 32.0f) / 64.0f)), 0, 1023);
+		endpoints[1][c] = std::clamp(int32_t(std::lround((points[hi][c] - 32.0f) / 64.0f)), 0, 1023);
+	}
+
+	float palette[16][3];
+	for (uint32_t c = 0; c < 3; ++c) {
+		int32_t a = bc6h_unquantize(endpoints[0][c]), b = bc6h_unquantize(endpoints[1][c]);
+		for (uint32_t w = 0; w < 16; ++w) {
+			palette[w][c] = float(((64 - BC6HWeights[w]) * a + BC6HWeights[w] * b + 32) >> 6);
+		}
+	}
+
+	uint32_t indices[16];
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t best = 0;
+		float best_dis = INFINITY;
+		for (uint32_t w = 0; w < 16; ++w) {
+			float dis = distance2(points[i], vec3f{palette[w][0], palette[w][1], palette[w][2]});
+			if (dis < best_dis) { best = w; best_dis = dis; }
+		}
+		indices[i] = best;
+	}
+
+	//the first index is stored with only 3 bits, so it must be < 8; the palette is symmetric, so swap to make it so:
+	if (indices[0] >= 8) {
+		for (uint32_t c = 0; c < 3; ++c) std::swap(endpoints[0][c], endpoints[1][c]);
+		for (uint32_t i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+	}
+
+	std::memset(out, 0, 16);
+	Bits bits{ .out = out };
+	bits.put(0x03, 5); //mode 11
+	for (uint32_t e = 0; e < 2; ++e) {
+		for (uint32_t c = 0; c < 3; ++c) bits.put(uint32_t(endpoints[e][c]), 10);
+	}
+	bits.put(indices[0], 3);
+	for (uint32_t i = 1; i < 16; ++i) bits.put(indices[i], 4);
+}
+
+std::vector< uint8_t > BlockCompress::rgba8_blocks(uint32_t width, uint32_t height, uint8_t const *rgba, uint32_t block_bytes, void (*encode)(uint8_t const rgba[16 * 4], uint8_t *out)) {
+	return compress< uint8_t, 4 >(width, height, rgba, block_bytes, encode);
+}
+
+std::vector< uint8_t > BlockCompress::bc6h(uint32_t width, uint32_t height, float const *rgb) {
+	return compress< float, 3 >(width, height, rgb, 16, bc6h_block);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+//Block compression (BCn) helpers used by the `bake` tool.
+// - BC1 / BC3 / BC5 blocks come from stb_dxt (see bake.cpp); rgba8_blocks() feeds it whole images
+// - BC6H (unsigned), which stb_dxt doesn't do: mode 11 only (one region, 10-bit endpoints)
+//
+// Images are compressed 4x4 block at a time; partial blocks at the edges repeat the last row / column.
+// Output is blocks in row-major order, which is also the layout Vulkan expects for a BCn image level.
+
+#include <cstdint>
+#include <vector>
+
+namespace BlockCompress {
+	//single blocks; texels are 16 entries in row-major order:
+	void bc6h_block(float const rgb[16 * 3], uint8_t out[16]); //(negative values clamp to zero)
+
+	//whole images (RGBA8 or RGB float, row-major, no padding):
+	// rgba8_blocks calls 'encode' on each 4x4 block, which writes block_bytes to 'out'
+	std::vector< uint8_t > rgba8_blocks(uint32_t width, uint32_t height, uint8_t const *rgba, uint32_t block_bytes, void (*encode)(uint8_t const rgba[16 * 4], uint8_t *out));
+	std::vector< uint8_t > bc6h(uint32_t width, uint32_t height, float const *rgb);
+}
@@ -6,10 +6,13 @@
 
 #include <vulkan/utility/vk_format_utils.h>
 
+#include <algorithm>
 #include <utility>
 #include <cassert>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 Helpers::Allocation::Allocation(Allocation &&from) {
 	assert(handle == VK_NULL_HANDLE && offset == 0 && size == 0 && mapped == nullptr);
@@ -41,40 +44,121 @@ Helpers::Allocation::~Allocation() {
 }
 
 //----------------------------
-Helpers::Allocation Helpers::allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type_index, MapFlag map) {
+Helpers::Allocation Helpers::allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type_index, MapFlag map, ResourceTiling tiling) {
 	Helpers::Allocation allocation;
 
-	VkMemoryAllocateInfo alloc_info {
-		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-		.allocationSize = size,
-		.memoryTypeIndex = memory_type_index
-	};
-	VK(vkAllocateMemory(rtg.device, &alloc_info, nullptr, &allocation.handle));
+	//blocks are at most 1/8 of their heap, so small heaps (e.g., a 256MB device-local + host-visible window) don't fill up with one block:
+	VkMemoryHeap const &heap = memory_properties.memoryHeaps[memory_properties.memoryTypes[memory_type_index].heapIndex];
+	VkDeviceSize block_size = std::min(MemoryBlockSize, heap.size / 8);
+
+	//look for room in an existing block:
+	MemoryBlock *block = nullptr;
+	VkDeviceSize offset = 0;
+	if (size <= block_size / 2) {
+		for (auto const &b : memory_blocks) {
+			if (b->dedicated || b->memory_type_index != memory_type_index || b->tiling != tiling) continue;
+			if (b->ranges.allocate(size, alignment, &offset)) {
+				block = b.get();
+				break;
+			}
+		}
+	}
+
+	//...or make a new one (allocations too big to share a block get a dedicated one):
+	if (!block) {
+		bool dedicated = (size > block_size / 2);
+		VkMemoryAllocateInfo alloc_info {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.allocationSize = (dedicated ? size : block_size),
+			.memoryTypeIndex = memory_type_index
+		};
+		VkDeviceMemory handle = VK_NULL_HANDLE;
+		VK(vkAllocateMemory(rtg.device, &alloc_info, nullptr, &handle));
+
+		memory_blocks.emplace_back(new MemoryBlock{
+			.handle = handle,
+			.memory_type_index = memory_type_index,
+			.tiling = tiling,
+			.dedicated = dedicated,
+			.mapped = nullptr,
+			.ranges = SubAllocator(alloc_info.allocationSize),
+		});
+		block = memory_blocks.back().get();
+		if (!block->ranges.allocate(size, alignment, &offset)) {
+			throw std::runtime_error("Failed to sub-allocate " + std::to_string(size) + " bytes from a fresh memory block.");
+		}
+	}
 
+	allocation.handle = block->handle;
 	allocation.size = size;
-	allocation.offset = 0;
+	allocation.offset = offset;
 
 	if(map == Mapped) {
-		VK(vkMapMemory(rtg.device, allocation.handle, 0, allocation.size, 0, &allocation.mapped));
+		if (block->mapped == nullptr) {
+			VK(vkMapMemory(rtg.device, block->handle, 0, VK_WHOLE_SIZE, 0, &block->mapped));
+		}
+		allocation.mapped = block->mapped;
 	}
 	return allocation;
 }
 
-Helpers::Allocation Helpers::allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags properties, MapFlag map) {
-	return allocate(requirements.size, requirements.alignment, find_memory_type(requirements.memoryTypeBits, properties), map);
+Helpers::Allocation Helpers::allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags properties, MapFlag map, ResourceTiling tiling) {
+	return allocate(requirements.size, requirements.alignment, find_memory_type(requirements.memoryTypeBits, properties), map, tiling);
 }
 
 void Helpers::free(Allocation &&allocation) {
-	if(allocation.mapped != nullptr) {
-		vkUnmapMemory(rtg.device, allocation.handle);
-		allocation.mapped = nullptr;
+	if (allocation.handle != VK_NULL_HANDLE) {
+		auto found = std::find_if(memory_blocks.begin(), memory_blocks.end(), [&](std::unique_ptr< MemoryBlock > const &b) {
+			return b->handle == allocation.handle;
+		});
+		if (found == memory_blocks.end()) {
+			throw std::runtime_error("Freeing an allocation that isn't in any memory block.");
+		}
+		MemoryBlock &block = **found;
+		block.ranges.free(allocation.offset, allocation.size);
+
+		//release empty blocks, but keep one (shared) empty block per memory type + tiling around to avoid churn:
+		if (block.ranges.empty()) {
+			bool release = block.dedicated || std::any_of(memory_blocks.begin(), memory_blocks.end(), [&](std::unique_ptr< MemoryBlock > const &b) {
+				return b.get() != &block && !b->dedicated && b->memory_type_index == block.memory_type_index && b->tiling == block.tiling && b->ranges.empty();
+			});
+			if (release) {
+				if (block.mapped != nullptr) vkUnmapMemory(rtg.device, block.handle);
+				vkFreeMemory(rtg.device, block.handle, nullptr);
+				memory_blocks.erase(found);
+			}
+		}
 	}
 
-	vkFreeMemory(rtg.device, allocation.handle, nullptr);
-
 	allocation.handle = VK_NULL_HANDLE;
 	allocation.offset = 0;
 	allocation.size = 0;
+	allocation.mapped = nullptr;
+}
+
+Helpers::MemoryStats Helpers::memory_stats() const {
+	MemoryStats stats;
+	VkDeviceSize free_bytes = 0;
+	VkDeviceSize largest_free_bytes = 0;
+	for (auto const &block : memory_blocks) {
+		stats.blocks += 1;
+		stats.allocations += block->ranges.allocations;
+		stats.block_bytes += block->ranges.size;
+		stats.used_bytes += block->ranges.used;
+		if (!block->dedicated) {
+			free_bytes += block->ranges.size - block->ranges.used;
+			largest_free_bytes += block->ranges.largest_free();
+		}
+	}
+	if (free_bytes > 0) stats.fragmentation = 1.0f - float(double(largest_free_bytes) / double(free_bytes));
+	return stats;
+}
+
+void Helpers::print_memory_stats() const {
+	MemoryStats stats = memory_stats();
+	std::cout << "Device memory: " << stats.allocations << " allocations using " << (stats.used_bytes >> 10) << " kB of "
+	          << stats.blocks << " blocks (" << (stats.block_bytes >> 10) << " kB); free space "
+	          << int(stats.fragmentation * 100.0f + 0.5f) << "% fragmented." << std::endl;
 }
 
 //----------------------------
@@ -101,6 +185,38 @@ Helpers::AllocatedBuffer Helpers::create_buffer(VkDeviceSize size, VkBufferUsage
 	return buffer;
 }
 
+Helpers::AllocatedBuffer Helpers::create_dynamic_buffer(VkDeviceSize size, VkBufferUsageFlags usage) {
+	AllocatedBuffer buffer;
+	VkBufferCreateInfo create_info {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = size,
+		.usage = usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	};
+	VK(vkCreateBuffer(rtg.device, &create_info, nullptr, &buffer.handle));
+	buffer.size = size;
+
+	VkMemoryRequirements req;
+	vkGetBufferMemoryRequirements(rtg.device, buffer.handle, &req);
+
+	//device-local if possible (for this buffer's allowed memory types), so GPU reads don't cross the bus:
+	VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkMemoryPropertyFlags properties = host;
+	if (has_device_local_host_visible) {
+		for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+			VkMemoryPropertyFlags flags = memory_properties.memoryTypes[i].propertyFlags;
+			if ((req.memoryTypeBits & (1 << i)) != 0 && (flags & (host | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == (host | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+				properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+				break;
+			}
+		}
+	}
+
+	buffer.allocation = allocate(req, properties, Mapped);
+	VK(vkBindBufferMemory(rtg.device, buffer.handle, buffer.allocation.handle, buffer.allocation.offset));
+	return buffer;
+}
+
 void Helpers::destroy_buffer(AllocatedBuffer &&buffer) {
 	//refsol::Helpers_destroy_buffer(rtg, &buffer);
 	vkDestroyBuffer(rtg.device, buffer.handle, nullptr);
@@ -110,12 +226,13 @@ void Helpers::destroy_buffer(AllocatedBuffer &&buffer) {
 }
 
 
-Helpers::AllocatedImage Helpers::create_image(VkExtent2D const &extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, MapFlag map, VkImageCreateFlags createFlags, uint32_t arrayLayers) {
+Helpers::AllocatedImage Helpers::create_image(VkExtent2D const &extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, MapFlag map, VkImageCreateFlags createFlags, uint32_t arrayLayers, uint32_t mipLevels) {
 	AllocatedImage image;
 	//refsol::Helpers_create_image(rtg, extent, format, tiling, usage, properties, (map == Mapped), &image);
 	image.extent = extent;
 	image.format = format;
     image.arrayLayers = arrayLayers;
+	image.mipLevels = mipLevels;
 
 	VkImageCreateInfo create_info {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -127,7 +244,7 @@ Helpers::AllocatedImage Helpers::create_image(VkExtent2D const &extent, VkFormat
 			.height = extent.height,
 			.depth = 1
 		},
-		.mipLevels = 1,
+		.mipLevels = mipLevels,
 		.arrayLayers = arrayLayers,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.tiling = tiling,
@@ -138,7 +255,7 @@ Helpers::AllocatedImage Helpers::create_image(VkExtent2D const &extent, VkFormat
 	VK(vkCreateImage(rtg.device, &create_info, nullptr, &image.handle));
 	VkMemoryRequirements req;
 	vkGetImageMemoryRequirements(rtg.device, image.handle, &req);
-	image.allocation = allocate(req, properties, map);
+	image.allocation = allocate(req, properties, map, (tiling == VK_IMAGE_TILING_OPTIMAL ? Optimal : Linear));
 
 	VK(vkBindImageMemory(rtg.device, image.handle, image.allocation.handle, image.allocation.offset));
 	return image;
@@ -153,62 +270,196 @@ void Helpers::destroy_image(AllocatedImage &&image) {
 	this->free(std::move(image.allocation));
 }
 
-//----------------------------
+uint32_t Helpers::full_mip_levels(VkExtent2D const &extent) {
+	uint32_t levels = 1;
+	for (uint32_t size = std::max(extent.width, extent.height); size > 1; size /= 2) {
+		levels += 1;
+	}
+	return levels;
+}
 
-void Helpers::transfer_to_buffer(void const *data, size_t size, AllocatedBuffer &target) {
-	//refsol::Helpers_transfer_to_buffer(rtg, data, size, &target);
+Helpers::RenderTargetPool Helpers::create_render_target_pool(std::vector< RenderTarget > const &targets) {
+	RenderTargetPool pool;
+	pool.targets = targets;
+	if (pool.targets.empty()) return pool;
+
+	//create the images and figure out what memory they can all share:
+	std::vector< AliasRange > ranges;
+	ranges.reserve(pool.targets.size());
+	uint32_t type_bits = ~0u;
+	for (RenderTarget &target : pool.targets) {
+		if (target.first_pass > target.last_pass) {
+			throw std::runtime_error("Render target is used from pass " + std::to_string(target.first_pass) + " to earlier pass " + std::to_string(target.last_pass) + ".");
+		}
+		VkImageCreateInfo create_info{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.imageType = VK_IMAGE_TYPE_2D,
+			.format = target.format,
+			.extent{
+				.width = target.extent.width,
+				.height = target.extent.height,
+				.depth = 1
+			},
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VK_IMAGE_TILING_OPTIMAL,
+			.usage = target.usage,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+		VK(vkCreateImage(rtg.device, &create_info, nullptr, &target.handle));
+
+		VkMemoryRequirements req;
+		vkGetImageMemoryRequirements(rtg.device, target.handle, &req);
+		type_bits &= req.memoryTypeBits;
+		ranges.emplace_back(AliasRange{
+			.size = req.size,
+			.alignment = req.alignment,
+			.first = target.first_pass,
+			.last = target.last_pass,
+		});
+		pool.unaliased_bytes += req.size;
+	}
 
-	//NOTE: this function isn't for performant transfers:
-	AllocatedBuffer transfer_src = create_buffer(
-		size,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		Helpers::Mapped
-	);
+	std::vector< VkDeviceSize > offsets = alias_offsets(ranges, &pool.peak_bytes);
+	VkDeviceSize alignment = 1;
+	for (AliasRange const &range : ranges) {
+		alignment = std::max(alignment, range.alignment);
+	}
+	pool.allocation = allocate(pool.peak_bytes, alignment, find_memory_type(type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), Unmapped, Optimal);
 
-	//Copy data to transfer data
-	std::memcpy(transfer_src.allocation.data(), data, size);
+	for (uint32_t i = 0; i < pool.targets.size(); ++i) {
+		RenderTarget &target = pool.targets[i];
+		target.offset = offsets[i];
+		VK(vkBindImageMemory(rtg.device, target.handle, pool.allocation.handle, pool.allocation.offset + target.offset));
+	}
 
-	// record CPU->GPU to command buffer
-	{
-		VK(vkResetCommandBuffer(transfer_command_buffer, 0));
-		VkCommandBufferBeginInfo begin_info{
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-		};
+	return pool;
+}
 
-		VK(vkBeginCommandBuffer(transfer_command_buffer, &begin_info));
+void Helpers::destroy_render_target_pool(RenderTargetPool &&pool) {
+	for (RenderTarget &target : pool.targets) {
+		vkDestroyImage(rtg.device, target.handle, nullptr);
+		target.handle = VK_NULL_HANDLE;
+	}
+	pool.targets.clear();
+	if (pool.allocation.handle != VK_NULL_HANDLE) {
+		this->free(std::move(pool.allocation));
+	}
+	pool.peak_bytes = 0;
+	pool.unaliased_bytes = 0;
+}
 
-		VkBufferCopy copy_region{
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = size
-		};
-		vkCmdCopyBuffer(transfer_command_buffer, transfer_src.handle, target.handle, 1, &copy_region);
+std::vector< VkDeviceSize > Helpers::alias_offsets(std::vector< AliasRange > const &ranges, VkDeviceSize *total) {
+	assert(total);
+	std::vector< VkDeviceSize > offsets(ranges.size(), 0);
+	*total = 0;
+
+	//place the biggest first (they're the hardest to fit around others):
+	std::vector< uint32_t > order(ranges.size());
+	for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return ranges[a].size > ranges[b].size;
+	});
+
+	std::vector< uint32_t > placed;
+	placed.reserve(ranges.size());
+	for (uint32_t i : order) {
+		AliasRange const &range = ranges[i];
+		assert(range.alignment > 0);
+
+		//memory in use (during this range's passes) by ranges already placed, lowest first:
+		std::vector< std::pair< VkDeviceSize, VkDeviceSize > > busy;
+		for (uint32_t j : placed) {
+			if (ranges[j].last < range.first || range.last < ranges[j].first) continue;
+			busy.emplace_back(offsets[j], offsets[j] + ranges[j].size);
+		}
+		std::sort(busy.begin(), busy.end());
 
-		VK(vkEndCommandBuffer(transfer_command_buffer));
-	}
+		//lowest aligned offset that fits between (or after) them:
+		VkDeviceSize offset = 0;
+		for (auto const &[begin, end] : busy) {
+			if (offset + range.size <= begin) break;
+			offset = std::max(offset, (end + range.alignment - 1) / range.alignment * range.alignment);
+		}
 
-	//run command buffer
-	{
-		VkSubmitInfo submit_info{
-			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &transfer_command_buffer
-		};
-		VK(vkQueueSubmit(rtg.graphics_queue, 1, &submit_info, VK_NULL_HANDLE));
+		offsets[i] = offset;
+		placed.emplace_back(i);
+		*total = std::max(*total, offset + range.size);
 	}
 
-	// wait for command buffer to finish
-	VK(vkQueueWaitIdle(rtg.graphics_queue));
+	return offsets;
+}
 
-	//don't leak memory
-	destroy_buffer(std::move(transfer_src));
+//----------------------------
 
+void Helpers::transfer_to_buffer(void const *data, size_t size, AllocatedBuffer &target) {
+	//refsol::Helpers_transfer_to_buffer(rtg, data, size, &target);
+	wait_upload(upload_buffer(data, size, target));
 }
 
 void Helpers::transfer_to_image(void const *data, size_t size, AllocatedImage &target) {
 	//refsol::Helpers_transfer_to_image(rtg, data, size, &target);
+	wait_upload(upload_image(data, size, target));
+}
+
+void Helpers::transfer_to_image_levels(void const *data, size_t size, std::vector< size_t > const &level_offsets, AllocatedImage &target) {
+	wait_upload(upload_image_levels(data, size, level_offsets, target));
+}
+
+Helpers::UploadTicket Helpers::upload_buffer(void const *data, size_t size, AllocatedBuffer &target) {
+	assert(target.handle != VK_NULL_HANDLE);
+	VkBuffer source = VK_NULL_HANDLE;
+	VkDeviceSize source_offset = 0;
+	stage_upload(data, size, &source, &source_offset);
+
+	UploadBatch &batch = upload_batch();
+	bool dedicated = dedicated_transfer_queue();
+
+	VkBufferCopy copy_region{
+		.srcOffset = source_offset,
+		.dstOffset = 0,
+		.size = size
+	};
+	vkCmdCopyBuffer((dedicated ? batch.transfer_command_buffer : batch.graphics_command_buffer), source, target.handle, 1, &copy_region);
+
+	if (dedicated) {
+		//hand the buffer over to the graphics queue family (release on the transfer queue, matching acquire on the graphics queue):
+		VkBufferMemoryBarrier barrier{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = 0,
+			.srcQueueFamilyIndex = rtg.transfer_queue_family.value(),
+			.dstQueueFamilyIndex = rtg.graphics_queue_family.value(),
+			.buffer = target.handle,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		};
+		vkCmdPipelineBarrier(batch.transfer_command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, //src stage mask
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, //dst
+			0, //dependency flags
+			0, nullptr, //memory barriers
+			1, &barrier, //buffer memory barriers
+			0, nullptr //image memory barriers
+		);
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		vkCmdPipelineBarrier(batch.graphics_command_buffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, //src stage mask
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, //dst
+			0, //dependency flags
+			0, nullptr, //memory barriers
+			1, &barrier, //buffer memory barriers
+			0, nullptr //image memory barriers
+		);
+	}
+
+	return finish_upload(size);
+}
+
+Helpers::UploadTicket Helpers::upload_image(void const *data, size_t size, AllocatedImage &target) {
 	assert(target.handle != VK_NULL_HANDLE);
 	//check data is the right size (support multiple array layers):
 	size_t bytes_per_block = vkuFormatTexelBlockSize(target.format);
@@ -217,33 +468,103 @@ void Helpers::transfer_to_image(void const *data, size_t size, AllocatedImage &t
 	size_t expected = size_t(target.extent.width) * size_t(target.extent.height) * bytes_per_texel * size_t(target.arrayLayers);
 	assert(size == expected);
 
-	//create a host-coherent source buffer
-	AllocatedBuffer transfer_src = create_buffer(
-		size,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		Mapped
-	);
-
-	//copy image data into the source buffer
-	std::memcpy(transfer_src.allocation.data(), data, size);
+	if (target.mipLevels > 1) {
+		//mip chain is generated with linear-filtered blits:
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(rtg.physical_device, target.format, &props);
+		VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		if ((props.optimalTilingFeatures & needed) != needed) {
+			throw std::runtime_error(std::string("Can't generate mipmaps for format ") + string_VkFormat(target.format) + " (no linear-filtered blits).");
+		}
+	}
 
-	//begin recording a command buffer
-	{
-		VK(vkResetCommandBuffer(transfer_command_buffer, 0));
-		VkCommandBufferBeginInfo begin_info{
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	//copy the source buffer to level 0 of each array layer:
+	size_t layer_size = target.extent.width * target.extent.height * bytes_per_texel;
+
+	std::vector<VkBufferImageCopy> regions;
+	regions.reserve(target.arrayLayers);
+	for (uint32_t layer = 0; layer < target.arrayLayers; ++layer) {
+		VkBufferImageCopy region{
+			.bufferOffset = VkDeviceSize(layer) * VkDeviceSize(layer_size),
+			.bufferRowLength = target.extent.width,
+			.bufferImageHeight = target.extent.height,
+			.imageSubresource{
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = layer,
+				.layerCount = 1,
+			},
+			.imageOffset{ .x = 0, .y = 0, .z = 0 },
+			.imageExtent{
+				.width = target.extent.width,
+				.height = target.extent.height,
+				.depth = 1
+			},
 		};
+		regions.push_back(region);
+	}
+
+	return upload_image_regions(data, size, std::move(regions), true, target);
+}
+
+Helpers::UploadTicket Helpers::upload_image_levels(void const *data, size_t size, std::vector< size_t > const &level_offsets, AllocatedImage &target) {
+	assert(target.handle != VK_NULL_HANDLE);
+	if (level_offsets.size() != target.mipLevels) {
+		throw std::runtime_error("Have " + std::to_string(level_offsets.size()) + " levels of data for an image with " + std::to_string(target.mipLevels) + " mip levels.");
+	}
+
+	//level sizes are in whole texel blocks (so this works for block-compressed formats):
+	VkExtent3D block = vkuFormatTexelBlockExtent(target.format);
+	size_t bytes_per_block = vkuFormatTexelBlockSize(target.format);
+
+	std::vector< VkBufferImageCopy > regions;
+	regions.reserve(size_t(target.mipLevels) * target.arrayLayers);
+	for (uint32_t level = 0; level < target.mipLevels; ++level) {
+		uint32_t width = std::max(1u, target.extent.width >> level);
+		uint32_t height = std::max(1u, target.extent.height >> level);
+		size_t layer_size = size_t((width + block.width - 1) / block.width) * size_t((height + block.height - 1) / block.height) * bytes_per_block;
+		if (level_offsets[level] + layer_size * target.arrayLayers > size) {
+			throw std::runtime_error("Mip level " + std::to_string(level) + " runs past the end of the image data.");
+		}
+		for (uint32_t layer = 0; layer < target.arrayLayers; ++layer) {
+			regions.emplace_back(VkBufferImageCopy{
+				.bufferOffset = VkDeviceSize(level_offsets[level] + layer * layer_size),
+				.bufferRowLength = 0, //(tightly packed)
+				.bufferImageHeight = 0,
+				.imageSubresource{
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.mipLevel = level,
+					.baseArrayLayer = layer,
+					.layerCount = 1,
+				},
+				.imageOffset{ .x = 0, .y = 0, .z = 0 },
+				.imageExtent{ .width = width, .height = height, .depth = 1 },
+			});
+		}
+	}
+
+	return upload_image_regions(data, size, std::move(regions), false, target);
+}
 
-		VK(vkBeginCommandBuffer(transfer_command_buffer, &begin_info));
+Helpers::UploadTicket Helpers::upload_image_regions(void const *data, size_t size, std::vector< VkBufferImageCopy > regions, bool generate_mips, AllocatedImage &target) {
+	VkBuffer source = VK_NULL_HANDLE;
+	VkDeviceSize source_offset = 0;
+	stage_upload(data, size, &source, &source_offset);
+	for (VkBufferImageCopy &region : regions) {
+		region.bufferOffset += source_offset;
 	}
 
+	UploadBatch &batch = upload_batch();
+	bool dedicated = dedicated_transfer_queue();
+	//copies go on the transfer queue if there's a dedicated one; blits and the rest always go on the graphics queue:
+	VkCommandBuffer copy_command_buffer = (dedicated ? batch.transfer_command_buffer : batch.graphics_command_buffer);
+	VkCommandBuffer command_buffer = batch.graphics_command_buffer;
+
 	//put the receiving image in destination-optimal layout
 	VkImageSubresourceRange whole_image{
 			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
 			.baseMipLevel = 0,
-			.levelCount = 1,
+			.levelCount = target.mipLevels,
 			.baseArrayLayer = 0,
 			.layerCount = target.arrayLayers,
 	};
@@ -260,7 +581,7 @@ void Helpers::transfer_to_image(void const *data, size_t size, AllocatedImage &t
 			.subresourceRange = whole_image,
 		};
 
-		vkCmdPipelineBarrier(transfer_command_buffer,
+		vkCmdPipelineBarrier(copy_command_buffer,
 			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, //src stage mask
 			VK_PIPELINE_STAGE_TRANSFER_BIT, //dst
 			0, //dependency flags
@@ -270,88 +591,355 @@ void Helpers::transfer_to_image(void const *data, size_t size, AllocatedImage &t
 		);
 	}
 
-	//copy the source buffer to the image (support multiple array layers)
-	{
-		size_t layer_size = target.extent.width * target.extent.height * bytes_per_texel;
+	//copy the source buffer to the image:
+	vkCmdCopyBufferToImage(
+		copy_command_buffer,
+		source,
+		target.handle,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		uint32_t(regions.size()), regions.data()
+	);
 
-		std::vector<VkBufferImageCopy> regions;
-		regions.reserve(target.arrayLayers);
-		for (uint32_t layer = 0; layer < target.arrayLayers; ++layer) {
-			VkBufferImageCopy region{
-				.bufferOffset = VkDeviceSize(layer) * VkDeviceSize(layer_size),
-				.bufferRowLength = target.extent.width,
-				.bufferImageHeight = target.extent.height,
-				.imageSubresource{
-					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-					.mipLevel = 0,
-					.baseArrayLayer = layer,
-					.layerCount = 1,
-				},
-				.imageOffset{ .x = 0, .y = 0, .z = 0 },
-				.imageExtent{
-					.width = target.extent.width,
-					.height = target.extent.height,
-					.depth = 1
-				},
-			};
-			regions.push_back(region);
-		}
+	uint32_t generated_levels = (generate_mips ? target.mipLevels : 1);
 
-		vkCmdCopyBufferToImage(
-			transfer_command_buffer,
-			transfer_src.handle,
-			target.handle,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			uint32_t(regions.size()), regions.data()
+	if (dedicated) {
+		//hand the image over to the graphics queue family; if there's nothing left to do but sample it, the transition
+		// to shader-read-only-optimal happens as part of the handoff:
+		bool finished = (generated_levels == 1);
+		VkImageMemoryBarrier barrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = 0,
+			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.newLayout = (finished ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+			.srcQueueFamilyIndex = rtg.transfer_queue_family.value(),
+			.dstQueueFamilyIndex = rtg.graphics_queue_family.value(),
+			.image = target.handle,
+			.subresourceRange = whole_image,
+		};
+		vkCmdPipelineBarrier(copy_command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, //src stage mask
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, //dst
+			0, //dependency flags
+			0, nullptr, //memorybarries
+			0, nullptr, //buffer memory b
+			1, &barrier //image mem b
 		);
-
-		//NOTE: if had mip levels need to copy as additional regions here
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = (finished ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdPipelineBarrier(command_buffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, //src stage mask
+			(finished ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT), //dst
+			0, //dependency flags
+			0, nullptr, //memorybarries
+			0, nullptr, //buffer memory b
+			1, &barrier //image mem b
+		);
+		if (finished) return finish_upload(size);
 	}
 
-	//transition the image memory to shader-read-only-optimal layout
-	{
+	//generate the rest of the mip chain, each level blitted (with linear filtering) from the one above:
+	// afterward, levels [0, mipLevels-1) are in TRANSFER_SRC_OPTIMAL and the last level is still in TRANSFER_DST_OPTIMAL
+	for (uint32_t level = 1; level < generated_levels; ++level) {
 		VkImageMemoryBarrier barrier{
 			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
 			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
 			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
 			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
 			.image = target.handle,
-			.subresourceRange = whole_image,
+			.subresourceRange{
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.baseMipLevel = level - 1,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = target.arrayLayers,
+			},
+		};
+		vkCmdPipelineBarrier(command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, //src stage mask
+			VK_PIPELINE_STAGE_TRANSFER_BIT, //dst
+			0, //dependency flags
+			0, nullptr, //memorybarries
+			0, nullptr, //buffer memory b
+			1, &barrier //image mem b
+		);
+
+		int32_t src_width = int32_t(std::max(1u, target.extent.width >> (level - 1)));
+		int32_t src_height = int32_t(std::max(1u, target.extent.height >> (level - 1)));
+		VkImageBlit blit{
+			.srcSubresource{
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = level - 1,
+				.baseArrayLayer = 0,
+				.layerCount = target.arrayLayers,
+			},
+			.srcOffsets{ {0, 0, 0}, {src_width, src_height, 1} },
+			.dstSubresource{
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = level,
+				.baseArrayLayer = 0,
+				.layerCount = target.arrayLayers,
+			},
+			.dstOffsets{ {0, 0, 0}, {std::max(1, src_width / 2), std::max(1, src_height / 2), 1} },
+		};
+		vkCmdBlitImage(command_buffer,
+			target.handle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			target.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit,
+			VK_FILTER_LINEAR
+		);
+	}
+
+	//transition the image memory to shader-read-only-optimal layout
+	{
+		std::vector< VkImageMemoryBarrier > barriers;
+		auto to_shader_read = [&](VkAccessFlags src_access, VkImageLayout old_layout, uint32_t base_level, uint32_t level_count) {
+			barriers.emplace_back(VkImageMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.srcAccessMask = src_access,
+				.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+				.oldLayout = old_layout,
+				.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = target.handle,
+				.subresourceRange{
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = base_level,
+					.levelCount = level_count,
+					.baseArrayLayer = 0,
+					.layerCount = target.arrayLayers,
+				},
+			});
 		};
+		if (generated_levels > 1) {
+			to_shader_read(VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, target.mipLevels - 1);
+			to_shader_read(VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, target.mipLevels - 1, 1);
+		} else {
+			//(every level was copied from the buffer)
+			to_shader_read(VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, target.mipLevels);
+		}
 
 		vkCmdPipelineBarrier(
-			transfer_command_buffer, //commandBuffer
+			command_buffer, //commandBuffer
 			VK_PIPELINE_STAGE_TRANSFER_BIT, //srcStageMask
 			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, //dstStageMask
 			0, //dependencyFlags
 			0, nullptr, //memory barrier count, pointer
 			0, nullptr, //buffer memory barrier count, pointer
-			1, &barrier //image memory barrier count, pointer
+			uint32_t(barriers.size()), barriers.data() //image memory barrier count, pointer
+		);
+	}
+
+	return finish_upload(size);
+}
+
+bool Helpers::dedicated_transfer_queue() const {
+	return rtg.transfer_queue_family.value() != rtg.graphics_queue_family.value();
+}
+
+Helpers::UploadBatch &Helpers::upload_batch() {
+	if (open_batch) return *open_batch;
+
+	retire_uploads(false);
+
+	bool dedicated = dedicated_transfer_queue();
+	if (!free_batches.empty()) {
+		open_batch = std::move(free_batches.back());
+		free_batches.pop_back();
+	} else {
+		open_batch.reset(new UploadBatch);
+		VkCommandBufferAllocateInfo alloc_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.commandPool = upload_graphics_command_pool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = 1,
+		};
+		VK(vkAllocateCommandBuffers(rtg.device, &alloc_info, &open_batch->graphics_command_buffer));
+		if (dedicated) {
+			alloc_info.commandPool = upload_transfer_command_pool;
+			VK(vkAllocateCommandBuffers(rtg.device, &alloc_info, &open_batch->transfer_command_buffer));
+
+			VkSemaphoreCreateInfo semaphore_info{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			};
+			VK(vkCreateSemaphore(rtg.device, &semaphore_info, nullptr, &open_batch->copied));
+		}
+		VkFenceCreateInfo fence_info{
+			.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		};
+		VK(vkCreateFence(rtg.device, &fence_info, nullptr, &open_batch->done));
+	}
+
+	UploadBatch &batch = *open_batch;
+	batch.ticket = next_upload_ticket++;
+	batch.staged = 0;
+
+	VkCommandBufferBeginInfo begin_info{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	VK(vkResetCommandBuffer(batch.graphics_command_buffer, 0));
+	VK(vkBeginCommandBuffer(batch.graphics_command_buffer, &begin_info));
+	if (dedicated) {
+		VK(vkResetCommandBuffer(batch.transfer_command_buffer, 0));
+		VK(vkBeginCommandBuffer(batch.transfer_command_buffer, &begin_info));
+	}
+
+	return batch;
+}
+
+void Helpers::stage_upload(void const *data, size_t size, VkBuffer *buffer, VkDeviceSize *offset) {
+	assert(buffer && offset);
+
+	//big uploads get a staging buffer of their own (kept until their batch is done):
+	if (size > UploadStagingSize / 2) {
+		AllocatedBuffer oversized = create_buffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			Mapped
+		);
+		std::memcpy(oversized.allocation.data(), data, size);
+		*buffer = oversized.handle;
+		*offset = 0;
+		upload_batch().oversized.emplace_back(std::move(oversized));
+		return;
+	}
+
+	//(16 is a multiple of the texel block size of every format uploaded here, as copies to images need)
+	constexpr uint64_t Alignment = 16;
+	while (true) {
+		uint64_t begin = (upload_staging_head + Alignment - 1) / Alignment * Alignment;
+		//don't let data wrap around the end of the ring:
+		if (size > 0 && begin / UploadStagingSize != (begin + size - 1) / UploadStagingSize) {
+			begin = (begin / UploadStagingSize + 1) * UploadStagingSize;
+		}
+		if (begin + size - upload_staging_tail <= UploadStagingSize) {
+			upload_staging_head = begin + size;
+			std::memcpy(reinterpret_cast< char * >(upload_staging.allocation.data()) + begin % UploadStagingSize, data, size);
+			*buffer = upload_staging.handle;
+			*offset = begin % UploadStagingSize;
+			return;
+		}
+
+		//ring is full, so wait for the oldest batch to free up some space (submitting the open batch if that's all there is):
+		if (submitted_batches.empty()) flush_uploads();
+		if (submitted_batches.empty()) {
+			throw std::runtime_error("Upload staging ring is full with no batches in flight.");
+		}
+		retire_uploads(true);
+	}
+}
+
+Helpers::UploadTicket Helpers::finish_upload(size_t size) {
+	assert(open_batch);
+	open_batch->staged += size;
+	UploadTicket ticket = open_batch->ticket;
+	if (open_batch->staged >= UploadBatchBytes) flush_uploads();
+	return ticket;
+}
+
+void Helpers::flush_uploads() {
+	if (!open_batch) return;
+
+	std::unique_ptr< UploadBatch > batch = std::move(open_batch);
+	batch->staging_end = upload_staging_head;
+
+	bool dedicated = dedicated_transfer_queue();
+	if (dedicated) {
+		VK(vkEndCommandBuffer(batch->transfer_command_buffer));
+		VkSubmitInfo submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &batch->transfer_command_buffer,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &batch->copied,
+		};
+		VK(vkQueueSubmit(rtg.transfer_queue, 1, &submit_info, VK_NULL_HANDLE));
+	}
+
+	//make everything written here (e.g., buffer copies) visible to whatever the graphics queue runs next:
+	{
+		VkMemoryBarrier barrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+		};
+		vkCmdPipelineBarrier(batch->graphics_command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, //src stage mask
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, //dst
+			0, //dependency flags
+			1, &barrier, //memory barriers
+			0, nullptr, //buffer memory barriers
+			0, nullptr //image memory barriers
 		);
 	}
 
-	//end and submit the command buffer
 	{
-		VK(vkEndCommandBuffer(transfer_command_buffer));
+		VK(vkEndCommandBuffer(batch->graphics_command_buffer));
+		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 		VkSubmitInfo submit_info{
 			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.waitSemaphoreCount = (dedicated ? 1u : 0u),
+			.pWaitSemaphores = (dedicated ? &batch->copied : nullptr),
+			.pWaitDstStageMask = (dedicated ? &wait_stage : nullptr),
 			.commandBufferCount = 1,
-			.pCommandBuffers = &transfer_command_buffer
+			.pCommandBuffers = &batch->graphics_command_buffer,
 		};
-		VK(vkQueueSubmit(rtg.graphics_queue, 1, &submit_info, VK_NULL_HANDLE));	
+		VK(vkQueueSubmit(rtg.graphics_queue, 1, &submit_info, batch->done));
 	}
 
-	//wait for command buffer to finish executing
-	VK(vkQueueWaitIdle(rtg.graphics_queue));
+	submitted_batches.emplace_back(std::move(batch));
+}
+
+void Helpers::retire_uploads(bool wait_oldest) {
+	//batches finish in submission order, so stop at the first one that isn't done:
+	while (!submitted_batches.empty()) {
+		UploadBatch &batch = *submitted_batches.front();
+		if (wait_oldest) {
+			VK(vkWaitForFences(rtg.device, 1, &batch.done, VK_TRUE, UINT64_MAX));
+			wait_oldest = false;
+		} else {
+			VkResult status = vkGetFenceStatus(rtg.device, batch.done);
+			if (status == VK_NOT_READY) break;
+			VK(status);
+		}
+		VK(vkResetFences(rtg.device, 1, &batch.done));
+
+		for (AllocatedBuffer &oversized : batch.oversized) {
+			destroy_buffer(std::move(oversized));
+		}
+		batch.oversized.clear();
+		upload_staging_tail = batch.staging_end;
+		finished_upload_ticket = batch.ticket;
+
+		free_batches.emplace_back(std::move(submitted_batches.front()));
+		submitted_batches.erase(submitted_batches.begin());
+	}
+}
 
-	//destroy the source buffer
-	destroy_buffer(std::move(transfer_src));
+bool Helpers::upload_done(UploadTicket ticket) {
+	retire_uploads(false);
+	return finished_upload_ticket >= ticket;
 }
 
+void Helpers::wait_upload(UploadTicket ticket) {
+	if (open_batch && open_batch->ticket <= ticket) flush_uploads();
+	while (finished_upload_ticket < ticket && !submitted_batches.empty()) {
+		retire_uploads(true);
+	}
+}
 
+void Helpers::wait_uploads() {
+	flush_uploads();
+	while (!submitted_batches.empty()) {
+		retire_uploads(true);
+	}
+}
 //----------------------------
 void Helpers::print_scene_info(S72 &s72){
 	std::cout << "--- Scene Objects ---"<< std::endl;
@@ -535,8 +1123,41 @@ void Helpers::create() {
 		VK(vkAllocateCommandBuffers(rtg.device, &compute_alloc_info, &compute_command_buffer));
 	}
 
+	//command pools for batched uploads (command buffers are allocated with each batch):
+	{
+		VkCommandPoolCreateInfo upload_pool_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = rtg.graphics_queue_family.value(),
+		};
+		VK(vkCreateCommandPool(rtg.device, &upload_pool_info, nullptr, &upload_graphics_command_pool));
+		if (dedicated_transfer_queue()) {
+			upload_pool_info.queueFamilyIndex = rtg.transfer_queue_family.value();
+			VK(vkCreateCommandPool(rtg.device, &upload_pool_info, nullptr, &upload_transfer_command_pool));
+		}
+	}
+
 	vkGetPhysicalDeviceMemoryProperties(rtg.physical_device, &memory_properties);
 
+	for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+		VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		if ((memory_properties.memoryTypes[i].propertyFlags & wanted) == wanted) {
+			has_device_local_host_visible = true;
+			if (rtg.configuration.debug) {
+				VkMemoryHeap const &heap = memory_properties.memoryHeaps[memory_properties.memoryTypes[i].heapIndex];
+				std::cout << "Dynamic buffers will use device-local, host-visible memory type " << i << " (heap of " << (heap.size >> 20) << " MB)." << std::endl;
+			}
+			break;
+		}
+	}
+
+	upload_staging = create_buffer(
+		UploadStagingSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		Mapped
+	);
+
 	if(rtg.configuration.debug) {
 		std::cout << "Memory types: \n";
 		for(uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
@@ -553,6 +1174,26 @@ void Helpers::create() {
 }
 
 void Helpers::destroy() {
+	//batched uploads:
+	wait_uploads();
+	for (auto &batch : free_batches) {
+		if (batch->copied != VK_NULL_HANDLE) vkDestroySemaphore(rtg.device, batch->copied, nullptr);
+		vkDestroyFence(rtg.device, batch->done, nullptr);
+		//(command buffers are freed with their pools)
+	}
+	free_batches.clear();
+	if (upload_staging.handle != VK_NULL_HANDLE) {
+		destroy_buffer(std::move(upload_staging));
+	}
+	if (upload_transfer_command_pool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(rtg.device, upload_transfer_command_pool, nullptr);
+		upload_transfer_command_pool = VK_NULL_HANDLE;
+	}
+	if (upload_graphics_command_pool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(rtg.device, upload_graphics_command_pool, nullptr);
+		upload_graphics_command_pool = VK_NULL_HANDLE;
+	}
+
 	if(transfer_command_buffer != VK_NULL_HANDLE) {
 		vkFreeCommandBuffers(rtg.device, transfer_command_pool, 1, &transfer_command_buffer);
 		transfer_command_buffer = VK_NULL_HANDLE;
@@ -570,4 +1211,14 @@ void Helpers::destroy() {
 		vkDestroyCommandPool(rtg.device, compute_command_pool, nullptr);
 		compute_command_pool = VK_NULL_HANDLE;
 	}
+
+	//(everything should have been freed by now; anything left is a leak, but the memory goes back to the device either way)
+	for (auto &block : memory_blocks) {
+		if (!block->ranges.empty()) {
+			std::cerr << "Memory block still has " << block->ranges.allocations << " allocations (" << block->ranges.used << " bytes) at shutdown." << std::endl;
+		}
+		if (block->mapped != nullptr) vkUnmapMemory(rtg.device, block->handle);
+		vkFreeMemory(rtg.device, block->handle, nullptr);
+	}
+	memory_blocks.clear();
 }
@@ -4,6 +4,9 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include "SubAllocator.hpp"
+
+#include <memory>
 #include <vector>
 
 struct RTG;
@@ -33,13 +36,43 @@ struct Helpers {
 		Mapped = 1,
 	};
 
+	//what will be bound to an allocation; linear (buffers, linear-tiling images) and optimal-tiling resources
+	// get sub-allocated from separate blocks, so neighbors never need bufferImageGranularity padding:
+	enum ResourceTiling {
+		Linear = 0,
+		Optimal = 1,
+	};
+
 	//allocate requested size and alignment from a memory with the given type index:
-	Allocation allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type_index, MapFlag map = Unmapped);
+	// (sub-allocated from a large per-memory-type block; Mapped allocations share the block's persistent mapping)
+	Allocation allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type_index, MapFlag map = Unmapped, ResourceTiling tiling = Linear);
 	// works for a given VkMemoryRequirements and VkMemoryPropertyFlags:
-	Allocation allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags memory_properties, MapFlag map = Unmapped);
+	Allocation allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags memory_properties, MapFlag map = Unmapped, ResourceTiling tiling = Linear);
 	//free
 	void free(Allocation &&allocation);
 
+	//device memory blocks allocations come from:
+	static constexpr VkDeviceSize MemoryBlockSize = VkDeviceSize(64) << 20; //(smaller on small heaps; see allocate())
+	struct MemoryBlock {
+		VkDeviceMemory handle = VK_NULL_HANDLE;
+		uint32_t memory_type_index = 0;
+		ResourceTiling tiling = Linear;
+		bool dedicated = false; //holds one allocation too big to share a block; freed along with it
+		void *mapped = nullptr; //persistent mapping of the whole block, made by the first Mapped allocation
+		SubAllocator ranges;
+	};
+	std::vector< std::unique_ptr< MemoryBlock > > memory_blocks;
+
+	struct MemoryStats {
+		uint32_t blocks = 0;
+		uint32_t allocations = 0;
+		VkDeviceSize block_bytes = 0; //allocated from the device
+		VkDeviceSize used_bytes = 0; //handed out to allocations
+		float fragmentation = 0.0f; //1 - (largest free range / free bytes), over all shared blocks: 0 => free space is all in one piece per block
+	};
+	MemoryStats memory_stats() const;
+	void print_memory_stats() const;
+
 	//specializations that also create a buffer or image (respectively):
 	struct AllocatedBuffer {
 		VkBuffer handle = VK_NULL_HANDLE;
@@ -50,27 +83,119 @@ struct Helpers {
 	};
 	AllocatedBuffer create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MapFlag map = Unmapped);
 	void destroy_buffer(AllocatedBuffer &&allocated_buffer);
+	//buffer the CPU writes (e.g., every frame) and the GPU reads in place; always Mapped. Uses device-local, host-visible
+	// memory (resizable BAR, the 256MB BAR window, or unified memory) when the device has it, plain host-visible memory otherwise.
+	// NOTE: device-local mappings are usually write-combined and slow to read back, so only write (e.g., memcpy) into these:
+	AllocatedBuffer create_dynamic_buffer(VkDeviceSize size, VkBufferUsageFlags usage);
+	bool has_device_local_host_visible = false; //does any memory type have DEVICE_LOCAL + HOST_VISIBLE + HOST_COHERENT? (set in create())
 
 	struct AllocatedImage {
 		VkImage handle = VK_NULL_HANDLE;
 		VkExtent2D extent{.width = 0, .height = 0};
 		VkFormat format = VK_FORMAT_UNDEFINED;
 		uint32_t arrayLayers = 1;
+		uint32_t mipLevels = 1;
 		Allocation allocation;
 
 		//NOTE: could define default constructor, move constructor, move assignment, destructor for a bit more paranoia
 	};
-	AllocatedImage create_image(VkExtent2D const &extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, MapFlag map = Unmapped, VkImageCreateFlags createFlags = 0, uint32_t arrayLayers = 1);
+	AllocatedImage create_image(VkExtent2D const &extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, MapFlag map = Unmapped, VkImageCreateFlags createFlags = 0, uint32_t arrayLayers = 1, uint32_t mipLevels = 1);
 	void destroy_image(AllocatedImage &&allocated_image);
+	//number of levels in a full mip chain (down to 1x1) for an image of this size:
+	static uint32_t full_mip_levels(VkExtent2D const &extent);
+
+	//transient render targets: images used by only part of a frame (depth, post-processing intermediates, ...) are declared
+	// with the range of passes (in frame order) that use them, and images whose ranges don't overlap share memory.
+	// NOTE: aliased contents don't survive, so each target's first use in a frame must transition it from VK_IMAGE_LAYOUT_UNDEFINED
+	// (after a barrier covering whatever used its memory last)
+	struct RenderTarget {
+		VkExtent2D extent{.width = 0, .height = 0};
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkImageUsageFlags usage = 0;
+		uint32_t first_pass = 0; //first and last passes that use the target (inclusive)
+		uint32_t last_pass = 0;
+		VkImage handle = VK_NULL_HANDLE; //(set by create_render_target_pool)
+		VkDeviceSize offset = 0; //where in the pool's memory the image is bound
+	};
+	struct RenderTargetPool {
+		std::vector< RenderTarget > targets;
+		Allocation allocation; //shared by all the targets
+		VkDeviceSize peak_bytes = 0; //memory needed with aliasing (the most that's live at once, plus any placement slack)
+		VkDeviceSize unaliased_bytes = 0; //memory the targets would need with an allocation each
+	};
+	RenderTargetPool create_render_target_pool(std::vector< RenderTarget > const &targets);
+	void destroy_render_target_pool(RenderTargetPool &&pool);
+
+	//placement for create_render_target_pool: offsets such that ranges used by overlapping [first, last] passes don't overlap
+	// in memory (biggest first, each at the lowest offset that fits); *total is set to the bytes needed:
+	struct AliasRange {
+		VkDeviceSize size = 0;
+		VkDeviceSize alignment = 1;
+		uint32_t first = 0;
+		uint32_t last = 0;
+	};
+	static std::vector< VkDeviceSize > alias_offsets(std::vector< AliasRange > const &ranges, VkDeviceSize *total);
 	
 
 	//-----------------------
 	//CPU -> GPU data transfer:
 
-	// NOTE: synchronizes *hard* against the GPU; inefficient to use for streaming data!
+	// NOTE: synchronizes *hard* against the GPU (waits for the upload); see upload_* below to overlap uploads with other work
 	void transfer_to_buffer(void const *data, size_t size, AllocatedBuffer &target);
 	void transfer_to_image(void const *data, size_t size, AllocatedImage &image); //NOTE: image layout after call is VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-
+	// 'data' is mip level 0 (all layers); if image.mipLevels > 1 the rest of the chain is generated on the GPU with linear-filtered blits
+	// (which needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT and a format that supports linear filtering; throws otherwise)
+	//upload every mip level from data (e.g., a baked KTX2 file); level_offsets[i] is where level i starts in data,
+	// with its array layers back-to-back. Works for block-compressed formats. NOTE: layout after call is VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void transfer_to_image_levels(void const *data, size_t size, std::vector< size_t > const &level_offsets, AllocatedImage &image);
+
+	//batched uploads: data is copied into a staging ring right away (so the caller can free it on return) and the copy is
+	// recorded into the open batch, which is submitted as a whole once it holds UploadBatchBytes or on flush_uploads().
+	// Copies run on rtg.transfer_queue (with queue family ownership handed to the graphics queue after); images end up in
+	// VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. Work submitted to the graphics queue after the flush sees the data.
+	using UploadTicket = uint64_t; //batches are numbered in submission order, so a ticket is done once every ticket <= it is
+	UploadTicket upload_buffer(void const *data, size_t size, AllocatedBuffer &target);
+	UploadTicket upload_image(void const *data, size_t size, AllocatedImage &target); //(as transfer_to_image)
+	UploadTicket upload_image_levels(void const *data, size_t size, std::vector< size_t > const &level_offsets, AllocatedImage &target); //(as transfer_to_image_levels)
+	void flush_uploads(); //submit the open batch (if there is one)
+	bool upload_done(UploadTicket ticket); //(doesn't flush)
+	void wait_upload(UploadTicket ticket); //flushes, if needed, then waits for the ticket's batch
+	void wait_uploads(); //flush and wait for everything
+
+	static constexpr VkDeviceSize UploadStagingSize = VkDeviceSize(64) << 20; //staging ring; bigger uploads get their own buffer
+	static constexpr VkDeviceSize UploadBatchBytes = VkDeviceSize(16) << 20; //submit a batch once it has staged this much
+
+	struct UploadBatch {
+		UploadTicket ticket = 0;
+		VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE; //copies + ownership releases (only with a dedicated transfer queue)
+		VkCommandBuffer graphics_command_buffer = VK_NULL_HANDLE; //ownership acquires, mip generation, layout transitions (or everything)
+		VkSemaphore copied = VK_NULL_HANDLE; //transfer_command_buffer -> graphics_command_buffer
+		VkFence done = VK_NULL_HANDLE; //signaled by graphics_command_buffer
+		VkDeviceSize staged = 0; //bytes of data in this batch
+		uint64_t staging_end = 0; //staging ring position after this batch's data
+		std::vector< AllocatedBuffer > oversized; //staging for uploads too big for the ring; freed when the batch is done
+	};
+	std::unique_ptr< UploadBatch > open_batch;
+	std::vector< std::unique_ptr< UploadBatch > > submitted_batches; //(oldest first)
+	std::vector< std::unique_ptr< UploadBatch > > free_batches;
+	UploadTicket next_upload_ticket = 1;
+	UploadTicket finished_upload_ticket = 0;
+
+	AllocatedBuffer upload_staging; //ring of UploadStagingSize bytes; positions are running totals (wrapped when used)
+	uint64_t upload_staging_head = 0; //next byte to write
+	uint64_t upload_staging_tail = 0; //oldest byte still in use by a submitted batch
+
+	VkCommandPool upload_transfer_command_pool = VK_NULL_HANDLE;
+	VkCommandPool upload_graphics_command_pool = VK_NULL_HANDLE;
+
+	bool dedicated_transfer_queue() const;
+	UploadBatch &upload_batch(); //the open batch (starting one if needed)
+	//copy data into the ring (waiting for old batches if it's full) or an oversized buffer owned by the open batch:
+	void stage_upload(void const *data, size_t size, VkBuffer *buffer, VkDeviceSize *offset);
+	UploadTicket finish_upload(size_t size); //count staged bytes, flushing if the batch is big enough
+	void retire_uploads(bool wait_oldest); //recycle finished batches (optionally blocking on the oldest one first)
+
+	//the synchronous transfer_to_* functions use upload_*, but cube.cpp still records its own work here:
 	VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
 	VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
 
@@ -105,6 +230,9 @@ struct Helpers {
 	~Helpers();
 	RTG const &rtg; //remember the owning RTG object
 
+	//shared tail of upload_image / upload_image_levels: stage data, copy regions, optionally blit the rest of the mip chain, transition for sampling:
+	UploadTicket upload_image_regions(void const *data, size_t size, std::vector< VkBufferImageCopy > regions, bool generate_mips, AllocatedImage &target);
+
 	//used to synchronize create/destroy with RTG:
 	void create(); //create vulkan resources (after GPU-held handles are created)
 	void destroy(); //destroy vulkan resources (before GPU-held handles are destroyed)
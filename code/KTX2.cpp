@@ -0,0 +1,244 @@
+#include "KTX2.hpp"
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+constexpr size_t HeaderSize = 80; //identifier + header + index
+constexpr size_t LevelIndexEntrySize = 24;
+
+//Khronos data format descriptor values used below:
+constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+constexpr uint32_t KHR_DF_MODEL_BC3 = 130;
+constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+constexpr uint32_t KHR_DF_MODEL_BC6H = 133;
+constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_FLOAT = 0x80;
+
+bool is_srgb(VkFormat format) {
+	return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+}
+
+struct Out {
+	std::vector< uint8_t > bytes;
+	void u32(uint32_t v) { for (uint32_t i = 0; i < 4; ++i) bytes.emplace_back(uint8_t(v >> (8 * i))); }
+	void u64(uint64_t v) { for (uint32_t i = 0; i < 8; ++i) bytes.emplace_back(uint8_t(v >> (8 * i))); }
+	void pad(size_t alignment) { while (bytes.size() % alignment != 0) bytes.emplace_back(0); }
+	void put_u32(size_t at, uint32_t v) { for (uint32_t i = 0; i < 4; ++i) bytes[at + i] = uint8_t(v >> (8 * i)); }
+	void put_u64(size_t at, uint64_t v) { for (uint32_t i = 0; i < 8; ++i) bytes[at + i] = uint8_t(v >> (8 * i)); }
+};
+
+uint32_t get_u32(uint8_t const *at) {
+	uint32_t v = 0;
+	for (uint32_t i = 0; i < 4; ++i) v |= uint32_t(at[i]) << (8 * i);
+	return v;
+}
+uint64_t get_u64(uint8_t const *at) {
+	return uint64_t(get_u32(at)) | (uint64_t(get_u32(at + 4)) << 32);
+}
+
+//basic data format descriptor (one descriptor block):
+void write_dfd(Out &out, VkFormat format) {
+	struct Sample {
+		uint32_t bit_offset, bit_length, channel, lower, upper;
+	};
+	uint32_t model = 0;
+	std::vector< Sample > samples;
+	if (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK) {
+		model = KHR_DF_MODEL_BC1A;
+		samples = { {0, 64, 0, 0, 0xffffffff} }; //color
+	} else if (format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK) {
+		model = KHR_DF_MODEL_BC3;
+		uint32_t alpha = 15 | (is_srgb(format) ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0); //(alpha is never sRGB-encoded)
+		samples = { {0, 64, alpha, 0, 0xffffffff}, {64, 64, 0, 0, 0xffffffff} }; //alpha, color
+	} else if (format == VK_FORMAT_BC5_UNORM_BLOCK) {
+		model = KHR_DF_MODEL_BC5;
+		samples = { {0, 64, 0, 0, 0xffffffff}, {64, 64, 1, 0, 0xffffffff} }; //red, green
+	} else if (format == VK_FORMAT_BC6H_UFLOAT_BLOCK) {
+		model = KHR_DF_MODEL_BC6H;
+		samples = { {0, 128, KHR_DF_SAMPLE_DATATYPE_FLOAT, 0, 0x3f800000} }; //color, [0.0f, 1.0f] nominal range
+	} else {
+		throw std::runtime_error(std::string("KTX2 writing doesn't support format ") + string_VkFormat(format) + ".");
+	}
+
+	uint32_t block_size = 24 + 16 * uint32_t(samples.size());
+	out.u32(4 + block_size); //dfdTotalSize
+	out.u32(0); //vendorId = Khronos, descriptorType = basic
+	out.u32(2 | (block_size << 16)); //versionNumber, descriptorBlockSize
+	out.u32(model | (KHR_DF_PRIMARIES_BT709 << 8) | ((is_srgb(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+	out.u32(3 | (3 << 8)); //texelBlockDimension (minus one): 4x4x1x1
+	out.u32(KTX2::block_bytes(format)); //bytesPlane0
+	out.u32(0); //bytesPlane4-7
+	for (Sample const &s : samples) {
+		out.u32(s.bit_offset | ((s.bit_length - 1) << 16) | (s.channel << 24));
+		out.u32(0); //samplePosition
+		out.u32(s.lower);
+		out.u32(s.upper);
+	}
+}
+
+size_t level_bytes(VkFormat format, uint32_t width, uint32_t height, uint32_t faces, uint32_t level) {
+	size_t w = std::max(1u, width >> level);
+	size_t h = std::max(1u, height >> level);
+	return ((w + 3) / 4) * ((h + 3) / 4) * KTX2::block_bytes(format) * faces;
+}
+
+} //namespace
+
+uint32_t KTX2::block_bytes(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+KTX2::File KTX2::load(std::string const &path) {
+	File file;
+	file.mapped = MappedFile(path);
+	uint8_t const *data = file.mapped.data();
+	size_t size = file.mapped.size();
+
+	if (size < HeaderSize || std::memcmp(data, Identifier, sizeof(Identifier)) != 0) {
+		throw std::runtime_error("'" + path + "' is not a KTX2 file.");
+	}
+	file.format = VkFormat(get_u32(data + 12));
+	uint32_t type_size = get_u32(data + 16);
+	file.width = get_u32(data + 20);
+	file.height = get_u32(data + 24);
+	uint32_t depth = get_u32(data + 28);
+	uint32_t layers = get_u32(data + 32);
+	file.faces = get_u32(data + 36);
+	uint32_t level_count = get_u32(data + 40);
+	uint32_t supercompression = get_u32(data + 44);
+
+	uint32_t block = block_bytes(file.format);
+	if (block == 0) {
+		throw std::runtime_error("'" + path + "' has unsupported format " + string_VkFormat(file.format) + ".");
+	}
+	if (type_size != 1 || file.width == 0 || file.height == 0 || depth != 0 || layers > 1 || (file.faces != 1 && file.faces != 6) || supercompression != 0) {
+		throw std::runtime_error("'" + path + "' is not a plain 2D or cube texture.");
+	}
+	if (level_count == 0 || level_count > 32 || HeaderSize + size_t(level_count) * LevelIndexEntrySize > size) {
+		throw std::runtime_error("'" + path + "' has a bad level count (" + std::to_string(level_count) + ").");
+	}
+
+	for (uint32_t l = 0; l < level_count; ++l) {
+		uint8_t const *entry = data + HeaderSize + l * LevelIndexEntrySize;
+		uint64_t offset = get_u64(entry);
+		uint64_t length = get_u64(entry + 8);
+		if (offset > size || length > size - offset || offset % block != 0) {
+			throw std::runtime_error("'" + path + "' level " + std::to_string(l) + " is out of range or misaligned.");
+		}
+		if (length != level_bytes(file.format, file.width, file.height, file.faces, l)) {
+			throw std::runtime_error("'" + path + "' level " + std::to_string(l) + " has " + std::to_string(length) + " bytes, expected "
+				+ std::to_string(level_bytes(file.format, file.width, file.height, file.faces, l)) + ".");
+		}
+		file.levels.emplace_back(File::Level{ .offset = size_t(offset), .size = size_t(length) });
+	}
+
+	return file;
+}
+
+void KTX2::save(std::string const &path, Image const &image) {
+	if (block_bytes(image.format) == 0) {
+		throw std::runtime_error(std::string("KTX2 writing doesn't support format ") + string_VkFormat(image.format) + ".");
+	}
+	if (image.levels.empty() || (image.faces != 1 && image.faces != 6)) {
+		throw std::runtime_error("KTX2 image for '" + path + "' needs at least one level and 1 or 6 faces.");
+	}
+	for (uint32_t l = 0; l < image.levels.size(); ++l) {
+		if (image.levels[l].size() != level_bytes(image.format, image.width, image.height, image.faces, l)) {
+			throw std::runtime_error("KTX2 image for '" + path + "' has the wrong size for level " + std::to_string(l) + ".");
+		}
+	}
+
+	Out out;
+	out.bytes.insert(out.bytes.end(), Identifier, Identifier + sizeof(Identifier));
+	out.u32(uint32_t(image.format));
+	out.u32(1); //typeSize
+	out.u32(image.width);
+	out.u32(image.height);
+	out.u32(0); //pixelDepth
+	out.u32(0); //layerCount
+	out.u32(image.faces);
+	out.u32(uint32_t(image.levels.size()));
+	out.u32(0); //supercompressionScheme
+
+	//index (filled in below):
+	size_t index_at = out.bytes.size();
+	out.u32(0); out.u32(0); //dfd offset, length
+	out.u32(0); out.u32(0); //kvd offset, length
+	out.u64(0); out.u64(0); //sgd offset, length
+	size_t levels_at = out.bytes.size();
+	out.bytes.resize(out.bytes.size() + image.levels.size() * LevelIndexEntrySize, 0);
+
+	size_t dfd_at = out.bytes.size();
+	write_dfd(out, image.format);
+	out.put_u32(index_at + 0, uint32_t(dfd_at));
+	out.put_u32(index_at + 4, uint32_t(out.bytes.size() - dfd_at));
+
+	{ //key/value data: just the orientation
+		size_t kvd_at = out.bytes.size();
+		std::string key = "KTXorientation";
+		out.u32(uint32_t(key.size() + 1 + image.orientation.size() + 1));
+		out.bytes.insert(out.bytes.end(), key.begin(), key.end());
+		out.bytes.emplace_back(0);
+		out.bytes.insert(out.bytes.end(), image.orientation.begin(), image.orientation.end());
+		out.bytes.emplace_back(0);
+		out.pad(4);
+		out.put_u32(index_at + 8, uint32_t(kvd_at));
+		out.put_u32(index_at + 12, uint32_t(out.bytes.size() - kvd_at));
+	}
+
+	//level data goes smallest-first, each level aligned to the block size:
+	for (size_t l = image.levels.size(); l-- > 0; ) {
+		out.pad(16);
+		size_t at = out.bytes.size();
+		out.bytes.insert(out.bytes.end(), image.levels[l].begin(), image.levels[l].end());
+		out.put_u64(levels_at + l * LevelIndexEntrySize + 0, at);
+		out.put_u64(levels_at + l * LevelIndexEntrySize + 8, image.levels[l].size());
+		out.put_u64(levels_at + l * LevelIndexEntrySize + 16, image.levels[l].size());
+	}
+
+	//write to a temporary and rename, so a half-written file is never picked up:
+	std::string temp = path + ".tmp";
+	{
+		std::ofstream stream(temp, std::ios::binary);
+		stream.write(reinterpret_cast< char const * >(out.bytes.data()), std::streamsize(out.bytes.size()));
+		if (!stream) throw std::runtime_error("Failed to write '" + temp + "'.");
+	}
+	std::error_code ec;
+	std::filesystem::rename(temp, path, ec);
+	if (ec) throw std::runtime_error("Failed to rename '" + temp + "' to '" + path + "': " + ec.message());
+}
+
+std::string KTX2::baked_path(std::string const &source) {
+	return source + ".ktx2";
+}
+
+bool KTX2::baked_is_current(std::string const &source) {
+	std::error_code ec;
+	auto baked_time = std::filesystem::last_write_time(baked_path(source), ec);
+	if (ec) return false;
+	auto source_time = std::filesystem::last_write_time(source, ec);
+	if (ec) return true; //(source is gone; baked copy is all there is)
+	return baked_time >= source_time;
+}
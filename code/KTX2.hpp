@@ -0,0 +1,51 @@
+#pragma once
+
+//Minimal KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) reading + writing,
+// for the block-compressed textures made by the `bake` tool:
+// - 2D textures and cube maps, with any number of mip levels
+// - BC1 / BC3 / BC5 / BC6H (unsigned) formats only
+// - no supercompression, array layers, or 3D textures
+// - the data format descriptor is written for other tools' benefit, but not interpreted on load
+
+#include "MappedFile.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace KTX2 {
+	//bytes per 4x4 block for the supported formats (0 if not supported):
+	uint32_t block_bytes(VkFormat format);
+
+	//a loaded file; level data stays in the mapping:
+	struct File {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t faces = 1; //6 => cube map
+		struct Level {
+			size_t offset = 0; //bytes from the start of the file
+			size_t size = 0; //all faces of this level
+		};
+		std::vector< Level > levels; //level 0 (largest) first
+		MappedFile mapped;
+	};
+	File load(std::string const &path); //NOTE: throws on error (including level sizes that don't match the format)
+
+	//image to write; each level holds all faces back-to-back:
+	struct Image {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t faces = 1;
+		std::vector< std::vector< uint8_t > > levels; //level 0 (largest) first
+		std::string orientation = "rd"; //KTXorientation: "rd" => first row is the top, "ru" => first row is the bottom
+	};
+	void save(std::string const &path, Image const &image); //NOTE: throws on error
+
+	//where the `bake` tool puts the baked version of an image file, and whether it is at least as new as the image:
+	std::string baked_path(std::string const &source);
+	bool baked_is_current(std::string const &source);
+}
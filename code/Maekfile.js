@@ -27,6 +27,16 @@ custom_flags_and_rules();
 const common_objs = [
 	maek.CPP('Helpers.cpp'),
 	maek.CPP('RTG.cpp'),
+	maek.CPP('SubAllocator.cpp'),
+]
+
+//scene + file loading, shared by the viewer and the texture baker:
+const scene_objs = [
+	maek.CPP("sejp.cpp"),
+	maek.CPP("S72.cpp"),
+	maek.CPP("MappedFile.cpp"),
+	maek.CPP("ThreadPool.cpp"),
+	maek.CPP("KTX2.cpp"),
 ]
 
 //maek.CPP(...) builds a c++ file:
@@ -36,12 +46,17 @@ const main_objs = [
 	maek.CPP('PosColVertex.cpp'),
 	maek.CPP('PosNorTexVertex.cpp'),
 	maek.CPP('PosNorTanTexVertex.cpp'),
+	maek.CPP('PosNorTanTexPackedVertex.cpp'),
 	// maek.CPP('RTG.cpp'),
 	// maek.CPP('Helpers.cpp'),
-	maek.CPP("sejp.cpp"),
-	maek.CPP("S72.cpp"),
+	maek.CPP("MeshLoader.cpp"),
+	maek.CPP("MeshOptimizer.cpp"),
+	maek.CPP("SceneCache.cpp"),
+	maek.CPP("TextureStreamer.cpp"),
+	maek.CPP("TextureAtlas.cpp"),
 	maek.CPP("viewer.cpp"),
 	//maek.CPP('main.cpp'),
+	...scene_objs,
 	...common_objs,
 ];
 
@@ -50,6 +65,31 @@ const cube_objs = [
 	...common_objs,
 ];
 
+//offline texture baker (no Vulkan device needed):
+const bake_objs = [
+	maek.CPP('bake.cpp'),
+	maek.CPP('BlockCompress.cpp'),
+	...scene_objs,
+];
+
+//load-time benchmarks (generate their own synthetic scenes):
+const bench_meshes_objs = [
+	maek.CPP('bench-meshes.cpp'),
+	maek.CPP('MeshLoader.cpp'),
+	maek.CPP('MeshOptimizer.cpp'),
+	...scene_objs,
+];
+
+const bench_scene_objs = [
+	maek.CPP('bench-scene.cpp'),
+	...scene_objs,
+];
+
+//GPU benchmark (writes its own scene, then runs bin/viewer headless with and without --no-mipmaps):
+const bench_mipmaps_objs = [
+	maek.CPP('bench-mipmaps.cpp'),
+];
+
 //uncomment to build cube shaders and pipeline:
 const cube_shaders = [
 	maek.GLSLC('cube.comp', 'spv/cube.comp.lambertian', { GLSLCFlags:[...maek.DEFAULT_OPTIONS.GLSLCFlags, '-DLAMBERTIAN'] } ),
@@ -76,6 +116,7 @@ main_objs.push( maek.CPP('Tutorial-LinesPipeline.cpp', undefined, { depends:[...
 //uncomment to build objects shaders and pipeline:
 const objects_shaders = [
 	maek.GLSLC('objects.vert'),
+	maek.GLSLC('objects-packed.vert'),
 	maek.GLSLC('objects.frag', 'spv/objects.frag.tonemap_linear', { GLSLCFlags:[...maek.DEFAULT_OPTIONS.GLSLCFlags, '-I', 'code', '-DTONEMAP_LINEAR'] }),
 	maek.GLSLC('objects.frag', 'spv/objects.frag.tonemap_aces', { GLSLCFlags:[...maek.DEFAULT_OPTIONS.GLSLCFlags, '-I', 'code', '-DTONEMAP_ACES'] }),
 ];
@@ -99,8 +140,16 @@ const main_exe = maek.LINK([...main_objs,], 'bin/viewer');
 
 const cube_exe = maek.LINK([...cube_objs,], 'bin/cube');
 
+const bake_exe = maek.LINK([...bake_objs,], 'bin/bake');
+
+const bench_meshes_exe = maek.LINK([...bench_meshes_objs,], 'bin/bench-meshes');
+
+const bench_scene_exe = maek.LINK([...bench_scene_objs,], 'bin/bench-scene');
+
+const bench_mipmaps_exe = maek.LINK([...bench_mipmaps_objs,], 'bin/bench-mipmaps');
+
 //default targets:
-maek.TARGETS = [main_exe, cube_exe];
+maek.TARGETS = [main_exe, cube_exe, bake_exe, bench_meshes_exe, bench_scene_exe, bench_mipmaps_exe];
 
 //- - - - - - - - - - - - - - - - - - - - -
 function custom_flags_and_rules() {
@@ -129,6 +178,7 @@ function custom_flags_and_rules() {
 			`-L${GLFW_DIR}/lib`,
 			'-lX11',
 			`-lglfw3`,
+			'-pthread',
 		];
 
 	} else if (maek.OS === 'windows') {
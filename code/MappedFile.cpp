@@ -0,0 +1,103 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const &path_) : path(path_) {
+	#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open data file: " + path);
+	file_handle = file;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		close();
+		throw std::runtime_error("Failed to get size of data file: " + path);
+	}
+	length = size_t(file_size.QuadPart);
+	if (length == 0) return; //(can't map an empty file, but an empty mapping is fine)
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		close();
+		throw std::runtime_error("Failed to create mapping for data file: " + path);
+	}
+	mapping_handle = mapping;
+
+	bytes = reinterpret_cast< uint8_t const * >(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (bytes == nullptr) {
+		close();
+		throw std::runtime_error("Failed to map data file: " + path);
+	}
+	#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("Failed to open data file: " + path);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Failed to get size of data file: " + path);
+	}
+	length = size_t(st.st_size);
+	if (length == 0) {
+		::close(fd);
+		return; //(can't map an empty file, but an empty mapping is fine)
+	}
+
+	void *ptr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); //mapping keeps its own reference to the file
+	if (ptr == MAP_FAILED) {
+		length = 0;
+		throw std::runtime_error("Failed to map data file: " + path);
+	}
+	//data is read front-to-back, so let the kernel read ahead aggressively:
+	madvise(ptr, length, MADV_SEQUENTIAL);
+	bytes = reinterpret_cast< uint8_t const * >(ptr);
+	#endif
+}
+
+MappedFile::MappedFile(MappedFile &&from) {
+	*this = std::move(from);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&from) {
+	if (this == &from) return *this;
+	close();
+	std::swap(path, from.path);
+	std::swap(bytes, from.bytes);
+	std::swap(length, from.length);
+	#ifdef _WIN32
+	std::swap(file_handle, from.file_handle);
+	std::swap(mapping_handle, from.mapping_handle);
+	#endif
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+void MappedFile::close() {
+	#ifdef _WIN32
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping_handle) CloseHandle(HANDLE(mapping_handle));
+	if (file_handle) CloseHandle(HANDLE(file_handle));
+	mapping_handle = nullptr;
+	file_handle = nullptr;
+	#else
+	if (bytes) munmap(const_cast< uint8_t * >(bytes), length);
+	#endif
+	bytes = nullptr;
+	length = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+//Read-only memory mapping of a whole file.
+// Used to pull bulk data (mesh attributes, caches) out of files without
+// going through per-element stream reads.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct MappedFile {
+	MappedFile() = default; //empty mapping
+	explicit MappedFile(std::string const &path); //NOTE: throws on error
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+	MappedFile(MappedFile &&);
+	MappedFile &operator=(MappedFile &&);
+	~MappedFile();
+
+	uint8_t const *data() const { return bytes; }
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+
+	std::string path;
+
+private:
+	void close();
+
+	uint8_t const *bytes = nullptr;
+	size_t length = 0;
+
+	#ifdef _WIN32
+	void *file_handle = nullptr;
+	void *mapping_handle = nullptr;
+	#endif
+};
@@ -0,0 +1,296 @@
+#include "MeshLoader.hpp"
+
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+float half_to_float(uint16_t h) {
+	uint32_t sign = uint32_t(h & 0x8000u) << 16;
+	uint32_t exponent = (h >> 10) & 0x1fu;
+	uint32_t mantissa = h & 0x3ffu;
+	uint32_t bits;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		} else { //subnormal half -> normal float
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400u) == 0) {
+				mantissa <<= 1;
+				exponent -= 1;
+			}
+			mantissa &= 0x3ffu;
+			bits = sign | (exponent << 23) | (mantissa << 13);
+		}
+	} else if (exponent == 0x1f) { //inf / nan
+		bits = sign | 0x7f800000u | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+//size in bytes of one element of a supported vertex format (0 if unsupported):
+uint32_t format_size(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_R32_SFLOAT: return 4;
+		case VK_FORMAT_R32G32_SFLOAT: return 8;
+		case VK_FORMAT_R32G32B32_SFLOAT: return 12;
+		case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+		case VK_FORMAT_R16_SFLOAT: return 2;
+		case VK_FORMAT_R16G16_SFLOAT: return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+		case VK_FORMAT_R8_UNORM: case VK_FORMAT_R8_SNORM: return 1;
+		case VK_FORMAT_R8G8_UNORM: case VK_FORMAT_R8G8_SNORM: return 2;
+		case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SNORM: return 4;
+		case VK_FORMAT_R16_UNORM: case VK_FORMAT_R16_SNORM: return 2;
+		case VK_FORMAT_R16G16_UNORM: case VK_FORMAT_R16G16_SNORM: return 4;
+		case VK_FORMAT_R16G16B16A16_UNORM: case VK_FORMAT_R16G16B16A16_SNORM: return 8;
+		default: return 0;
+	}
+}
+
+//decode one element into up to 'N' floats (missing components are left as-is):
+template< uint32_t N >
+void decode(VkFormat format, uint8_t const *src, float *out) {
+	auto copy_f32 = [&](uint32_t comps) {
+		std::memcpy(out, src, 4 * std::min(comps, N));
+	};
+	auto copy_f16 = [&](uint32_t comps) {
+		for (uint32_t c = 0; c < std::min(comps, N); ++c) {
+			uint16_t h;
+			std::memcpy(&h, src + 2 * c, 2);
+			out[c] = half_to_float(h);
+		}
+	};
+	auto copy_unorm8 = [&](uint32_t comps) {
+		for (uint32_t c = 0; c < std::min(comps, N); ++c) out[c] = src[c] / 255.0f;
+	};
+	auto copy_snorm8 = [&](uint32_t comps) {
+		for (uint32_t c = 0; c < std::min(comps, N); ++c) out[c] = std::max(-1.0f, int8_t(src[c]) / 127.0f);
+	};
+	auto copy_unorm16 = [&](uint32_t comps) {
+		for (uint32_t c = 0; c < std::min(comps, N); ++c) {
+			uint16_t v;
+			std::memcpy(&v, src + 2 * c, 2);
+			out[c] = v / 65535.0f;
+		}
+	};
+	auto copy_snorm16 = [&](uint32_t comps) {
+		for (uint32_t c = 0; c < std::min(comps, N); ++c) {
+			int16_t v;
+			std::memcpy(&v, src + 2 * c, 2);
+			out[c] = std::max(-1.0f, v / 32767.0f);
+		}
+	};
+
+	switch (format) {
+		case VK_FORMAT_R32_SFLOAT: copy_f32(1); break;
+		case VK_FORMAT_R32G32_SFLOAT: copy_f32(2); break;
+		case VK_FORMAT_R32G32B32_SFLOAT: copy_f32(3); break;
+		case VK_FORMAT_R32G32B32A32_SFLOAT: copy_f32(4); break;
+		case VK_FORMAT_R16_SFLOAT: copy_f16(1); break;
+		case VK_FORMAT_R16G16_SFLOAT: copy_f16(2); break;
+		case VK_FORMAT_R16G16B16A16_SFLOAT: copy_f16(4); break;
+		case VK_FORMAT_R8_UNORM: copy_unorm8(1); break;
+		case VK_FORMAT_R8G8_UNORM: copy_unorm8(2); break;
+		case VK_FORMAT_R8G8B8A8_UNORM: copy_unorm8(4); break;
+		case VK_FORMAT_R8_SNORM: copy_snorm8(1); break;
+		case VK_FORMAT_R8G8_SNORM: copy_snorm8(2); break;
+		case VK_FORMAT_R8G8B8A8_SNORM: copy_snorm8(4); break;
+		case VK_FORMAT_R16_UNORM: copy_unorm16(1); break;
+		case VK_FORMAT_R16G16_UNORM: copy_unorm16(2); break;
+		case VK_FORMAT_R16G16B16A16_UNORM: copy_unorm16(4); break;
+		case VK_FORMAT_R16_SNORM: copy_snorm16(1); break;
+		case VK_FORMAT_R16G16_SNORM: copy_snorm16(2); break;
+		case VK_FORMAT_R16G16B16A16_SNORM: copy_snorm16(4); break;
+		default: assert(0 && "format was checked by format_size()");
+	}
+}
+
+} //namespace
+
+MappedFile const &MeshLoader::map(S72::DataFile const &file) {
+	auto f = files.find(&file);
+	if (f == files.end()) {
+		f = files.emplace(&file, MappedFile(file.path)).first;
+		bytes_mapped += f->second.size();
+	}
+	return f->second;
+}
+
+uint32_t MeshLoader::load_indices(S72::Mesh const &mesh, std::vector< uint32_t > &out) {
+	assert(mesh.indices);
+	S72::Mesh::Indices const &indices = *mesh.indices;
+
+	uint32_t element;
+	switch (indices.format) {
+		case VK_INDEX_TYPE_UINT8: element = 1; break;
+		case VK_INDEX_TYPE_UINT16: element = 2; break;
+		case VK_INDEX_TYPE_UINT32: element = 4; break;
+		default: throw std::runtime_error("Mesh \"" + mesh.name + "\"'s indices have unsupported format " + string_VkIndexType(indices.format) + ".");
+	}
+
+	MappedFile const &file = map(indices.src);
+	size_t end = size_t(indices.offset) + size_t(element) * mesh.count;
+	if (end > file.size()) {
+		throw std::runtime_error("Mesh \"" + mesh.name + "\"'s indices read past the end of '" + file.path + "' (" + std::to_string(end) + " > " + std::to_string(file.size()) + " bytes).");
+	}
+	uint8_t const *src = file.data() + indices.offset;
+
+	size_t first = out.size();
+	out.resize(first + mesh.count);
+	uint32_t *dst = out.data() + first;
+
+	//widen everything to 32 bits so all meshes can share one index buffer / index type:
+	uint32_t max_index = 0;
+	if (element == 4) {
+		std::memcpy(dst, src, size_t(4) * mesh.count);
+		for (uint32_t i = 0; i < mesh.count; ++i) max_index = std::max(max_index, dst[i]);
+	} else if (element == 2) {
+		for (uint32_t i = 0; i < mesh.count; ++i) {
+			uint16_t v;
+			std::memcpy(&v, src + 2 * size_t(i), 2);
+			dst[i] = v;
+			max_index = std::max(max_index, dst[i]);
+		}
+	} else {
+		for (uint32_t i = 0; i < mesh.count; ++i) {
+			dst[i] = src[i];
+			max_index = std::max(max_index, dst[i]);
+		}
+	}
+
+	indexed_meshes += 1;
+	return mesh.count == 0 ? 0 : max_index + 1;
+}
+
+void MeshLoader::load_vertices(S72::Mesh const &mesh, uint32_t count, std::vector< PosNorTanTexVertex > &out, vec3 *min_, vec3 *max_) {
+	assert(min_ && max_);
+	vec3 &min = *min_;
+	vec3 &max = *max_;
+
+	//look up an attribute and make sure all 'count' elements lie inside its (mapped) data file:
+	struct Stream {
+		S72::Mesh::Attribute const *attribute = nullptr;
+		uint8_t const *base = nullptr; //first element
+	};
+	auto stream = [&](std::string const &name) -> Stream {
+		auto f = mesh.attributes.find(name);
+		if (f == mesh.attributes.end()) {
+			throw std::runtime_error("Attribute not found: " + mesh.name + ": " + name);
+		}
+		S72::Mesh::Attribute const &attribute = f->second;
+		uint32_t element = format_size(attribute.format);
+		if (element == 0) {
+			throw std::runtime_error("Mesh \"" + mesh.name + "\"'s attribute \"" + name + "\" has unsupported format " + string_VkFormat(attribute.format) + ".");
+		}
+		MappedFile const &file = map(attribute.src);
+		if (count > 0) {
+			size_t end = size_t(attribute.offset) + size_t(attribute.stride) * (count - 1) + element;
+			if (end > file.size()) {
+				throw std::runtime_error("Mesh \"" + mesh.name + "\"'s attribute \"" + name + "\" reads past the end of '" + file.path + "' (" + std::to_string(end) + " > " + std::to_string(file.size()) + " bytes).");
+			}
+		}
+		return Stream{ &attribute, file.data() + attribute.offset };
+	};
+
+	Stream position = stream("POSITION");
+	Stream normal = stream("NORMAL");
+	Stream tangent = stream("TANGENT");
+	Stream texcoord = stream("TEXCOORD");
+
+	size_t first = out.size();
+	out.resize(first + count);
+	PosNorTanTexVertex *dst = out.data() + first;
+
+	//fast path: attributes are already laid out exactly like PosNorTanTexVertex:
+	bool interleaved =
+		   &position.attribute->src == &normal.attribute->src
+		&& &position.attribute->src == &tangent.attribute->src
+		&& &position.attribute->src == &texcoord.attribute->src
+		&& position.attribute->stride == sizeof(PosNorTanTexVertex)
+		&& normal.attribute->stride == sizeof(PosNorTanTexVertex)
+		&& tangent.attribute->stride == sizeof(PosNorTanTexVertex)
+		&& texcoord.attribute->stride == sizeof(PosNorTanTexVertex)
+		&& position.attribute->format == VK_FORMAT_R32G32B32_SFLOAT
+		&& normal.attribute->format == VK_FORMAT_R32G32B32_SFLOAT
+		&& tangent.attribute->format == VK_FORMAT_R32G32B32A32_SFLOAT
+		&& texcoord.attribute->format == VK_FORMAT_R32G32_SFLOAT
+		&& normal.base == position.base + offsetof(PosNorTanTexVertex, Normal)
+		&& tangent.base == position.base + offsetof(PosNorTanTexVertex, Tangent)
+		&& texcoord.base == position.base + offsetof(PosNorTanTexVertex, TexCoord);
+
+	if (interleaved) {
+		uint8_t const *src = position.base;
+		for (uint32_t i = 0; i < count; ++i, src += sizeof(PosNorTanTexVertex)) {
+			std::memcpy(&dst[i], src, sizeof(PosNorTanTexVertex));
+			vec3 p(dst[i].Position.x, dst[i].Position.y, dst[i].Position.z);
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+		fast_path_meshes += 1;
+	} else {
+		//general path: convert each attribute with its own stride / format:
+		for (uint32_t i = 0; i < count; ++i) {
+			PosNorTanTexVertex &v = dst[i];
+			float p[3] = {0.0f, 0.0f, 0.0f};
+			float n[3] = {0.0f, 0.0f, 1.0f};
+			float t[4] = {1.0f, 0.0f, 0.0f, 1.0f};
+			float uv[2] = {0.0f, 0.0f};
+			decode< 3 >(position.attribute->format, position.base + size_t(i) * position.attribute->stride, p);
+			decode< 3 >(normal.attribute->format, normal.base + size_t(i) * normal.attribute->stride, n);
+			decode< 4 >(tangent.attribute->format, tangent.base + size_t(i) * tangent.attribute->stride, t);
+			decode< 2 >(texcoord.attribute->format, texcoord.base + size_t(i) * texcoord.attribute->stride, uv);
+			v.Position = {p[0], p[1], p[2]};
+			v.Normal = {n[0], n[1], n[2]};
+			v.Tangent = {t[0], t[1], t[2], t[3]};
+			v.TexCoord = {uv[0], uv[1]};
+			min = glm::min(min, vec3(p[0], p[1], p[2]));
+			max = glm::max(max, vec3(p[0], p[1], p[2]));
+		}
+	}
+
+	meshes_loaded += 1;
+}
+
+MeshLoader::Range MeshLoader::append(S72::Mesh const &mesh, std::vector< PosNorTanTexVertex > &vertices, std::vector< uint32_t > &indices, bool optimize) {
+	Range range{
+		.first = uint32_t(vertices.size()),
+		.count = mesh.count,
+		.first_index = uint32_t(indices.size()), //(also for non-indexed meshes, so the optimizer's slice below starts at the end)
+	};
+	if (mesh.indices) {
+		range.index_count = mesh.count;
+		range.count = load_indices(mesh, indices);
+	}
+	load_vertices(mesh, range.count, vertices, &range.min, &range.max);
+
+	if (optimize && mesh.topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {
+		//pull this mesh's data back off the end of the shared arrays, optimize, and re-append:
+		std::vector< PosNorTanTexVertex > mesh_vertices(vertices.begin() + range.first, vertices.end());
+		std::vector< uint32_t > mesh_indices(indices.begin() + range.first_index, indices.end());
+		vertices.resize(range.first);
+		indices.resize(range.first_index);
+
+		{
+			Timer timer([&](double elapsed){ optimize_ms += elapsed * 1000.0; });
+			optimize_stats += MeshOptimizer::optimize(mesh_vertices, mesh_indices);
+		}
+
+		range.count = uint32_t(mesh_vertices.size());
+		range.index_count = uint32_t(mesh_indices.size());
+		vertices.insert(vertices.end(), mesh_vertices.begin(), mesh_vertices.end());
+		indices.insert(indices.end(), mesh_indices.begin(), mesh_indices.end());
+	}
+
+	return range;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+//Bulk loader for S72 mesh attribute streams.
+// - memory-maps each S72::DataFile once (shared by all meshes that reference it)
+// - converts attributes with their own offset / stride / format into PosNorTanTexVertex
+// - computes the mesh's AABB while copying
+// - appends meshes to shared vertex / index arrays, optionally through MeshOptimizer
+
+#include "S72.hpp"
+#include "MappedFile.hpp"
+#include "MeshOptimizer.hpp"
+#include "PosNorTanTexVertex.hpp"
+#include "mat4.hpp"
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+struct MeshLoader {
+	//mapped data for a data file (maps on first use):
+	MappedFile const &map(S72::DataFile const &file);
+
+	//append the mesh's index stream (widened to 32 bits) to 'out':
+	// returns the number of vertices referenced (max index + 1)
+	// NOTE: mesh must have indices; throws if they are out of range
+	uint32_t load_indices(S72::Mesh const &mesh, std::vector< uint32_t > &out);
+
+	//append 'count' vertices to 'out' and expand [min,max] to cover their positions:
+	// (count is mesh.count for non-indexed meshes, the value returned by load_indices otherwise)
+	// NOTE: throws if attributes are missing, out of range, or in an unsupported format
+	void load_vertices(S72::Mesh const &mesh, uint32_t count, std::vector< PosNorTanTexVertex > &out, vec3 *min, vec3 *max);
+
+	//where a mesh ended up in the shared vertex / index arrays:
+	struct Range {
+		uint32_t first = 0; //first vertex (indices are relative to it)
+		uint32_t count = 0; //vertex count
+		uint32_t first_index = 0;
+		uint32_t index_count = 0; //0 => non-indexed mesh
+		vec3 min = vec3(std::numeric_limits< float >::max());
+		vec3 max = vec3(std::numeric_limits< float >::lowest());
+	};
+
+	//append the mesh's vertices (and indices, if it has them) to 'vertices' / 'indices':
+	// with 'optimize', triangle lists also go through MeshOptimizer::optimize, which builds indices for non-indexed meshes
+	Range append(S72::Mesh const &mesh, std::vector< PosNorTanTexVertex > &vertices, std::vector< uint32_t > &indices, bool optimize);
+
+	//stats, for load-time reporting:
+	size_t bytes_mapped = 0;
+	uint32_t meshes_loaded = 0;
+	uint32_t fast_path_meshes = 0; //meshes loaded by straight copy of interleaved float data
+	uint32_t indexed_meshes = 0;
+	MeshOptimizer::Stats optimize_stats; //totals over meshes optimized by append()
+	double optimize_ms = 0.0;
+
+	std::unordered_map< S72::DataFile const *, MappedFile > files;
+};
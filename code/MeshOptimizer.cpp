@@ -0,0 +1,282 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+//bitwise hash/equality, so only exactly-identical vertices get merged:
+struct VertexHash {
+	size_t operator()(PosNorTanTexVertex const &v) const {
+		uint8_t const *bytes = reinterpret_cast< uint8_t const * >(&v);
+		uint64_t h = 14695981039346656037ull; //FNV-1a
+		for (size_t i = 0; i < sizeof(v); ++i) {
+			h = (h ^ bytes[i]) * 1099511628211ull;
+		}
+		return size_t(h);
+	}
+};
+struct VertexEqual {
+	bool operator()(PosNorTanTexVertex const &a, PosNorTanTexVertex const &b) const {
+		return std::memcmp(&a, &b, sizeof(a)) == 0;
+	}
+};
+
+//merge duplicate vertices, rewriting indices to point at the surviving copy:
+void deduplicate(std::vector< PosNorTanTexVertex > &vertices, std::vector< uint32_t > &indices) {
+	std::unordered_map< PosNorTanTexVertex, uint32_t, VertexHash, VertexEqual > unique;
+	unique.reserve(vertices.size());
+
+	std::vector< uint32_t > remap(vertices.size());
+	std::vector< PosNorTanTexVertex > out;
+	out.reserve(vertices.size());
+	for (uint32_t i = 0; i < uint32_t(vertices.size()); ++i) {
+		auto ret = unique.emplace(vertices[i], uint32_t(out.size()));
+		if (ret.second) out.emplace_back(vertices[i]);
+		remap[i] = ret.first->second;
+	}
+	for (uint32_t &i : indices) i = remap[i];
+	vertices = std::move(out);
+}
+
+//Tipsify triangle ordering (Sander, Nehab, Barczak; "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007):
+// returns the new triangle order; cluster_starts gets the output positions where the walk had to restart (cache is cold there)
+std::vector< uint32_t > tipsify(std::vector< uint32_t > const &indices, uint32_t vertex_count, uint32_t cache_size, std::vector< uint32_t > *cluster_starts) {
+	uint32_t triangle_count = uint32_t(indices.size() / 3);
+
+	//vertex -> triangle adjacency, as offsets into one flat array:
+	std::vector< uint32_t > live(vertex_count, 0); //triangles not yet emitted, per vertex
+	for (uint32_t i : indices) live[i] += 1;
+	std::vector< uint32_t > adjacency_start(vertex_count + 1, 0);
+	for (uint32_t v = 0; v < vertex_count; ++v) adjacency_start[v + 1] = adjacency_start[v] + live[v];
+	std::vector< uint32_t > adjacency(indices.size());
+	{
+		std::vector< uint32_t > fill(adjacency_start.begin(), adjacency_start.end() - 1);
+		for (uint32_t t = 0; t < triangle_count; ++t) {
+			for (uint32_t c = 0; c < 3; ++c) {
+				adjacency[fill[indices[3 * t + c]]++] = t;
+			}
+		}
+	}
+
+	std::vector< uint32_t > cache_time(vertex_count, 0);
+	std::vector< bool > emitted(triangle_count, false);
+	std::vector< uint32_t > dead_end; //stack of recently-referenced vertices
+	std::vector< uint32_t > candidates;
+	std::vector< uint32_t > order;
+	order.reserve(triangle_count);
+
+	uint32_t time = cache_size + 1;
+	uint32_t cursor = 0; //next vertex to try when the dead-end stack is exhausted
+
+	//pick a fresh vertex when no neighbor is usable:
+	auto skip_dead_end = [&]() -> int64_t {
+		while (!dead_end.empty()) {
+			uint32_t d = dead_end.back();
+			dead_end.pop_back();
+			if (live[d] > 0) return d;
+		}
+		while (cursor < vertex_count) {
+			uint32_t v = cursor++;
+			if (live[v] > 0) return v;
+		}
+		return -1;
+	};
+
+	if (cluster_starts) cluster_starts->clear();
+	int64_t fan = vertex_count ? skip_dead_end() : -1;
+	if (fan >= 0 && cluster_starts) cluster_starts->emplace_back(0);
+	while (fan >= 0) {
+		candidates.clear();
+		for (uint32_t a = adjacency_start[fan]; a < adjacency_start[fan + 1]; ++a) {
+			uint32_t t = adjacency[a];
+			if (emitted[t]) continue;
+			emitted[t] = true;
+			order.emplace_back(t);
+			for (uint32_t c = 0; c < 3; ++c) {
+				uint32_t v = indices[3 * t + c];
+				dead_end.emplace_back(v);
+				candidates.emplace_back(v);
+				live[v] -= 1;
+				if (time - cache_time[v] > cache_size) {
+					cache_time[v] = time;
+					time += 1;
+				}
+			}
+		}
+
+		//next fanning vertex: the candidate that will still be in cache after emitting its remaining triangles, oldest first:
+		int64_t next = -1;
+		int64_t best = -1;
+		for (uint32_t v : candidates) {
+			if (live[v] == 0) continue;
+			int64_t priority = 0;
+			if (int64_t(time) - int64_t(cache_time[v]) + 2 * int64_t(live[v]) <= int64_t(cache_size)) {
+				priority = int64_t(time) - int64_t(cache_time[v]);
+			}
+			if (priority > best) {
+				best = priority;
+				next = v;
+			}
+		}
+		if (next < 0) {
+			next = skip_dead_end();
+			if (next >= 0 && cluster_starts && order.size() != cluster_starts->back()) {
+				cluster_starts->emplace_back(uint32_t(order.size()));
+			}
+		}
+		fan = next;
+	}
+
+	assert(order.size() == triangle_count);
+	return order;
+}
+
+//sort clusters so that outward-facing ones (which likely occlude the rest) draw first:
+// metric is dot(cluster centroid - mesh centroid, cluster normal), as in the Tipsify paper.
+void sort_clusters(std::vector< PosNorTanTexVertex > const &vertices, std::vector< uint32_t > const &indices, std::vector< uint32_t > &order, std::vector< uint32_t > const &cluster_starts) {
+	if (cluster_starts.size() <= 1) return;
+
+	auto position = [&](uint32_t i) {
+		auto const &p = vertices[i].Position;
+		return std::array< float, 3 >{ p.x, p.y, p.z };
+	};
+
+	//area-weighted centroid of the whole mesh:
+	std::array< double, 3 > mesh_centroid{ 0.0, 0.0, 0.0 };
+	double mesh_area = 0.0;
+
+	struct Cluster {
+		uint32_t begin, end;
+		std::array< double, 3 > centroid{ 0.0, 0.0, 0.0 };
+		std::array< double, 3 > normal{ 0.0, 0.0, 0.0 }; //sum of (area-weighted) face normals
+		double area = 0.0;
+		double metric = 0.0;
+	};
+	std::vector< Cluster > clusters;
+	clusters.reserve(cluster_starts.size());
+
+	for (uint32_t c = 0; c < cluster_starts.size(); ++c) {
+		Cluster cluster;
+		cluster.begin = cluster_starts[c];
+		cluster.end = (c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : uint32_t(order.size()));
+		for (uint32_t o = cluster.begin; o < cluster.end; ++o) {
+			uint32_t t = order[o];
+			auto a = position(indices[3 * t + 0]);
+			auto b = position(indices[3 * t + 1]);
+			auto d = position(indices[3 * t + 2]);
+			std::array< double, 3 > ab{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			std::array< double, 3 > ad{ d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			std::array< double, 3 > n{
+				ab[1] * ad[2] - ab[2] * ad[1],
+				ab[2] * ad[0] - ab[0] * ad[2],
+				ab[0] * ad[1] - ab[1] * ad[0],
+			};
+			double area = 0.5 * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (uint32_t k = 0; k < 3; ++k) {
+				double center = (double(a[k]) + double(b[k]) + double(d[k])) / 3.0;
+				cluster.centroid[k] += center * area;
+				cluster.normal[k] += n[k];
+			}
+			cluster.area += area;
+		}
+		for (uint32_t k = 0; k < 3; ++k) mesh_centroid[k] += cluster.centroid[k];
+		mesh_area += cluster.area;
+		if (cluster.area > 0.0) {
+			for (uint32_t k = 0; k < 3; ++k) cluster.centroid[k] /= cluster.area;
+		}
+		clusters.emplace_back(cluster);
+	}
+	if (mesh_area > 0.0) {
+		for (uint32_t k = 0; k < 3; ++k) mesh_centroid[k] /= mesh_area;
+	}
+
+	for (Cluster &cluster : clusters) {
+		cluster.metric = 0.0;
+		for (uint32_t k = 0; k < 3; ++k) {
+			cluster.metric += (cluster.centroid[k] - mesh_centroid[k]) * cluster.normal[k];
+		}
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const &a, Cluster const &b) {
+		return a.metric > b.metric;
+	});
+
+	std::vector< uint32_t > sorted;
+	sorted.reserve(order.size());
+	for (Cluster const &cluster : clusters) {
+		sorted.insert(sorted.end(), order.begin() + cluster.begin, order.begin() + cluster.end);
+	}
+	order = std::move(sorted);
+}
+
+} //namespace
+
+uint32_t MeshOptimizer::cache_misses(std::vector< uint32_t > const &indices, uint32_t vertex_count, uint32_t cache_size) {
+	//FIFO cache: a vertex is resident if it was inserted within the last cache_size misses
+	std::vector< uint32_t > inserted_at(vertex_count, 0);
+	uint32_t misses = 0;
+	for (uint32_t i : indices) {
+		assert(i < vertex_count);
+		if (inserted_at[i] == 0 || misses - inserted_at[i] >= cache_size) {
+			misses += 1;
+			inserted_at[i] = misses;
+		}
+	}
+	return misses;
+}
+
+MeshOptimizer::Stats MeshOptimizer::optimize(std::vector< PosNorTanTexVertex > &vertices, std::vector< uint32_t > &indices, uint32_t cache_size) {
+	Stats stats;
+	stats.vertices_before = uint32_t(vertices.size());
+
+	if (indices.empty()) {
+		indices.resize(vertices.size());
+		std::iota(indices.begin(), indices.end(), 0u);
+	}
+	stats.triangles = uint32_t(indices.size() / 3);
+	stats.misses_before = cache_misses(indices, uint32_t(vertices.size()), cache_size);
+
+	if (indices.size() % 3 != 0) {
+		stats.vertices_after = stats.vertices_before;
+		stats.misses_after = stats.misses_before;
+		return stats;
+	}
+
+	deduplicate(vertices, indices);
+
+	//triangle order for vertex cache, then cluster order for overdraw:
+	std::vector< uint32_t > cluster_starts;
+	std::vector< uint32_t > order = tipsify(indices, uint32_t(vertices.size()), cache_size, &cluster_starts);
+	sort_clusters(vertices, indices, order, cluster_starts);
+
+	std::vector< uint32_t > reordered;
+	reordered.reserve(indices.size());
+	for (uint32_t t : order) {
+		reordered.insert(reordered.end(), indices.begin() + 3 * t, indices.begin() + 3 * t + 3);
+	}
+
+	//vertex order = first use, so fetches walk the vertex buffer mostly forward:
+	constexpr uint32_t Unused = ~0u;
+	std::vector< uint32_t > remap(vertices.size(), Unused);
+	std::vector< PosNorTanTexVertex > fetch_ordered;
+	fetch_ordered.reserve(vertices.size());
+	for (uint32_t &i : reordered) {
+		if (remap[i] == Unused) {
+			remap[i] = uint32_t(fetch_ordered.size());
+			fetch_ordered.emplace_back(vertices[i]);
+		}
+		i = remap[i];
+	}
+
+	vertices = std::move(fetch_ordered);
+	indices = std::move(reordered);
+
+	stats.vertices_after = uint32_t(vertices.size());
+	stats.misses_after = cache_misses(indices, uint32_t(vertices.size()), cache_size);
+	return stats;
+}
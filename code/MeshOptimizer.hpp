@@ -0,0 +1,46 @@
+#pragma once
+
+//Load-time mesh optimization (enabled with `--optimize-meshes`):
+// - deduplicates bitwise-identical vertices and builds an index list
+// - reorders triangles for post-transform vertex cache locality (Tipsify, Sander et al. 2007)
+// - sorts the resulting triangle clusters outside-in to reduce overdraw
+// - reorders vertices by first use for pre-transform (fetch) locality
+
+#include "PosNorTanTexVertex.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace MeshOptimizer {
+	//cache size used for both the optimization and the ACMR numbers:
+	constexpr uint32_t DefaultCacheSize = 16;
+
+	struct Stats {
+		uint32_t triangles = 0;
+		uint32_t vertices_before = 0;
+		uint32_t vertices_after = 0;
+		uint32_t misses_before = 0; //simulated FIFO cache misses
+		uint32_t misses_after = 0;
+
+		float acmr_before() const { return triangles ? float(misses_before) / float(triangles) : 0.0f; }
+		float acmr_after() const { return triangles ? float(misses_after) / float(triangles) : 0.0f; }
+
+		Stats &operator+=(Stats const &o) {
+			triangles += o.triangles;
+			vertices_before += o.vertices_before;
+			vertices_after += o.vertices_after;
+			misses_before += o.misses_before;
+			misses_after += o.misses_after;
+			return *this;
+		}
+	};
+
+	//optimize one triangle-list mesh in place:
+	// 'indices' may be empty (non-indexed mesh); it is always filled on return.
+	// indices are local to 'vertices' (i.e., in [0, vertices.size()) ).
+	// meshes whose index count isn't a multiple of three are left untouched.
+	Stats optimize(std::vector< PosNorTanTexVertex > &vertices, std::vector< uint32_t > &indices, uint32_t cache_size = DefaultCacheSize);
+
+	//number of misses in a simulated FIFO post-transform cache when drawing 'indices':
+	uint32_t cache_misses(std::vector< uint32_t > const &indices, uint32_t vertex_count, uint32_t cache_size = DefaultCacheSize);
+}
@@ -0,0 +1,133 @@
+#include "PosNorTanTexPackedVertex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static std::array<VkVertexInputBindingDescription, 1> bindings {
+    VkVertexInputBindingDescription{
+        .binding = 0,
+        .stride = sizeof(PosNorTanTexPackedVertex),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+    }
+};
+
+//same locations as PosNorTanTexVertex, so objects-packed.vert differs only in decoding:
+static std::array<VkVertexInputAttributeDescription, 4> attributes {
+    VkVertexInputAttributeDescription{
+        .location = 0,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16B16A16_UNORM,
+        .offset = offsetof(PosNorTanTexPackedVertex, Position),
+    },
+    VkVertexInputAttributeDescription{
+        .location = 1,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SNORM,
+        .offset = offsetof(PosNorTanTexPackedVertex, Normal),
+    },
+    VkVertexInputAttributeDescription{
+        .location = 2,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SNORM,
+        .offset = offsetof(PosNorTanTexPackedVertex, Tangent),
+    },
+    VkVertexInputAttributeDescription{
+        .location = 3,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SFLOAT,
+        .offset = offsetof(PosNorTanTexPackedVertex, TexCoord),
+    },
+};
+
+const VkPipelineVertexInputStateCreateInfo PosNorTanTexPackedVertex::array_input_state {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    .vertexBindingDescriptionCount = uint32_t(bindings.size()),
+    .pVertexBindingDescriptions = bindings.data(),
+    .vertexAttributeDescriptionCount = uint32_t(attributes.size()),
+    .pVertexAttributeDescriptions = attributes.data(),
+};
+
+static uint16_t float_to_half(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = int32_t((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (((bits >> 23) & 0xffu) == 0xffu) { //inf / nan
+        return uint16_t(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    if (exponent >= 0x1f) return uint16_t(sign | 0x7c00u); //overflow => inf
+    if (exponent <= 0) { //subnormal half (or zero)
+        if (exponent < -10) return uint16_t(sign);
+        mantissa |= 0x800000u;
+        uint32_t shift = uint32_t(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        //round to nearest even:
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if (rest > halfway || (rest == halfway && (half_mantissa & 1u))) half_mantissa += 1;
+        return uint16_t(sign | half_mantissa);
+    }
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    //round to nearest even (carry into exponent is correct behavior):
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half += 1;
+    return uint16_t(half);
+}
+
+static int16_t to_snorm16(float f) {
+    return int16_t(std::lround(std::clamp(f, -1.0f, 1.0f) * 32767.0f));
+}
+
+//octahedral encoding of a direction (Meyer et al. 2010):
+static void oct_encode(float x, float y, float z, int16_t *out) {
+    float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if (l1 == 0.0f) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    x /= l1;
+    y /= l1;
+    z /= l1;
+    if (z < 0.0f) {
+        float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    out[0] = to_snorm16(x);
+    out[1] = to_snorm16(y);
+}
+
+PosNorTanTexPackedVertex PosNorTanTexPackedVertex::pack(PosNorTanTexVertex const &v, float const min[3], float const max[3]) {
+    PosNorTanTexPackedVertex p;
+
+    float position[3] = {v.Position.x, v.Position.y, v.Position.z};
+    uint16_t quantized[3];
+    for (uint32_t c = 0; c < 3; ++c) {
+        float extent = max[c] - min[c];
+        float t = (extent > 0.0f ? (position[c] - min[c]) / extent : 0.0f);
+        quantized[c] = uint16_t(std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+    }
+    p.Position.x = quantized[0];
+    p.Position.y = quantized[1];
+    p.Position.z = quantized[2];
+    p.Position.w = (v.Tangent.w < 0.0f ? 0 : 65535);
+
+    int16_t oct[2];
+    oct_encode(v.Normal.x, v.Normal.y, v.Normal.z, oct);
+    p.Normal.x = oct[0];
+    p.Normal.y = oct[1];
+    oct_encode(v.Tangent.x, v.Tangent.y, v.Tangent.z, oct);
+    p.Tangent.x = oct[0];
+    p.Tangent.y = oct[1];
+
+    p.TexCoord.s = float_to_half(v.TexCoord.s);
+    p.TexCoord.t = float_to_half(v.TexCoord.t);
+
+    return p;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "PosNorTanTexVertex.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+//Compact (20-byte) version of PosNorTanTexVertex:
+// Position: 16-bit UNORM, relative to the mesh's AABB (dequantized by folding the AABB into the instance transform);
+//           w holds the tangent handedness (0 => -1, 1 => +1)
+// Normal, Tangent: octahedral-encoded, 16-bit SNORM
+// TexCoord: half floats
+struct PosNorTanTexPackedVertex {
+    struct {uint16_t x, y, z, w;} Position;
+    struct {int16_t x, y;} Normal;
+    struct {int16_t x, y;} Tangent;
+    struct {uint16_t s, t;} TexCoord;
+
+    //quantize a full-precision vertex against the AABB [min, max] of its mesh:
+    static PosNorTanTexPackedVertex pack(PosNorTanTexVertex const &v, float const min[3], float const max[3]);
+
+    static const VkPipelineVertexInputStateCreateInfo array_input_state;
+};
+
+static_assert(sizeof(PosNorTanTexPackedVertex) == 4*2 + 2*2 + 2*2 + 2*2, "PosNorTanTexPackedVertex is packed.");
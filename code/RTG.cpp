@@ -51,6 +51,10 @@ void RTG::Configuration::parse(int argc, char **argv) {
 			if (argi + 1 >= argc) throw std::runtime_error("--scene requires a scene file.");
 			argi += 1;
 			scene_file = argv[argi];
+		} else if (arg == "--scene-cache") {
+			if (argi + 1 >= argc) throw std::runtime_error("--scene-cache requires a cache file path.");
+			argi += 1;
+			scene_cache = argv[argi];
 		} else if(arg == "--print"){
 			print = true;
 		} else if(arg == "--camera"){
@@ -65,6 +69,38 @@ void RTG::Configuration::parse(int argc, char **argv) {
 			if (argi + 1 >= argc) throw std::runtime_error("--lambertian requires a path to output the lambertian environment map.");
 			argi += 1;
 			lambertian_env_output = argv[argi];
+		} else if (arg == "--optimize-meshes") {
+			optimize_meshes = true;
+		} else if (arg == "--vertex-format") {
+			if (argi + 1 >= argc) throw std::runtime_error("--vertex-format requires a parameter (full|packed).");
+			argi += 1;
+			vertex_format = argv[argi];
+			if (vertex_format != "full" && vertex_format != "packed") {
+				throw std::runtime_error("--vertex-format must be 'full' or 'packed', got '" + vertex_format + "'.");
+			}
+		} else if (arg == "--no-mipmaps") {
+			mipmaps = false;
+		} else if (arg == "--no-baked-textures") {
+			baked_textures = false;
+		} else if (arg == "--anisotropy") {
+			if (argi + 1 >= argc) throw std::runtime_error("--anisotropy requires a parameter (maximum anisotropy, >= 1).");
+			argi += 1;
+			try {
+				max_anisotropy = std::stof(argv[argi]);
+			} catch (...) {
+				throw std::runtime_error("--anisotropy parameter '" + std::string(argv[argi]) + "' is not a valid float.");
+			}
+			if (!(max_anisotropy >= 1.0f)) throw std::runtime_error("--anisotropy must be at least 1, got '" + std::string(argv[argi]) + "'.");
+		} else if (arg == "--texture-budget-mb") {
+			if (argi + 1 >= argc) throw std::runtime_error("--texture-budget-mb requires a parameter (megabytes of texture memory).");
+			argi += 1;
+			try {
+				texture_budget_mb = uint32_t(std::stoul(argv[argi]));
+			} catch (...) {
+				throw std::runtime_error("--texture-budget-mb parameter '" + std::string(argv[argi]) + "' is not a valid integer.");
+			}
+		} else if (arg == "--atlas-textures") {
+			atlas_textures = true;
 		} else if (arg == "--exposure") {
 			if (argi + 1 >= argc) throw std::runtime_error("--exposure requires a float parameter.");
 			argi += 1;
@@ -92,10 +128,18 @@ void RTG::Configuration::usage(std::function< void(const char *, const char *) >
 	callback("--drawing-size <w> <h>", "Set the size of the surface to draw to.");
 	callback("--headless", "Dont' create a window; read events from stdin");
 	callback("--scene <path/*.s72>", "Specifies the scene(in .s72 format) to view");
+	callback("--scene-cache <file>", "Load the scene, meshes, and decoded textures from a binary cache; (re)writes the cache if missing or stale.");
 	callback("--print", "Print loaded scene information");
 	callback("--camera <name>", "View the scene throught the camera named <name>");
 	callback("--culling <none|frustum>", "Start with specified culling mode: none or frustum.");
 	callback("--lambertian <output_path>", "Pre-convolve the environment map for lambertian convolution and save the result to the specified path.");
+	callback("--optimize-meshes", "Deduplicate vertices and reorder triangles of loaded meshes for vertex cache locality and overdraw.");
+	callback("--vertex-format <full|packed>", "Select the object vertex layout (default: full); packed uses 20-byte quantized vertices.");
+	callback("--no-mipmaps", "Upload material textures without mip chains and sample them with nearest filtering.");
+	callback("--no-baked-textures", "Ignore block-compressed .ktx2 files made by the bake tool and load the source images instead.");
+	callback("--anisotropy <n>", "Maximum anisotropy when sampling material textures (default: 16, clamped to the device limit; 1 disables).");
+	callback("--texture-budget-mb <mb>", "Start material textures at low resolution and stream mip levels in (and cold ones out) to stay within <mb> megabytes (default: 0, load everything up front).");
+	callback("--atlas-textures", "Pack small (up to 256x256) non-baked material textures into shared atlas pages.");
 	callback("--exposure <E>", "Set exposure value (default: 0); computed radiance is multiplied by 2^E before tone mapping.");
 	callback("--tone-map <linear|aces>", "Select tone mapping operator (default: linear); linear applies no tone mapping, aces applies ACES RRT + ODT.");
 }
@@ -403,6 +447,14 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 				if (queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) {
 					if (!compute_queue_family) compute_queue_family = i;
 				}
+				//(a transfer-only family is usually backed by a DMA engine, so uploads can run alongside rendering;
+				// needs whole-texel image copies, since uploads copy mip tails and odd-sized levels)
+				VkExtent3D const &granularity = queue_family.minImageTransferGranularity;
+				if ((queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT)
+				 && !(queue_family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+				 && granularity.width == 1 && granularity.height == 1 && granularity.depth == 1) {
+					if (!transfer_queue_family) transfer_queue_family = i;
+				}
 				if (!configuration.headless) {
 					VkBool32 present_support = VK_FALSE;
 					VK(vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support));
@@ -426,6 +478,10 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 			if (!compute_queue_family) {
 				throw std::runtime_error("No queue with compute support.");
 			}
+			//(graphics queues always support transfers)
+			if (!transfer_queue_family) {
+				transfer_queue_family = graphics_queue_family;
+			}
 		}
 
 		//select device extensions
@@ -443,7 +499,8 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 			std::set<uint32_t> unique_queue_families {
 				graphics_queue_family.value(),
 				present_queue_family.value(),
-				compute_queue_family.value()
+				compute_queue_family.value(),
+				transfer_queue_family.value()
 			};
 			float queue_priorities[1] = {1.0f};
 			for (uint32_t queue_family : unique_queue_families) {
@@ -455,8 +512,28 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 				});
 			}
 
+			//turn on the optional features we can use:
+			{
+				VkPhysicalDeviceVulkan12Features supported_12{
+					.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+				};
+				VkPhysicalDeviceFeatures2 supported{
+					.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+					.pNext = &supported_12,
+				};
+				vkGetPhysicalDeviceFeatures2(physical_device, &supported);
+				device_features.samplerAnisotropy = supported.features.samplerAnisotropy;
+				device_features.textureCompressionBC = supported.features.textureCompressionBC;
+				device_features.shaderSampledImageArrayDynamicIndexing = supported.features.shaderSampledImageArrayDynamicIndexing;
+				//(descriptor indexing, for runtime-sized texture arrays)
+				device_features_12.runtimeDescriptorArray = supported_12.runtimeDescriptorArray;
+				device_features_12.descriptorBindingPartiallyBound = supported_12.descriptorBindingPartiallyBound;
+				device_features_12.descriptorBindingVariableDescriptorCount = supported_12.descriptorBindingVariableDescriptorCount;
+			}
+
 			VkDeviceCreateInfo create_info {
 				.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+				.pNext = &device_features_12,
 				.queueCreateInfoCount = uint32_t(queue_create_infos.size()),
 				.pQueueCreateInfos = queue_create_infos.data(),
 				//device layers are depreciated
@@ -466,7 +543,7 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 				.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
 				.ppEnabledExtensionNames = device_extensions.data(),
 				// use VkPhysicalDeviceFeatures to request specific fdeatures ; 
-				.pEnabledFeatures = nullptr,
+				.pEnabledFeatures = &device_features,
 			};
 
 			VK(vkCreateDevice(physical_device, &create_info, nullptr, &device));
@@ -474,6 +551,7 @@ RTG::RTG(Configuration const &configuration_) : helpers(*this) {
 			vkGetDeviceQueue(device, graphics_queue_family.value(), 0, &graphics_queue);
 			vkGetDeviceQueue(device, present_queue_family.value(), 0, &present_queue);
 			vkGetDeviceQueue(device, compute_queue_family.value(), 0, &compute_queue);
+			vkGetDeviceQueue(device, transfer_queue_family.value(), 0, &transfer_queue);
 		}
 	}
 
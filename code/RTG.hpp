@@ -78,6 +78,8 @@ struct RTG {
 		bool headless = false;
 		// --scene read .s72 scene file from the path
 		std::string scene_file = "";
+		// --scene-cache <file> read the resolved scene + decoded payloads from this file (written on first run)
+		std::string scene_cache = "";
 		// --print if true, print scene info
 		bool print = false;
 		//if set, use a specific camera math the name:
@@ -89,6 +91,30 @@ struct RTG {
 
 		std::string lambertian_env_output = "";
 
+		//if true, deduplicate/reorder mesh data at load time for vertex cache + overdraw:
+		// `--optimize-meshes` command-line flag
+		bool optimize_meshes = false;
+
+		//vertex layout used by the objects pipeline: "full" (PosNorTanTexVertex) or "packed" (PosNorTanTexPackedVertex)
+		// `--vertex-format <full|packed>` command-line flag
+		std::string vertex_format = "full";
+
+		//material textures get full mip chains (generated on upload) and trilinear filtering:
+		// `--no-mipmaps` command-line flag turns this off (single level, nearest filtering)
+		bool mipmaps = true;
+		//use `<image>.ktx2` files (block-compressed, with mips; made by bin/bake) in place of images when they are up to date:
+		// `--no-baked-textures` command-line flag turns this off
+		bool baked_textures = true;
+		//anisotropic filtering for material textures, clamped to the device limit (1 => off):
+		// `--anisotropy <n>` command-line flag
+		float max_anisotropy = 16.0f;
+		//stream material texture mip levels in and out to stay within this many megabytes of image memory (0 => upload everything up front):
+		// `--texture-budget-mb <mb>` command-line flag
+		uint32_t texture_budget_mb = 0;
+		//pack small (<= 256 texel) decoded textures into shared atlas pages, so they take fewer images and texture table entries:
+		// `--atlas-textures` command-line flag
+		bool atlas_textures = false;
+
 		// Tone mapping and exposure control
 		// `--exposure <float>` command-line flag (default: 0.0, multiplier = 2^exposure)
 		float exposure = 0.0f;
@@ -115,6 +141,8 @@ struct RTG {
 	VkDebugUtilsMessengerEXT debug_messenger = VK_NULL_HANDLE;
 	VkPhysicalDevice physical_device = VK_NULL_HANDLE;
 	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceFeatures device_features{}; //optional features enabled on 'device' (samplerAnisotropy, textureCompressionBC, shaderSampledImageArrayDynamicIndexing if supported)
+	VkPhysicalDeviceVulkan12Features device_features_12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES }; //(runtimeDescriptorArray, descriptorBindingPartiallyBound, descriptorBindingVariableDescriptorCount if supported)
 
 	//queue for graphics and transfer operations:
 	std::optional< uint32_t > graphics_queue_family;
@@ -128,6 +156,10 @@ struct RTG {
 	std::optional< uint32_t > compute_queue_family;
 	VkQueue compute_queue = VK_NULL_HANDLE;
 
+	//queue for uploads (Helpers::upload_*); a transfer-only family if the device has one, otherwise the graphics queue:
+	std::optional< uint32_t > transfer_queue_family;
+	VkQueue transfer_queue = VK_NULL_HANDLE;
+
 	//-------------------------------------------------
 	//Handles for the window and surface:
 
@@ -1,10 +1,18 @@
 #include "S72.hpp"
 
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+
 #include <cassert>
+#include <functional>
 #include <cmath>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
+#include <array>
+#include <deque>
+#include <exception>
+#include <memory>
 
 //functions that do the inverse of those in vk_enum_string_helper.h :
 
@@ -191,11 +199,9 @@ std::vector< float > extract_float_vector(std::map< std::string, sejp::value > *
 
 	std::vector< float > ret;
 	try {
-		std::vector< sejp::value > const &array = object.at(key).as_array().value();
-		ret.reserve(array.size());
-		for (sejp::value const &value : array) {
-			ret.emplace_back(float(value.as_number().value()));
-		}
+		//arrays of numbers are stored contiguously by sejp, so this is a straight conversion:
+		std::span< double const > array = object.at(key).as_numbers().value();
+		ret.assign(array.begin(), array.end());
 	} catch (std::exception &) {
 		throw std::runtime_error(what + " is not an array of numbers.");
 	}
@@ -204,6 +210,20 @@ std::vector< float > extract_float_vector(std::map< std::string, sejp::value > *
 };
 
 
+//give a newly-defined object the next index in its dense table:
+template< typename T >
+void add_to_table(std::vector< T * > &table, T &object) {
+	object.index = uint32_t(table.size());
+	table.emplace_back(&object);
+}
+
+//data file by src, creating (and indexing) it on first reference:
+S72::DataFile &data_file(S72 &s72, std::string const &src) {
+	auto [f, created] = s72.data_files.try_emplace(src);
+	if (created) add_to_table(s72.tables.data_files, f->second);
+	return f->second;
+}
+
 //parse a texture map property of a sejp object into an S72's texture storage
 // throws if the property is missing or doesn't parse as a texture
 // deletes property from the object and returns a reference to the S72's textures container on success
@@ -258,698 +278,1082 @@ S72::Texture &extract_map(std::map< std::string, sejp::value > *object_, std::st
 
 	std::string texture_key = src + ", format " + std::to_string(int(type)) + ", type " + std::to_string(int(format));
 
-	return s72.textures.emplace(texture_key, S72::Texture{.src = src, .type = type, .format = format}).first->second;
+	auto [f, created] = s72.textures.emplace(texture_key, S72::Texture{.src = src, .type = type, .format = format});
+	if (created) add_to_table(s72.tables.textures, f->second);
+	return f->second;
 }
 
 
-S72 S72::load(std::string const &scene_file) {
+//name-based references between top-level objects, recorded while parsing and resolved once every object exists:
+// (each entry also records the index of the object in the scene file, for error messages)
+struct References {
+	std::vector< std::string > scene_roots;
 
-	S72 s72; //the loaded scene, will be returned at end of function
+	struct NodeReferences {
+		S72::Node *node;
+		std::vector< std::string > children;
+		std::string mesh, camera, environment, light; //"" => none
+	};
+	std::vector< NodeReferences > nodes; //in file order
 
-	sejp::value json = sejp::load(scene_file);
+	struct MeshReferences {
+		S72::Mesh *mesh;
+		std::string material;
+	};
+	std::vector< MeshReferences > meshes; //in file order
+
+	//drivers hold a Node &, so they are only constructed once every node exists (see SceneStream::finish):
+	struct DriverReferences {
+		std::string name;
+		std::string node;
+		S72::Driver::Channel channel;
+		std::vector< float > times;
+		std::vector< float > values;
+		S72::Driver::Interpolation interpolation;
+	};
+	std::vector< DriverReferences > drivers; //in file order
 
-	std::optional< std::vector< sejp::value > > array = json.as_array();
+	//(constructed drivers point at a -- possibly empty -- node; just need to check it was defined)
+	std::vector< std::string > driver_nodes; //parallel to s72.drivers
+};
 
-	//fetch top-level array from scene file:
-	if (!array) {
-		throw std::runtime_error("Top-level value of s72 file should be an array.");
+//parse one top-level object of the scene file (array element 'i') into s72:
+// references to other objects are recorded in *pending_
+void load_object(S72 &s72, sejp::value const &element, size_t i, References *pending_) {
+	assert(pending_);
+	auto &pending = *pending_;
+
+	using Scene = S72::Scene;
+	using Node = S72::Node;
+	using Mesh = S72::Mesh;
+	using Camera = S72::Camera;
+	using Driver = S72::Driver;
+	using Material = S72::Material;
+	using Environment = S72::Environment;
+	using Light = S72::Light;
+	using Texture = S72::Texture;
+	using vec3 = S72::vec3;
+	using quat = S72::quat;
+	using color = S72::color;
+
+	//make a copy of the object and erase members as they are parsed:
+	std::map< std::string, sejp::value > object;
+	try {
+		object = element.as_object().value();
+	} catch (std::exception &) {
+		throw std::runtime_error("Array element " + std::to_string(i) + " is not an object.");
 	}
 
-	//check magic value:
-	if (!(array->size() >= 1 && array->at(0).as_string() && array->at(0).as_string().value() == "s72-v2")) {
-		throw std::runtime_error("First element of s72 array should be \"s72-v2\".");
-	}
+	//All objects must have a "type" and "name":
+	std::string type = extract_string(&object, "type", "Object at index " + std::to_string(i) + "'s \"type\"");
+	std::string name = extract_string(&object, "name", "Object at index " + std::to_string(i) + "'s \"name\"");
 
-	//parse the remaining objects;
-	for (size_t i = 1; i < array->size(); i++) {
+	if (type == "SCENE") {
+		//reference to the object we are parsing into:
+		Scene &scene = s72.scene;
 
-		//make a copy of the object and erase members as they are parsed:
-		std::map< std::string, sejp::value > object;
-		try {
-			object = array->at(i).as_object().value();
-		} catch (std::exception &) {
-			throw std::runtime_error("Array element " + std::to_string(i) + " is not an object.");
+		//check that we haven't already parsed the scene info:
+		if (scene.name != "") {
+			throw std::runtime_error("Multiple \"SCENE\" objects in s72 file.");
 		}
 
-		//All objects must have a "type" and "name":
-		std::string type = extract_string(&object, "type", "Object at index " + std::to_string(i) + "'s \"type\"");
-		std::string name = extract_string(&object, "name", "Object at index " + std::to_string(i) + "'s \"name\"");
-
-		if (type == "SCENE") {
-			//reference to the object we are parsing into:
-			Scene &scene = s72.scene;
+		//mark scene as parsed:
+		scene.name = name;
 
-			//check that we haven't already parsed the scene info:
-			if (scene.name != "") {
-				throw std::runtime_error("Multiple \"SCENE\" objects in s72 file.");
-			}
-
-			//mark scene as parsed:
-			scene.name = name;
-
-			//"roots" is optional:
-			if (auto f = object.find("roots"); f != object.end()) {
-				std::vector< std::string > refs;
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					for (auto const &value : vec) {
-						refs.emplace_back(value.as_string().value());
-					}
-				} catch (std::exception &) {
-					throw std::runtime_error("Scene \"" + name + "\"'s roots are not an array of strings.");
-				}
-				scene.roots.reserve(refs.size());
-				for (auto const &ref : refs) {
-					scene.roots.emplace_back(&s72.nodes[ref]); //NOTE: creates new (empty) nodes if not yet parsed; will check for this later
+		//"roots" is optional:
+		if (auto f = object.find("roots"); f != object.end()) {
+			std::vector< std::string > refs;
+			try {
+				std::vector< sejp::value > const &vec = f->second.as_array().value();
+				for (auto const &value : vec) {
+					refs.emplace_back(value.as_string().value());
 				}
-				object.erase(f);
+			} catch (std::exception &) {
+				throw std::runtime_error("Scene \"" + name + "\"'s roots are not an array of strings.");
 			}
-		} else if (type == "NODE") {
-			//get a reference to the object we are parsing into:
-			Node &node = s72.nodes[name];
+			pending.scene_roots = std::move(refs); //(resolved once all nodes exist)
+			object.erase(f);
+		}
+	} else if (type == "NODE") {
+		//get a reference to the object we are parsing into:
+		Node &node = s72.nodes[name];
 
-			//check that we haven't already parsed this node's information:
-			if (node.name != "") {
-				throw std::runtime_error("Multiple \"NODE\" objects with name \"" + name + "\".");
-			}
+		//check that we haven't already parsed this node's information:
+		if (node.name != "") {
+			throw std::runtime_error("Multiple \"NODE\" objects with name \"" + name + "\".");
+		}
 
-			//mark the node as parsed:
-			node.name = name;
+		//mark the node as parsed:
+		node.name = name;
+		add_to_table(s72.tables.nodes, node);
 
-			if (auto f = object.find("translation"); f != object.end()) {
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					node.translation = vec3(
-						float(vec.at(0).as_number().value()),
-						float(vec.at(1).as_number().value()),
-						float(vec.at(2).as_number().value())
-					);
-					if (vec.size() != 3) throw std::runtime_error("trailing values");
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s translation should be an array of three numbers.");
-				}
-				object.erase(f);
+		//references to other objects get resolved after parsing:
+		References::NodeReferences &node_refs = pending.nodes.emplace_back(References::NodeReferences{ .node = &node });
+
+		if (auto f = object.find("translation"); f != object.end()) {
+			try {
+				std::span< double const > vec = f->second.as_numbers().value();
+				if (vec.size() != 3) throw std::runtime_error("wrong number of values");
+				node.translation = vec3(float(vec[0]), float(vec[1]), float(vec[2]));
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s translation should be an array of three numbers.");
 			}
+			object.erase(f);
+		}
 
-			if (auto f = object.find("rotation"); f != object.end()) {
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					node.rotation = quat(
-						float(vec.at(3).as_number().value()),
-						float(vec.at(0).as_number().value()),
-						float(vec.at(1).as_number().value()),
-						float(vec.at(2).as_number().value())
-					);
-					if (vec.size() != 4) throw std::runtime_error("trailing values");
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s rotation should be an array of four numbers.");
-				}
-				object.erase(f);
+		if (auto f = object.find("rotation"); f != object.end()) {
+			try {
+				std::span< double const > vec = f->second.as_numbers().value();
+				if (vec.size() != 4) throw std::runtime_error("wrong number of values");
+				node.rotation = quat(float(vec[3]), float(vec[0]), float(vec[1]), float(vec[2]));
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s rotation should be an array of four numbers.");
 			}
+			object.erase(f);
+		}
 
-			if (auto f = object.find("scale"); f != object.end()) {
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					node.scale = vec3(
-						float(vec.at(0).as_number().value()),
-						float(vec.at(1).as_number().value()),
-						float(vec.at(2).as_number().value())
-					);
-					if (vec.size() != 3) throw std::runtime_error("trailing values");
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s scale should be an array of three numbers.");
-				}
-				object.erase(f);
+		if (auto f = object.find("scale"); f != object.end()) {
+			try {
+				std::span< double const > vec = f->second.as_numbers().value();
+				if (vec.size() != 3) throw std::runtime_error("wrong number of values");
+				node.scale = vec3(float(vec[0]), float(vec[1]), float(vec[2]));
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s scale should be an array of three numbers.");
 			}
+			object.erase(f);
+		}
 
-			if (auto f = object.find("children"); f != object.end()) {
-				std::vector< std::string > refs;
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					for (auto const &value : vec) {
-						refs.emplace_back(value.as_string().value());
-					}
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s children should be an array of strings.");
-				}
-				//create/fixup pointers to other nodes:
-				node.children.reserve(refs.size());
-				for (auto const &ref : refs) {
-					node.children.emplace_back(&s72.nodes[ref]);
+		if (auto f = object.find("children"); f != object.end()) {
+			std::vector< std::string > refs;
+			try {
+				std::vector< sejp::value > const &vec = f->second.as_array().value();
+				for (auto const &value : vec) {
+					refs.emplace_back(value.as_string().value());
 				}
-				object.erase(f);
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s children should be an array of strings.");
 			}
+			node_refs.children = std::move(refs);
+			object.erase(f);
+		}
 
-			if (auto f = object.find("mesh"); f != object.end()) {
-				std::string ref;
-				try {
-					ref = f->second.as_string().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s mesh should be a string.");
-				}
-				node.mesh = &s72.meshes[ref];
-				object.erase(f);
+		if (auto f = object.find("mesh"); f != object.end()) {
+			std::string ref;
+			try {
+				ref = f->second.as_string().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s mesh should be a string.");
 			}
+			node_refs.mesh = ref;
+			object.erase(f);
+		}
 
-			if (auto f = object.find("camera"); f != object.end()) {
-				std::string ref;
-				try {
-					ref = f->second.as_string().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s camera should be a string.");
-				}
-				node.camera = &s72.cameras[ref];
-				object.erase(f);
+		if (auto f = object.find("camera"); f != object.end()) {
+			std::string ref;
+			try {
+				ref = f->second.as_string().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s camera should be a string.");
 			}
+			node_refs.camera = ref;
+			object.erase(f);
+		}
 
-			if (auto f = object.find("environment"); f != object.end()) {
-				std::string ref;
-				try {
-					ref = f->second.as_string().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s environment should be a string.");
-				}
-				node.environment = &s72.environments[ref];
-				object.erase(f);
+		if (auto f = object.find("environment"); f != object.end()) {
+			std::string ref;
+			try {
+				ref = f->second.as_string().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s environment should be a string.");
 			}
+			node_refs.environment = ref;
+			object.erase(f);
+		}
 
-			if (auto f = object.find("light"); f != object.end()) {
-				std::string ref;
-				try {
-					ref = f->second.as_string().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Node \"" + name + "\"'s light should be a string.");
-				}
-				node.light = &s72.lights[ref];
-				object.erase(f);
+		if (auto f = object.find("light"); f != object.end()) {
+			std::string ref;
+			try {
+				ref = f->second.as_string().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Node \"" + name + "\"'s light should be a string.");
 			}
+			node_refs.light = ref;
+			object.erase(f);
+		}
 
-		} else if (type == "MESH"){
-			//reference to the thing we are parsing into:
-			Mesh &mesh = s72.meshes[name];
+	} else if (type == "MESH"){
+		//reference to the thing we are parsing into:
+		Mesh &mesh = s72.meshes[name];
 
-			//check that we haven't already parsed this:
-			if (mesh.name != "") {
-				throw std::runtime_error("Multiple \"MESH\" objects with name \"" + name + "\".");
-			}
+		//check that we haven't already parsed this:
+		if (mesh.name != "") {
+			throw std::runtime_error("Multiple \"MESH\" objects with name \"" + name + "\".");
+		}
 
-			//mark as parsed:
-			mesh.name = name;
+		//mark as parsed:
+		mesh.name = name;
+		add_to_table(s72.tables.meshes, mesh);
 
-			std::string topology = extract_string(&object, "topology", "Mesh \"" + name + "\"'s topology");
-			mesh.topology = topology_to_VkPrimitiveTopology(topology);
+		std::string topology = extract_string(&object, "topology", "Mesh \"" + name + "\"'s topology");
+		mesh.topology = topology_to_VkPrimitiveTopology(topology);
 
-			mesh.count = extract_uint32_t(&object, "count", "Mesh \"" + name + "\"'s count");
+		mesh.count = extract_uint32_t(&object, "count", "Mesh \"" + name + "\"'s count");
 
-			if (auto f = object.find("indices"); f != object.end()) {
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = f->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Mesh \"" + name + "\"'s indices should be an object.");
-				}
+		if (auto f = object.find("indices"); f != object.end()) {
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = f->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Mesh \"" + name + "\"'s indices should be an object.");
+			}
+
+			std::string src = extract_string(&obj, "src", "Mesh \"" + name + "\"'s indices.src");
+			uint32_t offset = extract_uint32_t(&obj, "offset", "Mesh \"" + name + "\"'s indices.offset");
+			std::string format = extract_string(&obj, "format", "Mesh \"" + name + "\"'s indices.format");
+			mesh.indices.emplace(Mesh::Indices{
+				.src = data_file(s72, src),
+				.offset = offset,
+				.format = format_to_VkIndexType(format),
+			});
 
-				std::string src = extract_string(&obj, "src", "Mesh \"" + name + "\"'s indices.src");
-				uint32_t offset = extract_uint32_t(&obj, "offset", "Mesh \"" + name + "\"'s indices.offset");
-				std::string format = extract_string(&obj, "format", "Mesh \"" + name + "\"'s indices.format");
-				mesh.indices.emplace(Mesh::Indices{
-					.src = s72.data_files[src],
-					.offset = offset,
-					.format = format_to_VkIndexType(format),
-				});
+			warn_on_unhandled(obj, "Mesh \"" + name + "\"'s indices");
 
-				warn_on_unhandled(obj, "Mesh \"" + name + "\"'s indices");
+			object.erase(f);
+		}
 
-				object.erase(f);
+		std::map< std::string, sejp::value > attributes;
+		try {
+			attributes = object.at("attributes").as_object().value();
+		} catch (std::exception &) {
+			throw std::runtime_error("Mesh \"" + name + "\"'s attributes should be an object.");
+		}
+		object.erase(object.find("attributes"));
+
+		for (auto const &[key, value] : attributes) {
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = value.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Mesh \"" + name + "\"'s attribute \"" + key + "\" is not an object.");
 			}
 
-			std::map< std::string, sejp::value > attributes;
+			std::string src = extract_string(&obj, "src", "Mesh \"" + name + "\"'s attribute \"" + key + "\"'s src");
+			uint32_t offset = extract_uint32_t(&obj, "offset", "Mesh \"" + name + "\"'s attribute \"" + key + "\"' offset");
+			uint32_t stride = extract_uint32_t(&obj, "stride", "Mesh \"" + name + "\"'s attribute \"" + key + "\"' stride");
+			std::string format = extract_string(&obj, "format", "Mesh \"" + name + "\"'s attribute \"" + key + "\"'s format");
+			mesh.attributes.emplace(key, Mesh::Attribute{
+				.src = data_file(s72, src),
+				.offset = offset,
+				.stride = stride,
+				.format = format_to_VkFormat(format),
+			});
+
+			warn_on_unhandled(obj, "Mesh \"" + name + "\"'s attribute \"" + key + "\"");
+		}
+
+		if (auto f = object.find("material"); f != object.end()) {
+			std::string material;
 			try {
-				attributes = object.at("attributes").as_object().value();
+				material = f->second.as_string().value();
 			} catch (std::exception &) {
-				throw std::runtime_error("Mesh \"" + name + "\"'s attributes should be an object.");
+				throw std::runtime_error("Mesh \"" + name + "\"'s material is not a string.");
 			}
-			object.erase(object.find("attributes"));
+			object.erase(f);
+			pending.meshes.emplace_back(References::MeshReferences{ .mesh = &mesh, .material = material });
+		}
 
-			for (auto const &[key, value] : attributes) {
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = value.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Mesh \"" + name + "\"'s attribute \"" + key + "\" is not an object.");
-				}
+	} else if (type == "CAMERA") {
+		Camera &camera = s72.cameras[name];
+
+		//check that we haven't already parsed this:
+		if (camera.name != "") {
+			throw std::runtime_error("Multiple \"CAMERA\" objects with name \"" + name + "\".");
+		}
 
-				std::string src = extract_string(&obj, "src", "Mesh \"" + name + "\"'s attribute \"" + key + "\"'s src");
-				uint32_t offset = extract_uint32_t(&obj, "offset", "Mesh \"" + name + "\"'s attribute \"" + key + "\"' offset");
-				uint32_t stride = extract_uint32_t(&obj, "stride", "Mesh \"" + name + "\"'s attribute \"" + key + "\"' stride");
-				std::string format = extract_string(&obj, "format", "Mesh \"" + name + "\"'s attribute \"" + key + "\"'s format");
-				mesh.attributes.emplace(key, Mesh::Attribute{
-					.src = s72.data_files[src],
-					.offset = offset,
-					.stride = stride,
-					.format = format_to_VkFormat(format),
-				});
+		//mark as parsed:
+		camera.name = name;
+		add_to_table(s72.tables.cameras, camera);
 
-				warn_on_unhandled(obj, "Mesh \"" + name + "\"'s attribute \"" + key + "\"");
+		bool have_projection = false;
+
+		if (auto f = object.find("perspective"); f != object.end()) {
+			//make sure there aren't multiple projections on this camera:
+			if (have_projection) {
+				throw std::runtime_error("Camera \"" + name + "\" has multiple projections.");
 			}
+			have_projection = true;
 
-			if (auto f = object.find("material"); f != object.end()) {
-				std::string material;
-				try {
-					material = f->second.as_string().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Mesh \"" + name + "\"'s material is not a string.");
-				}
-				object.erase(f);
-				mesh.material = &s72.materials[material];
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = f->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Camera \"" + name + "\"'s projection is not an object.");
 			}
 
-		} else if (type == "CAMERA") {
-			Camera &camera = s72.cameras[name];
+			Camera::Perspective perspective;
 
-			//check that we haven't already parsed this:
-			if (camera.name != "") {
-				throw std::runtime_error("Multiple \"CAMERA\" objects with name \"" + name + "\".");
+			perspective.aspect = extract_float(&obj, "aspect", "Camera \"" + name + "\"'s projection.aspect");
+			perspective.vfov = extract_float(&obj, "vfov", "Camera \"" + name + "\"'s projection.vfov");
+			perspective.near = extract_float(&obj, "near", "Camera \"" + name + "\"'s projection.near");
+			if (obj.contains("far")) {
+				perspective.far = extract_float(&obj, "far", "Camera \"" + name + "\"'s projection.far");
 			}
 
-			//mark as parsed:
-			camera.name = name;
-
-			bool have_projection = false;
+			camera.projection = perspective;
 
-			if (auto f = object.find("perspective"); f != object.end()) {
-				//make sure there aren't multiple projections on this camera:
-				if (have_projection) {
-					throw std::runtime_error("Camera \"" + name + "\" has multiple projections.");
-				}
-				have_projection = true;
+			warn_on_unhandled(obj, "Material \"" + name + "\"'s perspective");
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = f->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Camera \"" + name + "\"'s projection is not an object.");
-				}
+			object.erase(f);
+		}
 
-				Camera::Perspective perspective;
+		if (!have_projection) {
+			throw std::runtime_error("Camera \"" + name + "\" does not have a projection.");
+		}
 
-				perspective.aspect = extract_float(&obj, "aspect", "Camera \"" + name + "\"'s projection.aspect");
-				perspective.vfov = extract_float(&obj, "vfov", "Camera \"" + name + "\"'s projection.vfov");
-				perspective.near = extract_float(&obj, "near", "Camera \"" + name + "\"'s projection.near");
-				if (obj.contains("far")) {
-					perspective.far = extract_float(&obj, "far", "Camera \"" + name + "\"'s projection.far");
-				}
+	} else if (type == "DRIVER") {
+		//NOTE: not building into an existing object because we need to have a node reference ready when constructing.
 
-				camera.projection = perspective;
+		std::string node = extract_string(&object, "node", "Driver \"" + name + "\"'s node");
 
-				warn_on_unhandled(obj, "Material \"" + name + "\"'s perspective");
+		Driver::Channel channel;
+		{ //get channel:
+			static std::map< std::string, Driver::Channel > string_to_channel{
+				{"translation", Driver::Channel::translation},
+				{"rotation", Driver::Channel::rotation},
+				{"scale", Driver::Channel::scale},
+			};
 
-				object.erase(f);
+			std::string str = extract_string(&object, "channel", "Driver \"" + name + "\"'s channel");
+			try {
+				channel = string_to_channel.at(str);
+			} catch (std::exception &) {
+				throw std::runtime_error("Driver \"" + name + "\"'s channel \"" + str + "\" is not a recognized channel name.");
 			}
+		}
 
-			if (!have_projection) {
-				throw std::runtime_error("Camera \"" + name + "\" does not have a projection.");
+		std::vector< float > times = extract_float_vector(&object, "times", "Driver \"" + name + "\"'s times");
+		for (size_t t = 1; t < times.size(); ++t) {
+			if (times[t-1] > times[t]) {
+				throw std::runtime_error("Driver \"" + name + "\"'s times are not non-decreasing.");
 			}
+		}
 
-		} else if (type == "DRIVER") {
-			//NOTE: not building into an existing object because we need to have a node reference ready when constructing.
+		std::vector< float > values = extract_float_vector(&object, "values", "Driver \"" + name + "\"'s values");
 
-			std::string node = extract_string(&object, "node", "Driver \"" + name + "\"'s node");
+		//check that times/values counts are consistent with channel type:
+		if (channel == Driver::Channel::translation || channel == Driver::Channel::scale) {
+			if (times.size() * 3 != values.size()) {
+				throw std::runtime_error("Driver \"" + name + "\" doesn't have times * 3 values.");
+			}
+		} else if (channel == Driver::Channel::rotation) {
+			if (times.size() * 4 != values.size()) {
+				throw std::runtime_error("Driver \"" + name + "\" doesn't have times * 4 values.");
+			}
+		} else {
+			assert(0 && "unreachable case");
+		}
 
-			Driver::Channel channel;
-			{ //get channel:
-				static std::map< std::string, Driver::Channel > string_to_channel{
-					{"translation", Driver::Channel::translation},
-					{"rotation", Driver::Channel::rotation},
-					{"scale", Driver::Channel::scale},
-				};
+		Driver::Interpolation interpolation = Driver::Interpolation::LINEAR;
+		if(object.contains("interpolation")){
+			static std::map< std::string, Driver::Interpolation > string_to_interpolation{
+				{"STEP", Driver::Interpolation::STEP},
+				{"LINEAR", Driver::Interpolation::LINEAR},
+				{"SLERP", Driver::Interpolation::SLERP},
+			};
 
-				std::string str = extract_string(&object, "channel", "Driver \"" + name + "\"'s channel");
-				try {
-					channel = string_to_channel.at(str);
-				} catch (std::exception &) {
-					throw std::runtime_error("Driver \"" + name + "\"'s channel \"" + str + "\" is not a recognized channel name.");
-				}
+			std::string str = extract_string(&object, "interpolation", "Driver \"" + name + "\"'s interpolation");
+			try {
+				interpolation = string_to_interpolation.at(str);
+			} catch (std::exception &) {
+				throw std::runtime_error("Driver \"" + name + "\"'s interpolation \"" + str + "\" is not a recognized interpolation name.");
 			}
+		}
 
-			std::vector< float > times = extract_float_vector(&object, "times", "Driver \"" + name + "\"'s times");
-			for (size_t t = 1; t < times.size(); ++t) {
-				if (times[t-1] > times[t]) {
-					throw std::runtime_error("Driver \"" + name + "\"'s times are not non-decreasing.");
-				}
+		pending.drivers.emplace_back(References::DriverReferences{
+			.name = name,
+			.node = node,
+			.channel = channel,
+			.times = std::move(times),
+			.values = std::move(values),
+			.interpolation = interpolation,
+		});
+	} else if (type == "MATERIAL") {
+		Material &material = s72.materials[name];
+		//check that we haven't already parsed this:
+		if (material.name != "") {
+			throw std::runtime_error("Multiple \"MATERIAL\" objects with name \"" + name + "\".");
+		}
+
+		//mark as parsed:
+		material.name = name;
+		add_to_table(s72.tables.materials, material);
+
+		if (object.contains("normalMap")) {
+			material.normal_map = &extract_map(&object, "normalMap", &s72, "Material \"" + name + "\"'s normalMap");
+		}
+		if (object.contains("displacementMap")) {
+			material.displacement_map = &extract_map(&object, "displacementMap", &s72, "Material \"" + name + "\"'s displacementMap");
+		}
+
+		bool have_brdf = false;
+
+		if (auto b = object.find("pbr"); b != object.end()) {
+			if (have_brdf) {
+				throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
 			}
+			have_brdf = true;
 
-			std::vector< float > values = extract_float_vector(&object, "values", "Driver \"" + name + "\"'s values");
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = b->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Material \"" + name + "\"'s pbr is not an object.");
+			}
 
-			//check that times/values counts are consistent with channel type:
-			if (channel == Driver::Channel::translation || channel == Driver::Channel::scale) {
-				if (times.size() * 3 != values.size()) {
-					throw std::runtime_error("Driver \"" + name + "\" doesn't have times * 3 values.");
-				}
-			} else if (channel == Driver::Channel::rotation) {
-				if (times.size() * 4 != values.size()) {
-					throw std::runtime_error("Driver \"" + name + "\" doesn't have times * 4 values.");
+			Material::PBR pbr;
+
+			if (auto f = obj.find("albedo"); f != obj.end()) {
+				if (std::optional< std::vector< sejp::value > > arr = f->second.as_array()) {
+					//3-vector of color
+					try {
+						std::vector< sejp::value > const &vec = arr.value();
+						pbr.albedo = color{
+							.r = float(vec.at(0).as_number().value()),
+							.g = float(vec.at(1).as_number().value()),
+							.b = float(vec.at(2).as_number().value()),
+						};
+						if (vec.size() != 3) throw std::runtime_error("trailing values");
+					} catch (std::exception &) {
+						throw std::runtime_error("Material \"" + name + "\"'s pbr.albedo was an array but it didn't hold exactly three numbers.");
+					}
+					obj.erase(f);
+				} else {
+					pbr.albedo = &extract_map(&obj, "albedo", &s72, "Material \"" + name + "\"'s pbr.albedo");
 				}
-			} else {
-				assert(0 && "unreachable case");
 			}
 
-			Driver::Interpolation interpolation = Driver::Interpolation::LINEAR;
-			if(object.contains("interpolation")){
-				static std::map< std::string, Driver::Interpolation > string_to_interpolation{
-					{"STEP", Driver::Interpolation::STEP},
-					{"LINEAR", Driver::Interpolation::LINEAR},
-					{"SLERP", Driver::Interpolation::SLERP},
-				};
-
-				std::string str = extract_string(&object, "interpolation", "Driver \"" + name + "\"'s interpolation");
-				try {
-					interpolation = string_to_interpolation.at(str);
-				} catch (std::exception &) {
-					throw std::runtime_error("Driver \"" + name + "\"'s interpolation \"" + str + "\" is not a recognized interpolation name.");
+			if (auto f = obj.find("roughness"); f != obj.end()) {
+				if (std::optional< double > number = f->second.as_number()) {
+					pbr.roughness = float(number.value());
+					obj.erase(f);
+				} else {
+					pbr.roughness = &extract_map(&obj, "roughness", &s72, "Material \"" + name + "\"'s pbr.roughness");
 				}
 			}
 
-			s72.drivers.emplace_back(Driver{
-				.name = name,
-				.node = s72.nodes[node],
-				.channel = channel,
-				.times = std::move(times),
-				.values = std::move(values),
-				.interpolation = interpolation,
-			});
-		} else if (type == "MATERIAL") {
-			Material &material = s72.materials[name];
-			//check that we haven't already parsed this:
-			if (material.name != "") {
-				throw std::runtime_error("Multiple \"MATERIAL\" objects with name \"" + name + "\".");
+			if (auto f = obj.find("metalness"); f != obj.end()) {
+				if (std::optional< double > number = f->second.as_number()) {
+					pbr.metalness = float(number.value());
+					obj.erase(f);
+				} else {
+					pbr.metalness = &extract_map(&obj, "metalness", &s72, "Material \"" + name + "\"'s pbr.metalness");
+				}
 			}
 
-			//mark as parsed:
-			material.name = name;
+			material.brdf = pbr;
 
-			if (object.contains("normalMap")) {
-				material.normal_map = &extract_map(&object, "normalMap", &s72, "Material \"" + name + "\"'s normalMap");
-			}
-			if (object.contains("displacementMap")) {
-				material.displacement_map = &extract_map(&object, "displacementMap", &s72, "Material \"" + name + "\"'s displacementMap");
-			}
+			warn_on_unhandled(obj, "Material \"" + name + "\"'s pbr");
 
-			bool have_brdf = false;
+			object.erase(b);
+		}
 
-			if (auto b = object.find("pbr"); b != object.end()) {
-				if (have_brdf) {
-					throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
-				}
-				have_brdf = true;
+		if (auto b = object.find("lambertian"); b != object.end()) {
+			if (have_brdf) {
+				throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
+			}
+			have_brdf = true;
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = b->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Material \"" + name + "\"'s pbr is not an object.");
-				}
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = b->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Material \"" + name + "\"'s lambertian is not an object.");
+			}
 
-				Material::PBR pbr;
-
-				if (auto f = obj.find("albedo"); f != obj.end()) {
-					if (std::optional< std::vector< sejp::value > > arr = f->second.as_array()) {
-						//3-vector of color
-						try {
-							std::vector< sejp::value > const &vec = arr.value();
-							pbr.albedo = color{
-								.r = float(vec.at(0).as_number().value()),
-								.g = float(vec.at(1).as_number().value()),
-								.b = float(vec.at(2).as_number().value()),
-							};
-							if (vec.size() != 3) throw std::runtime_error("trailing values");
-						} catch (std::exception &) {
-							throw std::runtime_error("Material \"" + name + "\"'s pbr.albedo was an array but it didn't hold exactly three numbers.");
-						}
-						obj.erase(f);
-					} else {
-						pbr.albedo = &extract_map(&obj, "albedo", &s72, "Material \"" + name + "\"'s pbr.albedo");
+			Material::Lambertian lambertian;
+
+			if (auto f = obj.find("albedo"); f != obj.end()) {
+				if (std::optional< std::vector< sejp::value > > arr = f->second.as_array()) {
+					//3-vector of color
+					try {
+						std::vector< sejp::value > const &vec = arr.value();
+						lambertian.albedo = color{
+							.r = float(vec.at(0).as_number().value()),
+							.g = float(vec.at(1).as_number().value()),
+							.b = float(vec.at(2).as_number().value()),
+						};
+						if (vec.size() != 3) throw std::runtime_error("trailing values");
+					} catch (std::exception &) {
+						throw std::runtime_error("Material \"" + name + "\"'s lambertian.albedo was an array but it didn't hold exactly three numbers.");
 					}
+					obj.erase(f);
+				} else {
+					lambertian.albedo = &extract_map(&obj, "albedo", &s72, "Material \"" + name + "\"'s lambertian.albedo");
 				}
+			}
 
-				if (auto f = obj.find("roughness"); f != obj.end()) {
-					if (std::optional< double > number = f->second.as_number()) {
-						pbr.roughness = float(number.value());
-						obj.erase(f);
-					} else {
-						pbr.roughness = &extract_map(&obj, "roughness", &s72, "Material \"" + name + "\"'s pbr.roughness");
-					}
-				}
+			material.brdf = lambertian;
 
-				if (auto f = obj.find("metalness"); f != obj.end()) {
-					if (std::optional< double > number = f->second.as_number()) {
-						pbr.metalness = float(number.value());
-						obj.erase(f);
-					} else {
-						pbr.metalness = &extract_map(&obj, "metalness", &s72, "Material \"" + name + "\"'s pbr.metalness");
-					}
-				}
+			warn_on_unhandled(obj, "Material \"" + name + "\"'s lambertian");
 
-				material.brdf = pbr;
+			object.erase(b);
+		}
 
-				warn_on_unhandled(obj, "Material \"" + name + "\"'s pbr");
+		if (auto b = object.find("mirror"); b != object.end()) {
+			if (have_brdf) {
+				throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
+			}
+			have_brdf = true;
 
-				object.erase(b);
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = b->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Material \"" + name + "\"'s mirror is not an object.");
 			}
 
-			if (auto b = object.find("lambertian"); b != object.end()) {
-				if (have_brdf) {
-					throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
-				}
-				have_brdf = true;
+			Material::Mirror mirror;
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = b->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Material \"" + name + "\"'s lambertian is not an object.");
-				}
+			//no properties!
 
-				Material::Lambertian lambertian;
-
-				if (auto f = obj.find("albedo"); f != obj.end()) {
-					if (std::optional< std::vector< sejp::value > > arr = f->second.as_array()) {
-						//3-vector of color
-						try {
-							std::vector< sejp::value > const &vec = arr.value();
-							lambertian.albedo = color{
-								.r = float(vec.at(0).as_number().value()),
-								.g = float(vec.at(1).as_number().value()),
-								.b = float(vec.at(2).as_number().value()),
-							};
-							if (vec.size() != 3) throw std::runtime_error("trailing values");
-						} catch (std::exception &) {
-							throw std::runtime_error("Material \"" + name + "\"'s lambertian.albedo was an array but it didn't hold exactly three numbers.");
-						}
-						obj.erase(f);
-					} else {
-						lambertian.albedo = &extract_map(&obj, "albedo", &s72, "Material \"" + name + "\"'s lambertian.albedo");
-					}
-				}
+			material.brdf = mirror;
 
-				material.brdf = lambertian;
+			warn_on_unhandled(obj, "Material \"" + name + "\"'s mirror");
 
-				warn_on_unhandled(obj, "Material \"" + name + "\"'s lambertian");
+			object.erase(b);
+		}
 
-				object.erase(b);
+		if (auto b = object.find("environment"); b != object.end()) {
+			if (have_brdf) {
+				throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
 			}
+			have_brdf = true;
 
-			if (auto b = object.find("mirror"); b != object.end()) {
-				if (have_brdf) {
-					throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
-				}
-				have_brdf = true;
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = b->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Material \"" + name + "\"'s environment is not an object.");
+			}
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = b->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Material \"" + name + "\"'s mirror is not an object.");
-				}
+			Material::Environment environment;
 
-				Material::Mirror mirror;
+			//no properties!
 
-				//no properties!
+			material.brdf = environment;
 
-				material.brdf = mirror;
+			warn_on_unhandled(obj, "Material \"" + name + "\"'s environment");
 
-				warn_on_unhandled(obj, "Material \"" + name + "\"'s mirror");
+			object.erase(b);
+		}
 
-				object.erase(b);
-			}
+		if (!have_brdf) {
+			throw std::runtime_error("Material \"" + name + "\" does not have a brdf.");
+		}
 
-			if (auto b = object.find("environment"); b != object.end()) {
-				if (have_brdf) {
-					throw std::runtime_error("Material \"" + name + "\" has multiple brdfs.");
-				}
-				have_brdf = true;
+	} else if (type == "ENVIRONMENT"){
+		Environment &environment = s72.environments[name];
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = b->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Material \"" + name + "\"'s environment is not an object.");
-				}
+		//check that we haven't already parsed this:
+		if (environment.name != "") {
+			throw std::runtime_error("Multiple \"ENVIRONMENT\" objects with name \"" + name + "\".");
+		}
 
-				Material::Environment environment;
+		//mark as parsed:
+		environment.name = name;
+		add_to_table(s72.tables.environments, environment);
 
-				//no properties!
+		environment.radiance = &extract_map(&object, "radiance", &s72, "Environment \"" + name + "\"'s radiance");
 
-				material.brdf = environment;
+		if (environment.radiance->type != Texture::Type::cube) {
+			throw std::runtime_error("Environment \"" + name + "\"'s radiance is not a cube.");
+		}
 
-				warn_on_unhandled(obj, "Material \"" + name + "\"'s environment");
+	} else if (type == "LIGHT") {
+		Light &light = s72.lights[name];
 
-				object.erase(b);
-			}
+		//check that we haven't already parsed this:
+		if (light.name != "") {
+			throw std::runtime_error("Multiple \"LIGHT\" objects with name \"" + name + "\".");
+		}
 
-			if (!have_brdf) {
-				throw std::runtime_error("Material \"" + name + "\" does not have a brdf.");
+		//mark as parsed:
+		light.name = name;
+		add_to_table(s72.tables.lights, light);
+
+		if (auto f = object.find("tint"); f != object.end()) {
+			try {
+				std::vector< sejp::value > const &vec = f->second.as_array().value();
+				light.tint = color{
+					.r = float(vec.at(0).as_number().value()),
+					.g = float(vec.at(1).as_number().value()),
+					.b = float(vec.at(2).as_number().value()),
+				};
+				if (vec.size() != 3) throw std::runtime_error("trailing values");
+			} catch (std::exception &) {
+				throw std::runtime_error("Light \"" + name + "\"'s tint was not an array of three numbers.");
 			}
+			object.erase(f);
+		}
+		if (object.contains("shadow")){
+			light.shadow = extract_uint32_t(&object, "shadow", "Light \"" + name + "\"'s shadow");
+		}
 
-		} else if (type == "ENVIRONMENT"){
-			Environment &environment = s72.environments[name];
+		bool have_source = false;
 
-			//check that we haven't already parsed this:
-			if (environment.name != "") {
-				throw std::runtime_error("Multiple \"ENVIRONMENT\" objects with name \"" + name + "\".");
+		if (auto f = object.find("sun"); f != object.end()) {
+			if (have_source) {
+				throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
+			}
+			have_source = true;
+
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = f->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Light \"" + name + "\"'s sun is not an object.");
 			}
 
-			//mark as parsed:
-			environment.name = name;
+			Light::Sun sun;
+
+			sun.angle = extract_float(&obj, "angle", "Light \"" + name + "\"'s sun's angle");
+			sun.strength = extract_float(&obj, "strength", "Light \"" + name + "\"'s sun's strength");
 
-			environment.radiance = &extract_map(&object, "radiance", &s72, "Environment \"" + name + "\"'s radiance");
+			light.source = sun;
 
-			if (environment.radiance->type != Texture::Type::cube) {
-				throw std::runtime_error("Environment \"" + name + "\"'s radiance is not a cube.");
+			warn_on_unhandled(obj, "Light \"" + name + "\"'s sun");
+			object.erase(f);
+		}
+		if (auto f = object.find("sphere"); f != object.end()) {
+			if (have_source) {
+				throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
 			}
+			have_source = true;
 
-		} else if (type == "LIGHT") {
-			Light &light = s72.lights[name];
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = f->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Light \"" + name + "\"'s sphere is not an object.");
+			}
+
+			Light::Sphere sphere;
 
-			//check that we haven't already parsed this:
-			if (light.name != "") {
-				throw std::runtime_error("Multiple \"LIGHT\" objects with name \"" + name + "\".");
+			sphere.radius = extract_float(&obj, "radius", "Light \"" + name + "\"'s sphere's radius");
+			sphere.power = extract_float(&obj, "power", "Light \"" + name + "\"'s sphere's power");
+			if (obj.contains("limit")) {
+				sphere.limit = extract_float(&obj, "limit", "Light \"" + name + "\"'s sphere's limit");
 			}
 
-			//mark as parsed:
-			light.name = name;
+			light.source = sphere;
 
-			if (auto f = object.find("tint"); f != object.end()) {
-				try {
-					std::vector< sejp::value > const &vec = f->second.as_array().value();
-					light.tint = color{
-						.r = float(vec.at(0).as_number().value()),
-						.g = float(vec.at(1).as_number().value()),
-						.b = float(vec.at(2).as_number().value()),
-					};
-					if (vec.size() != 3) throw std::runtime_error("trailing values");
-				} catch (std::exception &) {
-					throw std::runtime_error("Light \"" + name + "\"'s tint was not an array of three numbers.");
-				}
-				object.erase(f);
+			warn_on_unhandled(obj, "Light \"" + name + "\"'s sphere");
+			object.erase(f);
+		}
+		if (auto f = object.find("spot"); f != object.end()) {
+			if (have_source) {
+				throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
 			}
-			if (object.contains("shadow")){
-				light.shadow = extract_uint32_t(&object, "shadow", "Light \"" + name + "\"'s shadow");
+			have_source = true;
+
+			std::map< std::string, sejp::value > obj;
+			try {
+				obj = f->second.as_object().value();
+			} catch (std::exception &) {
+				throw std::runtime_error("Light \"" + name + "\"'s spot is not an object.");
 			}
 
-			bool have_source = false;
+			Light::Spot spot;
 
-			if (auto f = object.find("sun"); f != object.end()) {
-				if (have_source) {
-					throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
-				}
-				have_source = true;
+			spot.radius = extract_float(&obj, "radius", "Light \"" + name + "\"'s spot's radius");
+			spot.power = extract_float(&obj, "power", "Light \"" + name + "\"'s spot's power");
+			if (obj.contains("limit")) {
+				spot.limit = extract_float(&obj, "limit", "Light \"" + name + "\"'s spot's limit");
+			}
+			spot.fov = extract_float(&obj, "fov", "Light \"" + name + "\"'s spot's fov");
+			spot.blend = extract_float(&obj, "blend", "Light \"" + name + "\"'s spot's blend");
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = f->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Light \"" + name + "\"'s sun is not an object.");
-				}
+			light.source = spot;
 
-				Light::Sun sun;
+			warn_on_unhandled(obj, "Light \"" + name + "\"'s spot");
+			object.erase(f);
+		}
 
-				sun.angle = extract_float(&obj, "angle", "Light \"" + name + "\"'s sun's angle");
-				sun.strength = extract_float(&obj, "strength", "Light \"" + name + "\"'s sun's strength");
+		if (!have_source) {
+			throw std::runtime_error("Light \"" + name + "\" is missing a source.");
+		}
+	} else {
+		std::cerr << "WARNING: ignoring object \"" << name << "\" of unrecognized type \"" << type << "\"." << std::endl;
+	}
+	warn_on_unhandled(object, "Object \"" + name + "\"");
+}
 
-				light.source = sun;
+//streams the top-level array of a scene file, handing objects to a pool as they complete:
+// (so only the object being parsed and a bounded number of queued ones are ever held as sejp values)
+//
+//objects are created in batches of consecutive objects of one type:
+// - NODE batches -- usually the bulk of a scene -- run independently, each into its own S72,
+//   and finish() merges them in file order;
+// - batches of each other type run one after another (see Lane) and write straight into s72 + pending,
+//   which is safe because each type touches its own members of those
+//   (MATERIAL and ENVIRONMENT share a lane, since both create textures; DRIVER only records references).
+//each batch stops at its first error, and finish() throws the one from the earliest element,
+// so the result (including which error is reported) doesn't depend on scheduling.
+struct SceneStream final : sejp::handler {
+	SceneStream(S72 &s72_, ThreadPool &pool_) : s72(s72_), pool(pool_) { }
+	~SceneStream() {
+		//jobs refer to the stream, so wait for them even if parsing failed:
+		for (Batch &batch : batches) {
+			if (batch.done.valid()) batch.done.wait();
+		}
+	}
+	S72 &s72;
+	ThreadPool &pool;
+	References pending;
+
+	uint32_t depth = 0; //1 => directly inside the top-level array
+	size_t index = 0; //of the current element in the top-level array
+	bool done = false; //top-level array has been closed
+	std::optional< sejp::builder > object; //element being collected
+
+	static constexpr size_t BatchSize = 256; //objects per batch
+
+	struct Batch {
+		std::vector< std::pair< size_t, sejp::value > > elements; //(index in top-level array, object); cleared once created
+		std::vector< size_t > created; //indices of the elements created without error
+		std::unique_ptr< S72 > nodes; //NODE batches only: scene the nodes are created into
+		References node_pending; //NODE batches only: references from those nodes
+		std::exception_ptr error; //first error, if any
+		size_t error_index = 0; //element that threw it
+		std::shared_future< void > done;
+	};
+	std::deque< Batch > batches; //(deque => stable addresses as batches are added)
+	std::deque< Batch * > in_flight; //queued batches, oldest first (some may have finished)
 
-				warn_on_unhandled(obj, "Light \"" + name + "\"'s sun");
-				object.erase(f);
-			}
-			if (auto f = object.find("sphere"); f != object.end()) {
-				if (have_source) {
-					throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
-				}
-				have_source = true;
+	struct Lane {
+		Batch *collecting = nullptr; //batch being filled, if any
+		std::shared_future< void > last; //most recently queued batch
+		bool failed = false; //a batch threw, so skip the rest (only touched by the lane's jobs, which run in order)
+	};
+	enum : uint32_t { OtherLane, MeshLane, CameraLane, DriverLane, MaterialLane, LightLane, LaneCount };
+	std::array< Lane, LaneCount > lanes; //(OtherLane also gets SCENE objects and anything with an unknown/missing type)
+	Lane node_lane; //(only 'collecting' is used, since NODE batches are independent)
+
+	void add(size_t i, sejp::value &&element) {
+		static std::unordered_map< std::string_view, uint32_t > const type_to_lane{
+			{"MESH", MeshLane},
+			{"CAMERA", CameraLane},
+			{"DRIVER", DriverLane},
+			{"MATERIAL", MaterialLane},
+			{"ENVIRONMENT", MaterialLane},
+			{"LIGHT", LightLane},
+		};
+		std::optional< std::string_view > type;
+		if (auto obj = element.as_object_view()) {
+			if (auto value = obj->find("type")) type = value->as_string_view();
+		}
+		Lane *lane = &lanes[OtherLane];
+		if (type == "NODE") {
+			lane = &node_lane;
+		} else if (type) {
+			if (auto f = type_to_lane.find(*type); f != type_to_lane.end()) lane = &lanes[f->second];
+		}
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = f->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Light \"" + name + "\"'s sphere is not an object.");
-				}
+		if (!lane->collecting) {
+			lane->collecting = &batches.emplace_back();
+			lane->collecting->elements.reserve(BatchSize);
+		}
+		lane->collecting->elements.emplace_back(i, std::move(element));
+		if (lane->collecting->elements.size() == BatchSize) queue(*lane);
+	}
 
-				Light::Sphere sphere;
+	void queue(Lane &lane) {
+		if (!lane.collecting) return;
+		Batch &batch = *lane.collecting;
+		lane.collecting = nullptr;
 
-				sphere.radius = extract_float(&obj, "radius", "Light \"" + name + "\"'s sphere's radius");
-				sphere.power = extract_float(&obj, "power", "Light \"" + name + "\"'s sphere's power");
-				if (obj.contains("limit")) {
-					sphere.limit = extract_float(&obj, "limit", "Light \"" + name + "\"'s sphere's limit");
+		//don't get too far ahead of the pool (bounds the memory held by queued objects):
+		// (a batch only waits on ones queued before it, so this can't deadlock)
+		while (in_flight.size() > 2 * pool.size() + 2) {
+			in_flight.front()->done.wait();
+			in_flight.pop_front();
+		}
+
+		auto create = [&batch](S72 &into, References &refs) {
+			for (auto &[i, element] : batch.elements) {
+				try {
+					load_object(into, element, i, &refs);
+				} catch (...) {
+					batch.error = std::current_exception();
+					batch.error_index = i;
+					break;
 				}
+				batch.created.emplace_back(i);
+			}
+			batch.elements.clear();
+			batch.elements.shrink_to_fit();
+		};
 
-				light.source = sphere;
+		if (&lane == &node_lane) {
+			batch.nodes = std::make_unique< S72 >();
+			batch.done = pool.run([&batch, create](){
+				create(*batch.nodes, batch.node_pending);
+			}).share();
+		} else {
+			batch.done = pool.run([this, &lane, &batch, create, previous = lane.last](){
+				if (previous.valid()) previous.wait();
+				if (lane.failed) {
+					batch.elements.clear();
+					return;
+				}
+				create(s72, pending);
+				if (batch.error) lane.failed = true;
+			}).share();
+			lane.last = batch.done;
+		}
+		in_flight.emplace_back(&batch);
+	}
 
-				warn_on_unhandled(obj, "Light \"" + name + "\"'s sphere");
-				object.erase(f);
+	//create the remaining objects, merge NODE batches, and construct drivers:
+	//  NOTE: call once parsing stops, even if it stopped with an error (an object before that error may have its own)
+	void finish() {
+		for (Lane &lane : lanes) queue(lane);
+		queue(node_lane);
+		for (Batch &batch : batches) batch.done.wait();
+		in_flight.clear();
+
+		//earliest error from any batch or from merging:
+		std::exception_ptr error;
+		size_t error_index = 0;
+		auto failed = [&](std::exception_ptr const &e, size_t i) {
+			if (e && (!error || i < error_index)) {
+				error = e;
+				error_index = i;
 			}
-			if (auto f = object.find("spot"); f != object.end()) {
-				if (have_source) {
-					throw std::runtime_error("Light \"" + name + "\" has multiple sources.");
-				}
-				have_source = true;
+		};
+		for (Batch const &batch : batches) {
+			failed(batch.error, batch.error_index);
+		}
 
-				std::map< std::string, sejp::value > obj;
-				try {
-					obj = f->second.as_object().value();
-				} catch (std::exception &) {
-					throw std::runtime_error("Light \"" + name + "\"'s spot is not an object.");
+		//move nodes into s72 in file order (node handles keep addresses, so node_pending stays valid):
+		size_t node_count = 0;
+		for (Batch const &batch : batches) {
+			if (batch.nodes) node_count += batch.nodes->tables.nodes.size();
+		}
+		s72.nodes.reserve(node_count);
+		s72.tables.nodes.reserve(node_count);
+		pending.nodes.reserve(node_count);
+		for (Batch &batch : batches) {
+			if (!batch.nodes) continue;
+			//(a NODE batch's objects are all nodes, so batch.created[n] is the element that created tables.nodes[n])
+			std::vector< S72::Node * > const &created = batch.nodes->tables.nodes;
+			for (size_t n = 0; n < created.size(); ++n) {
+				std::string const &name = created[n]->name;
+				auto result = s72.nodes.insert(batch.nodes->nodes.extract(name));
+				if (!result.inserted) {
+					//(later duplicates come from later elements, so only the first matters)
+					failed(std::make_exception_ptr(std::runtime_error("Multiple \"NODE\" objects with name \"" + result.node.key() + "\".")), batch.created[n]);
+					break;
 				}
+				add_to_table(s72.tables.nodes, result.position->second);
+			}
+			pending.nodes.insert(pending.nodes.end(), batch.node_pending.nodes.begin(), batch.node_pending.nodes.end());
+		}
+		batches.clear();
+
+		if (error) std::rethrow_exception(error);
+
+		s72.drivers.reserve(pending.drivers.size());
+		pending.driver_nodes.reserve(pending.drivers.size());
+		for (References::DriverReferences &refs : pending.drivers) {
+			pending.driver_nodes.emplace_back(refs.node);
+			s72.drivers.emplace_back(S72::Driver{
+				.name = std::move(refs.name),
+				.node = s72.nodes[refs.node], //NOTE: creates an empty node if not defined; checked when resolving
+				.channel = refs.channel,
+				.times = std::move(refs.times),
+				.values = std::move(refs.values),
+				.interpolation = refs.interpolation,
+			});
+		}
+		pending.drivers.clear();
+	}
 
-				Light::Spot spot;
+	//a value that isn't an object directly in the top-level array:
+	void element() {
+		if (depth == 0) throw std::runtime_error("Top-level value of s72 file should be an array.");
+		if (index == 0) throw std::runtime_error("First element of s72 array should be \"s72-v2\".");
+		throw std::runtime_error("Array element " + std::to_string(index) + " is not an object.");
+	}
 
-				spot.radius = extract_float(&obj, "radius", "Light \"" + name + "\"'s spot's radius");
-				spot.power = extract_float(&obj, "power", "Light \"" + name + "\"'s spot's power");
-				if (obj.contains("limit")) {
-					spot.limit = extract_float(&obj, "limit", "Light \"" + name + "\"'s spot's limit");
-				}
-				spot.fov = extract_float(&obj, "fov", "Light \"" + name + "\"'s spot's fov");
-				spot.blend = extract_float(&obj, "blend", "Light \"" + name + "\"'s spot's blend");
+	void begin_object() override {
+		if (depth == 1) {
+			if (index == 0) element();
+			object.emplace();
+		}
+		if (depth == 0) element();
+		depth += 1;
+		object->begin_object();
+	}
+	void key(std::string_view key) override {
+		object->key(key);
+	}
+	void end_object() override {
+		object->end_object();
+		depth -= 1;
+		if (depth == 1) {
+			add(index, object->finish());
+			object.reset();
+			index += 1;
+		}
+	}
+	void begin_array() override {
+		if (depth == 0) {
+			depth = 1;
+			return;
+		}
+		if (depth == 1) element();
+		depth += 1;
+		object->begin_array();
+	}
+	void end_array() override {
+		if (depth == 1) {
+			if (index == 0) element(); //(empty top-level array)
+			depth = 0;
+			done = true;
+			return;
+		}
+		depth -= 1;
+		object->end_array();
+	}
+	void string(std::string_view string) override {
+		if (depth == 1 && index == 0) {
+			if (string != "s72-v2") element();
+			index += 1;
+			return;
+		}
+		if (depth <= 1) element();
+		object->string(string);
+	}
+	void number(double number) override {
+		if (depth <= 1) element();
+		object->number(number);
+	}
+	void boolean(bool boolean) override {
+		if (depth <= 1) element();
+		object->boolean(boolean);
+	}
+	void null() override {
+		if (depth <= 1) element();
+		object->null();
+	}
+	void numbers(std::span< double const > numbers) override {
+		if (depth <= 1) element();
+		object->numbers(numbers);
+	}
+};
 
-				light.source = spot;
+S72 S72::load(std::string const &scene_file, LoadTimings *timings) {
 
-				warn_on_unhandled(obj, "Light \"" + name + "\"'s spot");
-				object.erase(f);
-			}
+	S72 s72; //the loaded scene, will be returned at end of function
 
-			if (!have_source) {
-				throw std::runtime_error("Light \"" + name + "\" is missing a source.");
-			}
-		} else {
-			std::cerr << "WARNING: ignoring object \"" << name << "\" of unrecognized type \"" << type << "\"." << std::endl;
+	//work is split up by object type and run on a pool:
+	// jobs write to disjoint objects (and, after parsing, only read the now-fixed object maps),
+	// and errors are reported for the earliest object / lowest-numbered job, so results don't depend on scheduling.
+	ThreadPool pool;
+
+	//create objects as they stream out of the file:
+	SceneStream stream(s72, pool);
+	{
+		Timer timer([&](double elapsed){ if (timings) timings->parse = elapsed * 1000.0; });
+		try {
+			sejp::load(scene_file, stream);
+		} catch (...) {
+			stream.finish(); //(throws instead if an object before the parse error had an error of its own)
+			throw;
 		}
-		warn_on_unhandled(object, "Object \"" + name + "\"");
+		assert(stream.done);
+		stream.finish();
 	}
+	References &pending = stream.pending;
+
+	//-----------------------------------------------------------------------
+	//resolve (and check) references between objects
 
+	{
+		Timer timer([&](double elapsed){ if (timings) timings->resolve = elapsed * 1000.0; });
+
+		//lookup helper, null if not defined (nodes created by a driver's reference but never defined have an empty name):
+		auto lookup = [](auto &map, std::string const &name) -> decltype(&map.begin()->second) {
+			auto f = map.find(name);
+			if (f == map.end() || f->second.name == "") return nullptr;
+			return &f->second;
+		};
+		auto undefined = [](std::string const &what, std::string const &name) {
+			return std::runtime_error(what + " refers to \"" + name + "\", which is not defined.");
+		};
+
+		constexpr size_t NodesPerJob = 4096;
+		uint32_t node_jobs = uint32_t((pending.nodes.size() + NodesPerJob - 1) / NodesPerJob);
+
+		std::vector< std::function< void() > > jobs;
+		jobs.emplace_back([&](){
+			s72.scene.roots.reserve(pending.scene_roots.size());
+			for (std::string const &ref : pending.scene_roots) {
+				Node *root = lookup(s72.nodes, ref);
+				if (!root) throw undefined("Scene \"" + s72.scene.name + "\"'s roots", ref);
+				s72.scene.roots.emplace_back(root);
+			}
+		});
+		for (uint32_t j = 0; j < node_jobs; ++j) {
+			jobs.emplace_back([&, j](){
+				size_t end = std::min(pending.nodes.size(), (j + 1) * NodesPerJob);
+				for (size_t n = j * NodesPerJob; n < end; ++n) {
+					References::NodeReferences const &refs = pending.nodes[n];
+					Node &node = *refs.node;
+					node.children.reserve(refs.children.size());
+					for (std::string const &ref : refs.children) {
+						Node *child = lookup(s72.nodes, ref);
+						if (!child) throw undefined("Node \"" + node.name + "\"'s children", ref);
+						node.children.emplace_back(child);
+					}
+					if (refs.mesh != "" && !(node.mesh = lookup(s72.meshes, refs.mesh))) {
+						throw undefined("Node \"" + node.name + "\"'s mesh", refs.mesh);
+					}
+					if (refs.camera != "" && !(node.camera = lookup(s72.cameras, refs.camera))) {
+						throw undefined("Node \"" + node.name + "\"'s camera", refs.camera);
+					}
+					if (refs.environment != "" && !(node.environment = lookup(s72.environments, refs.environment))) {
+						throw undefined("Node \"" + node.name + "\"'s environment", refs.environment);
+					}
+					if (refs.light != "" && !(node.light = lookup(s72.lights, refs.light))) {
+						throw undefined("Node \"" + node.name + "\"'s light", refs.light);
+					}
+				}
+			});
+		}
+		jobs.emplace_back([&](){
+			for (References::MeshReferences const &refs : pending.meshes) {
+				refs.mesh->material = lookup(s72.materials, refs.material);
+				if (!refs.mesh->material) throw undefined("Mesh \"" + refs.mesh->name + "\"'s material", refs.material);
+			}
+		});
+		jobs.emplace_back([&](){
+			for (size_t d = 0; d < s72.drivers.size(); ++d) {
+				if (s72.drivers[d].node.name == "") {
+					throw undefined("Driver \"" + s72.drivers[d].name + "\"'s node", pending.driver_nodes[d]);
+				}
+			}
+		});
+
+		pool.run_all(uint32_t(jobs.size()), [&](uint32_t j){ jobs[j](); });
+	}
 
 	//-----------------------------------------------------------------------
 	//fix up paths for Datafiles and Textures to be relative to the s72 file
 
+	Timer timer([&](double elapsed){ if (timings) timings->paths = elapsed * 1000.0; });
+
 	std::string scene_folder = "";
 	{ //extract prefix for relative paths:
 		auto pos = scene_file.find_last_of("\\/");
@@ -958,16 +1362,20 @@ S72 S72::load(std::string const &scene_file) {
 		}
 	}
 
-	//data files are just empty objects, but in a map with keys = src:
-	for (auto &[key, value] : s72.data_files) {
-		value.src = key;
-		value.path = scene_folder + value.src;
-	}
-
-	//textures are already populated with src, type, format; just need to set path:
-	for (auto &[key, value] : s72.textures) {
-		value.path = scene_folder + value.src;
-	}
+	pool.run_all(2, [&](uint32_t j){
+		if (j == 0) {
+			//data files are just empty objects, but in a map with keys = src:
+			for (auto &[key, value] : s72.data_files) {
+				value.src = key;
+				value.path = scene_folder + value.src;
+			}
+		} else {
+			//textures are already populated with src, type, format; just need to set path:
+			for (auto &[key, value] : s72.textures) {
+				value.path = scene_folder + value.src;
+			}
+		}
+	});
 
 	return s72;
 }
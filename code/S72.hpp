@@ -20,10 +20,12 @@
  * Represents a scene in s72 format.
  * Specification: https://github.com/15-472/s72
  *
- * - Resolves name-based references to pointers.
+ * - Resolves name-based references to pointers (in parallel, after parsing; throws if a reference is undefined).
  * - Resolves file paths relative to scene file.
  * - DOES NOT attempt to load texture or data files.
  * - Stores objects in name-based dictionaries.
+ * - Also gives every object a dense 32-bit index (in file order) and keeps per-type tables of them,
+ *   so per-object data can live in plain arrays instead of being looked up by name.
  * - Otherwise, represents scene just as in the spec.
  *
  * Usage:
@@ -44,7 +46,14 @@ struct S72 {
 
 	//-------------------------------------------------
 
-	static S72 load(std::string const &file); //NOTE: throws on error
+	//milliseconds spent in each phase of load():
+	struct LoadTimings {
+		double parse = 0.0; //streaming the file and creating objects
+		double resolve = 0.0; //resolving + checking references between objects (parallel)
+		double paths = 0.0; //building DataFile / Texture paths (parallel)
+	};
+
+	static S72 load(std::string const &file, LoadTimings *timings = nullptr); //NOTE: throws on error
 
 	S72() = default; //empty scene
 
@@ -80,6 +89,7 @@ struct S72 {
 	//zero or more "NODE"s, all with unique names:
 	struct Node {
 		std::string name;
+		uint32_t index = 0; //position in tables.nodes
 
 		vec3 translation{0.0f, 0.0f, 0.0f };
 		quat rotation{0.0f, 0.0f, 0.0f, 1.0f};
@@ -98,6 +108,7 @@ struct S72 {
 	//zero or more "MESH"s, all with unique names:
 	struct Mesh {
 		std::string name;
+		uint32_t index = 0; //position in tables.meshes
 
 		VkPrimitiveTopology topology;
 		uint32_t count;
@@ -123,6 +134,7 @@ struct S72 {
 	//data files referenced by meshes:
 	struct DataFile {
 		std::string src; //src used in the s72 file
+		uint32_t index = 0; //position in tables.data_files
 
 		//computed during loading:
 		std::string path; //path to data file, taking into account path to s72 file (relative to current working directory)
@@ -133,6 +145,7 @@ struct S72 {
 	//zero or more "CAMERA"s, all with unique names:
 	struct Camera {
 		std::string name;
+		uint32_t index = 0; //position in tables.cameras
 		mat4 transform = mat4(1.0f);
 		struct Perspective {
 			float aspect;
@@ -175,7 +188,7 @@ struct S72 {
 	//zero or more "MATERIAL"s, all with unique names:
 	struct Material {
 		std::string name;
-		uint32_t index = 0;
+		uint32_t index = 0; //position in tables.materials
 
 		Texture *normal_map = nullptr; //optional, set to null if not specified
 		Texture *displacement_map = nullptr; //optional, set to null if not specified
@@ -200,7 +213,7 @@ struct S72 {
 	//textures referenced by materials:
 	struct Texture {
 		std::string src; //src used in the s72 file
-		uint32_t index = 0;
+		uint32_t index = 0; //position in tables.textures
 		enum class Type {
 			flat, //"2D" in the spec, but identifier can't start with a number
 			cube,
@@ -220,6 +233,7 @@ struct S72 {
 	//zero or more Environments, all with unique names:
 	struct Environment {
 		std::string name;
+		uint32_t index = 0; //position in tables.environments
 
 		Texture *radiance; //NOTE: always of type "cube"; will always be non-null once scene has been loaded
 	};
@@ -228,6 +242,7 @@ struct S72 {
 	//zero or more "LIGHT"s, all with unique names:
 	struct Light {
 		std::string name;
+		uint32_t index = 0; //position in tables.lights
 
 		color tint = color{ .r = 1.0f, .g = 1.0f, .b = 1.0f };
 
@@ -253,4 +268,20 @@ struct S72 {
 		std::variant< Sun, Sphere, Spot > source;
 	};
 	std::unordered_map< std::string, Light > lights;
+
+	//-------------------------------------------------
+	//dense tables, in file order; object.index is its position in the table for its type:
+	// (use these -- or the index -- to address per-object arrays with no string hashing)
+	//NOTE: entries point into the maps above, so they remain valid when the scene is moved
+	struct Tables {
+		std::vector< Node * > nodes;
+		std::vector< Mesh * > meshes;
+		std::vector< DataFile * > data_files;
+		std::vector< Camera * > cameras;
+		std::vector< Material * > materials;
+		std::vector< Texture * > textures;
+		std::vector< Environment * > environments;
+		std::vector< Light * > lights;
+	};
+	Tables tables;
 };
@@ -0,0 +1,691 @@
+#include "SceneCache.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+//bump whenever the layout below changes:
+constexpr char Magic[8] = {'s','7','2','c','a','c','h','e'};
+constexpr uint32_t Version = 2;
+constexpr size_t BlobAlignment = 16;
+
+std::string image_id(std::string const &path, bool flipped) {
+	return (flipped ? "flipped:" : "plain:") + path;
+}
+
+//size + modification time, used to decide if a cached copy of a file is stale:
+struct FileStamp {
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	bool operator==(FileStamp const &o) const { return size == o.size && mtime == o.mtime; }
+};
+bool stamp(std::string const &path, FileStamp *out) {
+	std::error_code ec;
+	auto size = std::filesystem::file_size(path, ec);
+	if (ec) return false;
+	auto time = std::filesystem::last_write_time(path, ec);
+	if (ec) return false;
+	out->size = uint64_t(size);
+	out->mtime = int64_t(time.time_since_epoch().count());
+	return true;
+}
+
+struct Writer {
+	std::vector< uint8_t > bytes;
+
+	template< typename T >
+	void pod(T const &t) {
+		static_assert(std::is_trivially_copyable_v< T >, "pod() is for plain data");
+		uint8_t const *src = reinterpret_cast< uint8_t const * >(&t);
+		bytes.insert(bytes.end(), src, src + sizeof(T));
+	}
+	void u32(uint32_t v) { pod(v); }
+	void f32(float v) { pod(v); }
+	void str(std::string const &s) {
+		u32(uint32_t(s.size()));
+		bytes.insert(bytes.end(), s.begin(), s.end());
+	}
+	void vec3(S72::vec3 const &v) { f32(v.x); f32(v.y); f32(v.z); }
+	void floats(std::vector< float > const &v) {
+		u32(uint32_t(v.size()));
+		for (float f : v) f32(f);
+	}
+	//raw data, aligned so that a mapped copy can be used in place:
+	void blob(void const *data, size_t size) {
+		pod(uint64_t(size));
+		while (bytes.size() % BlobAlignment != 0) bytes.emplace_back(0);
+		uint8_t const *src = reinterpret_cast< uint8_t const * >(data);
+		bytes.insert(bytes.end(), src, src + size);
+	}
+};
+
+struct Reader {
+	uint8_t const *data = nullptr;
+	size_t size = 0;
+	size_t at = 0;
+
+	void need(size_t count) {
+		if (count > size - at) throw std::runtime_error("truncated at byte " + std::to_string(at) + ".");
+	}
+	template< typename T >
+	T pod() {
+		need(sizeof(T));
+		T t;
+		std::memcpy(&t, data + at, sizeof(T));
+		at += sizeof(T);
+		return t;
+	}
+	uint32_t u32() { return pod< uint32_t >(); }
+	float f32() { return pod< float >(); }
+	std::string str() {
+		uint32_t len = u32();
+		need(len);
+		std::string s(reinterpret_cast< char const * >(data + at), len);
+		at += len;
+		return s;
+	}
+	S72::vec3 vec3() {
+		float x = f32(), y = f32(), z = f32();
+		return S72::vec3(x, y, z);
+	}
+	std::vector< float > floats() {
+		uint32_t count = u32();
+		need(size_t(count) * 4);
+		std::vector< float > v(count);
+		std::memcpy(v.data(), data + at, size_t(count) * 4);
+		at += size_t(count) * 4;
+		return v;
+	}
+	uint8_t const *blob(size_t *out_size) {
+		uint64_t blob_size = pod< uint64_t >();
+		at = (at + BlobAlignment - 1) / BlobAlignment * BlobAlignment;
+		if (at > size) throw std::runtime_error("truncated blob.");
+		need(size_t(blob_size));
+		uint8_t const *ret = data + at;
+		at += size_t(blob_size);
+		*out_size = size_t(blob_size);
+		return ret;
+	}
+};
+
+//-------------------------------------------------
+//S72 <-> bytes. References are written as names (empty string => null) and resolved on read.
+
+void write_texture_ref(Writer &w, S72 const &s72, S72::Texture const *texture) {
+	if (texture == nullptr) {
+		w.str("");
+		return;
+	}
+	//textures are keyed by src + type + format; find the key for this one:
+	for (auto const &[key, tex] : s72.textures) {
+		if (&tex == texture) {
+			w.str(key);
+			return;
+		}
+	}
+	throw std::runtime_error("Texture '" + texture->src + "' is not part of the scene.");
+}
+
+void write_scene(Writer &w, S72 const &s72) {
+	w.u32(uint32_t(s72.data_files.size()));
+	for (auto const &[key, file] : s72.data_files) {
+		w.str(key);
+		w.str(file.src);
+		w.u32(file.index);
+		w.str(file.path);
+	}
+
+	w.u32(uint32_t(s72.textures.size()));
+	for (auto const &[key, tex] : s72.textures) {
+		w.str(key);
+		w.str(tex.src);
+		w.u32(tex.index);
+		w.u32(uint32_t(tex.type));
+		w.u32(uint32_t(tex.format));
+		w.str(tex.path);
+	}
+
+	w.u32(uint32_t(s72.materials.size()));
+	for (auto const &[key, mat] : s72.materials) {
+		w.str(key);
+		w.str(mat.name);
+		w.u32(mat.index);
+		write_texture_ref(w, s72, mat.normal_map);
+		write_texture_ref(w, s72, mat.displacement_map);
+
+		//color / float parameters are written as a texture ref (empty for none) followed by the value:
+		auto color_or_texture = [&](std::variant< S72::color, S72::Texture * > const &v) {
+			if (auto tex = std::get_if< S72::Texture * >(&v)) {
+				write_texture_ref(w, s72, *tex);
+				w.f32(0.0f); w.f32(0.0f); w.f32(0.0f);
+			} else {
+				S72::color const &c = std::get< S72::color >(v);
+				w.str("");
+				w.f32(c.r); w.f32(c.g); w.f32(c.b);
+			}
+		};
+		auto float_or_texture = [&](std::variant< float, S72::Texture * > const &v) {
+			if (auto tex = std::get_if< S72::Texture * >(&v)) {
+				write_texture_ref(w, s72, *tex);
+				w.f32(0.0f);
+			} else {
+				w.str("");
+				w.f32(std::get< float >(v));
+			}
+		};
+
+		w.u32(uint32_t(mat.brdf.index()));
+		if (auto pbr = std::get_if< S72::Material::PBR >(&mat.brdf)) {
+			color_or_texture(pbr->albedo);
+			float_or_texture(pbr->roughness);
+			float_or_texture(pbr->metalness);
+		} else if (auto lambertian = std::get_if< S72::Material::Lambertian >(&mat.brdf)) {
+			color_or_texture(lambertian->albedo);
+		}
+	}
+
+	w.u32(uint32_t(s72.meshes.size()));
+	for (auto const &[key, mesh] : s72.meshes) {
+		w.str(key);
+		w.str(mesh.name);
+		w.u32(mesh.index);
+		w.u32(uint32_t(mesh.topology));
+		w.u32(mesh.count);
+		w.u32(mesh.indices ? 1 : 0);
+		if (mesh.indices) {
+			w.str(mesh.indices->src.src);
+			w.u32(mesh.indices->offset);
+			w.u32(uint32_t(mesh.indices->format));
+		}
+		w.u32(uint32_t(mesh.attributes.size()));
+		for (auto const &[name, attribute] : mesh.attributes) {
+			w.str(name);
+			w.str(attribute.src.src);
+			w.u32(attribute.offset);
+			w.u32(attribute.stride);
+			w.u32(uint32_t(attribute.format));
+		}
+		w.str(mesh.material ? mesh.material->name : "");
+	}
+
+	w.u32(uint32_t(s72.cameras.size()));
+	for (auto const &[key, camera] : s72.cameras) {
+		w.str(key);
+		w.str(camera.name);
+		w.u32(camera.index);
+		S72::Camera::Perspective const &p = std::get< S72::Camera::Perspective >(camera.projection);
+		w.f32(p.aspect);
+		w.f32(p.vfov);
+		w.f32(p.near);
+		w.f32(p.far);
+	}
+
+	w.u32(uint32_t(s72.environments.size()));
+	for (auto const &[key, env] : s72.environments) {
+		w.str(key);
+		w.str(env.name);
+		w.u32(env.index);
+		write_texture_ref(w, s72, env.radiance);
+	}
+
+	w.u32(uint32_t(s72.lights.size()));
+	for (auto const &[key, light] : s72.lights) {
+		w.str(key);
+		w.str(light.name);
+		w.u32(light.index);
+		w.f32(light.tint.r); w.f32(light.tint.g); w.f32(light.tint.b);
+		w.u32(light.shadow);
+		w.u32(uint32_t(light.source.index()));
+		if (auto sun = std::get_if< S72::Light::Sun >(&light.source)) {
+			w.f32(sun->angle);
+			w.f32(sun->strength);
+		} else if (auto sphere = std::get_if< S72::Light::Sphere >(&light.source)) {
+			w.f32(sphere->radius);
+			w.f32(sphere->power);
+			w.f32(sphere->limit);
+		} else if (auto spot = std::get_if< S72::Light::Spot >(&light.source)) {
+			w.f32(spot->radius);
+			w.f32(spot->power);
+			w.f32(spot->limit);
+			w.f32(spot->fov);
+			w.f32(spot->blend);
+		}
+	}
+
+	w.u32(uint32_t(s72.nodes.size()));
+	for (auto const &[key, node] : s72.nodes) {
+		w.str(key);
+		w.str(node.name);
+		w.u32(node.index);
+		w.vec3(node.translation);
+		w.f32(node.rotation.x); w.f32(node.rotation.y); w.f32(node.rotation.z); w.f32(node.rotation.w);
+		w.vec3(node.scale);
+		w.u32(uint32_t(node.children.size()));
+		for (S72::Node const *child : node.children) w.str(child->name);
+		w.str(node.mesh ? node.mesh->name : "");
+		w.str(node.camera ? node.camera->name : "");
+		w.str(node.environment ? node.environment->name : "");
+		w.str(node.light ? node.light->name : "");
+	}
+
+	w.u32(uint32_t(s72.drivers.size()));
+	for (S72::Driver const &driver : s72.drivers) {
+		w.str(driver.name);
+		w.str(driver.node.name);
+		w.u32(uint32_t(driver.channel));
+		w.floats(driver.times);
+		w.floats(driver.values);
+		w.u32(uint32_t(driver.interpolation));
+	}
+
+	w.str(s72.scene.name);
+	w.u32(uint32_t(s72.scene.roots.size()));
+	for (S72::Node const *root : s72.scene.roots) w.str(root->name);
+}
+
+void read_scene(Reader &r, S72 &s72) {
+	//objects are stored along with their index; put each one back in its slot in the dense tables:
+	auto place = [](auto &table, auto &object, char const *what) {
+		if (object.index >= table.size() || table[object.index] != nullptr) {
+			throw std::runtime_error(std::string("bad ") + what + " index " + std::to_string(object.index) + ".");
+		}
+		table[object.index] = &object;
+	};
+	//look up a referenced object by name; empty name => null:
+	auto ref = [](auto &map, std::string const &name, char const *what) -> decltype(&map.begin()->second) {
+		if (name.empty()) return nullptr;
+		auto f = map.find(name);
+		if (f == map.end()) throw std::runtime_error(std::string("reference to missing ") + what + " '" + name + "'.");
+		return &f->second;
+	};
+
+	s72.tables.data_files.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.data_files.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::DataFile &file = s72.data_files[key];
+		file.src = r.str();
+		file.index = r.u32();
+		place(s72.tables.data_files, file, "data file");
+		file.path = r.str();
+	}
+
+	s72.tables.textures.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.textures.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Texture &tex = s72.textures[key];
+		tex.src = r.str();
+		tex.index = r.u32();
+		place(s72.tables.textures, tex, "texture");
+		tex.type = S72::Texture::Type(r.u32());
+		tex.format = S72::Texture::Format(r.u32());
+		tex.path = r.str();
+	}
+
+	s72.tables.materials.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.materials.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Material &mat = s72.materials[key];
+		mat.name = r.str();
+		mat.index = r.u32();
+		place(s72.tables.materials, mat, "material");
+		mat.normal_map = ref(s72.textures, r.str(), "texture");
+		mat.displacement_map = ref(s72.textures, r.str(), "texture");
+
+		auto color_or_texture = [&]() -> std::variant< S72::color, S72::Texture * > {
+			S72::Texture *tex = ref(s72.textures, r.str(), "texture");
+			S72::color c;
+			c.r = r.f32(); c.g = r.f32(); c.b = r.f32();
+			if (tex) return tex;
+			return c;
+		};
+		auto float_or_texture = [&]() -> std::variant< float, S72::Texture * > {
+			S72::Texture *tex = ref(s72.textures, r.str(), "texture");
+			float f = r.f32();
+			if (tex) return tex;
+			return f;
+		};
+
+		uint32_t brdf = r.u32();
+		if (brdf == 0) {
+			S72::Material::PBR pbr;
+			pbr.albedo = color_or_texture();
+			pbr.roughness = float_or_texture();
+			pbr.metalness = float_or_texture();
+			mat.brdf = pbr;
+		} else if (brdf == 1) {
+			S72::Material::Lambertian lambertian;
+			lambertian.albedo = color_or_texture();
+			mat.brdf = lambertian;
+		} else if (brdf == 2) {
+			mat.brdf = S72::Material::Mirror{};
+		} else if (brdf == 3) {
+			mat.brdf = S72::Material::Environment{};
+		} else {
+			throw std::runtime_error("material '" + mat.name + "' has unknown brdf " + std::to_string(brdf) + ".");
+		}
+	}
+
+	s72.tables.meshes.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.meshes.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Mesh &mesh = s72.meshes[key];
+		mesh.name = r.str();
+		mesh.index = r.u32();
+		place(s72.tables.meshes, mesh, "mesh");
+		mesh.topology = VkPrimitiveTopology(r.u32());
+		mesh.count = r.u32();
+		if (r.u32()) {
+			S72::DataFile *src = ref(s72.data_files, r.str(), "data file");
+			if (!src) throw std::runtime_error("mesh '" + mesh.name + "' indices have no data file.");
+			uint32_t offset = r.u32();
+			VkIndexType format = VkIndexType(r.u32());
+			mesh.indices.emplace(S72::Mesh::Indices{ .src = *src, .offset = offset, .format = format });
+		}
+		for (uint32_t a = r.u32(); a > 0; --a) {
+			std::string name = r.str();
+			S72::DataFile *src = ref(s72.data_files, r.str(), "data file");
+			if (!src) throw std::runtime_error("mesh '" + mesh.name + "' attribute '" + name + "' has no data file.");
+			uint32_t offset = r.u32();
+			uint32_t stride = r.u32();
+			VkFormat format = VkFormat(r.u32());
+			mesh.attributes.emplace(name, S72::Mesh::Attribute{ .src = *src, .offset = offset, .stride = stride, .format = format });
+		}
+		mesh.material = ref(s72.materials, r.str(), "material");
+	}
+
+	s72.tables.cameras.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.cameras.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Camera &camera = s72.cameras[key];
+		camera.name = r.str();
+		camera.index = r.u32();
+		place(s72.tables.cameras, camera, "camera");
+		S72::Camera::Perspective p;
+		p.aspect = r.f32();
+		p.vfov = r.f32();
+		p.near = r.f32();
+		p.far = r.f32();
+		camera.projection = p;
+	}
+
+	s72.tables.environments.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.environments.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Environment &env = s72.environments[key];
+		env.name = r.str();
+		env.index = r.u32();
+		place(s72.tables.environments, env, "environment");
+		env.radiance = ref(s72.textures, r.str(), "texture");
+		if (!env.radiance) throw std::runtime_error("environment '" + env.name + "' has no radiance texture.");
+	}
+
+	s72.tables.lights.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.lights.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Light &light = s72.lights[key];
+		light.name = r.str();
+		light.index = r.u32();
+		place(s72.tables.lights, light, "light");
+		light.tint.r = r.f32(); light.tint.g = r.f32(); light.tint.b = r.f32();
+		light.shadow = r.u32();
+		uint32_t source = r.u32();
+		if (source == 0) {
+			S72::Light::Sun sun;
+			sun.angle = r.f32();
+			sun.strength = r.f32();
+			light.source = sun;
+		} else if (source == 1) {
+			S72::Light::Sphere sphere;
+			sphere.radius = r.f32();
+			sphere.power = r.f32();
+			sphere.limit = r.f32();
+			light.source = sphere;
+		} else if (source == 2) {
+			S72::Light::Spot spot;
+			spot.radius = r.f32();
+			spot.power = r.f32();
+			spot.limit = r.f32();
+			spot.fov = r.f32();
+			spot.blend = r.f32();
+			light.source = spot;
+		} else {
+			throw std::runtime_error("light '" + light.name + "' has unknown source " + std::to_string(source) + ".");
+		}
+	}
+
+	//nodes reference each other, so create them all before resolving children:
+	std::vector< std::pair< S72::Node *, std::vector< std::string > > > children;
+	s72.tables.nodes.assign(r.u32(), nullptr);
+	for (size_t n = s72.tables.nodes.size(); n > 0; --n) {
+		std::string key = r.str();
+		S72::Node &node = s72.nodes[key];
+		node.name = r.str();
+		node.index = r.u32();
+		place(s72.tables.nodes, node, "node");
+		node.translation = r.vec3();
+		node.rotation.x = r.f32(); node.rotation.y = r.f32(); node.rotation.z = r.f32(); node.rotation.w = r.f32();
+		node.scale = r.vec3();
+		std::vector< std::string > names(r.u32());
+		for (auto &name : names) name = r.str();
+		children.emplace_back(&node, std::move(names));
+		node.mesh = ref(s72.meshes, r.str(), "mesh");
+		node.camera = ref(s72.cameras, r.str(), "camera");
+		node.environment = ref(s72.environments, r.str(), "environment");
+		node.light = ref(s72.lights, r.str(), "light");
+	}
+	for (auto &[node, names] : children) {
+		node->children.reserve(names.size());
+		for (auto const &name : names) {
+			node->children.emplace_back(ref(s72.nodes, name, "node"));
+			if (!node->children.back()) throw std::runtime_error("node '" + node->name + "' has an unnamed child.");
+		}
+	}
+
+	for (uint32_t n = r.u32(); n > 0; --n) {
+		std::string name = r.str();
+		S72::Node *node = ref(s72.nodes, r.str(), "node");
+		if (!node) throw std::runtime_error("driver '" + name + "' has no node.");
+		S72::Driver::Channel channel = S72::Driver::Channel(r.u32());
+		std::vector< float > times = r.floats();
+		std::vector< float > values = r.floats();
+		S72::Driver::Interpolation interpolation = S72::Driver::Interpolation(r.u32());
+		s72.drivers.emplace_back(S72::Driver{
+			.name = name,
+			.node = *node,
+			.channel = channel,
+			.times = std::move(times),
+			.values = std::move(values),
+			.interpolation = interpolation,
+		});
+	}
+
+	s72.scene.name = r.str();
+	for (uint32_t n = r.u32(); n > 0; --n) {
+		S72::Node *root = ref(s72.nodes, r.str(), "node");
+		if (!root) throw std::runtime_error("scene has an unnamed root.");
+		s72.scene.roots.emplace_back(root);
+	}
+}
+
+} //namespace
+
+SceneCache::SceneCache(std::string const &key_) : key(key_) {
+}
+
+SceneCache::Image const *SceneCache::find_image(std::string const &path, bool flipped) const {
+	auto f = images.find(image_id(path, flipped));
+	if (f == images.end()) return nullptr;
+	return &f->second.image;
+}
+
+void SceneCache::add_image(std::string const &path, bool flipped, Image const &image) {
+	images[image_id(path, flipped)] = StoredImage{
+		.path = path,
+		.flipped = flipped,
+		.image = image,
+	};
+}
+
+void SceneCache::set_vertices(void const *data, size_t size, uint32_t stride) {
+	vertex_storage.assign(reinterpret_cast< uint8_t const * >(data), reinterpret_cast< uint8_t const * >(data) + size);
+	vertices = vertex_storage.data();
+	vertices_size = vertex_storage.size();
+	vertex_stride = stride;
+}
+
+void SceneCache::set_indices(uint32_t const *data, size_t count) {
+	index_storage.assign(data, data + count);
+	indices = index_storage.data();
+	indices_count = index_storage.size();
+}
+
+void SceneCache::save(std::string const &path, std::string const &scene_file, S72 const &scene) const {
+	Writer w;
+	w.bytes.insert(w.bytes.end(), Magic, Magic + sizeof(Magic));
+	w.u32(Version);
+	w.str(key);
+
+	{ //source files, so stale caches can be detected:
+		std::vector< std::string > sources;
+		sources.emplace_back(scene_file); //(first, so load() can check which scene the cache is for)
+		for (auto const &[src, file] : scene.data_files) sources.emplace_back(file.path);
+		for (auto const &[id, stored] : images) sources.emplace_back(stored.path);
+
+		w.u32(uint32_t(sources.size()));
+		for (auto const &source : sources) {
+			FileStamp fs;
+			if (!stamp(source, &fs)) throw std::runtime_error("Failed to stat scene source '" + source + "'.");
+			w.str(source);
+			w.pod(fs.size);
+			w.pod(fs.mtime);
+		}
+	}
+
+	write_scene(w, scene);
+
+	w.u32(uint32_t(meshes.size()));
+	for (auto const &[name, mesh] : meshes) {
+		w.str(name);
+		w.u32(mesh.first);
+		w.u32(mesh.count);
+		w.u32(mesh.first_index);
+		w.u32(mesh.index_count);
+		w.vec3(mesh.min_aabb_bound);
+		w.vec3(mesh.max_aabb_bound);
+	}
+	w.u32(vertex_stride);
+	w.blob(vertices, vertices_size);
+	w.blob(indices, indices_count * sizeof(uint32_t));
+
+	w.u32(uint32_t(images.size()));
+	for (auto const &[id, stored] : images) {
+		w.str(stored.path);
+		w.u32(stored.flipped ? 1 : 0);
+		w.u32(stored.image.width);
+		w.u32(stored.image.height);
+		w.blob(stored.image.texels, size_t(stored.image.width) * stored.image.height * 4);
+	}
+
+	//write to a temporary and rename, so a crash mid-write never leaves a truncated cache behind:
+	std::string temp = path + ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary);
+		if (!out) throw std::runtime_error("Failed to open scene cache '" + temp + "' for writing.");
+		out.write(reinterpret_cast< char const * >(w.bytes.data()), std::streamsize(w.bytes.size()));
+		if (!out) throw std::runtime_error("Failed to write scene cache '" + temp + "'.");
+	}
+	std::filesystem::rename(temp, path);
+
+	std::cout << "Wrote scene cache '" << path << "' (" << w.bytes.size() << " bytes)." << std::endl;
+}
+
+std::unique_ptr< SceneCache > SceneCache::load(std::string const &path, std::string const &scene_file, std::string const &key, S72 *scene) {
+	assert(scene);
+
+	if (!std::filesystem::exists(path)) {
+		std::cout << "Scene cache '" << path << "' does not exist yet; it will be written after loading." << std::endl;
+		return nullptr;
+	}
+
+	std::unique_ptr< SceneCache > cache(new SceneCache(key));
+	try {
+		cache->file = MappedFile(path);
+		Reader r{ .data = cache->file.data(), .size = cache->file.size() };
+
+		r.need(sizeof(Magic));
+		if (std::memcmp(r.data, Magic, sizeof(Magic)) != 0) throw std::runtime_error("not a scene cache.");
+		r.at += sizeof(Magic);
+		if (uint32_t version = r.u32(); version != Version) {
+			throw std::runtime_error("version " + std::to_string(version) + " (expected " + std::to_string(Version) + ").");
+		}
+		if (std::string stored_key = r.str(); stored_key != key) {
+			throw std::runtime_error("built for '" + stored_key + "' (current configuration is '" + key + "').");
+		}
+
+		uint32_t sources = r.u32();
+		if (sources == 0) throw std::runtime_error("no source files recorded.");
+		for (uint32_t n = 0; n < sources; ++n) {
+			std::string source = r.str();
+			if (n == 0) {
+				//(the scene that was loaded when the cache was written; any path naming the same file will do)
+				std::error_code ec;
+				if (!std::filesystem::equivalent(source, scene_file, ec)) {
+					throw std::runtime_error("built from scene '" + source + "' (current scene is '" + scene_file + "').");
+				}
+			}
+			FileStamp stored;
+			stored.size = r.pod< uint64_t >();
+			stored.mtime = r.pod< int64_t >();
+			FileStamp current;
+			if (!stamp(source, &current) || !(current == stored)) {
+				throw std::runtime_error("'" + source + "' has changed.");
+			}
+		}
+
+		S72 loaded;
+		read_scene(r, loaded);
+
+		for (uint32_t n = r.u32(); n > 0; --n) {
+			std::string name = r.str();
+			Mesh mesh;
+			mesh.first = r.u32();
+			mesh.count = r.u32();
+			mesh.first_index = r.u32();
+			mesh.index_count = r.u32();
+			mesh.min_aabb_bound = r.vec3();
+			mesh.max_aabb_bound = r.vec3();
+			cache->meshes.emplace(name, mesh);
+		}
+		cache->vertex_stride = r.u32();
+		cache->vertices = r.blob(&cache->vertices_size);
+		size_t index_bytes = 0;
+		cache->indices = reinterpret_cast< uint32_t const * >(r.blob(&index_bytes));
+		cache->indices_count = index_bytes / sizeof(uint32_t);
+
+		for (uint32_t n = r.u32(); n > 0; --n) {
+			std::string source = r.str();
+			bool flipped = (r.u32() != 0);
+			Image image;
+			image.width = r.u32();
+			image.height = r.u32();
+			size_t size = 0;
+			image.texels = r.blob(&size);
+			if (size != size_t(image.width) * image.height * 4) throw std::runtime_error("image '" + source + "' has the wrong size.");
+			cache->add_image(source, flipped, image);
+		}
+
+		*scene = std::move(loaded);
+	} catch (std::exception &e) {
+		std::cout << "Ignoring scene cache '" << path << "': " << e.what() << std::endl;
+		return nullptr;
+	}
+
+	cache->loaded = true;
+	return cache;
+}
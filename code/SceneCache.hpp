@@ -0,0 +1,86 @@
+#pragma once
+
+//Binary cache of a fully-resolved scene, used by `--scene-cache <file>`:
+// - the S72 scene itself (all object references stored by name, so the file is relocatable)
+// - per-mesh vertex/index ranges and AABBs
+// - the vertex and index buffers exactly as uploaded (so packed / optimized data is cached too)
+// - decoded RGBA8 texels for every image loaded through the cache
+//
+// The file is memory-mapped on load, and bulk payloads are 16-byte aligned so
+// they can be handed straight to the upload path without copying.
+//
+// A cache is only used if its version, configuration key, and the scene file it was built from
+// match, and the size + modification time of every source file (scene, data files, images) are unchanged.
+
+#include "S72.hpp"
+#include "MappedFile.hpp"
+#include "mat4.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SceneCache {
+	//decoded image, RGBA8, already in the orientation that gets uploaded:
+	struct Image {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint8_t const *texels = nullptr; //width * height * 4 bytes
+		std::shared_ptr< uint8_t const > storage; //owns texels when they aren't inside the mapped cache file
+	};
+
+	//vertex/index range for one mesh (mirrors Tutorial::ObjectVertices):
+	struct Mesh {
+		uint32_t first = 0;
+		uint32_t count = 0;
+		uint32_t first_index = 0;
+		uint32_t index_count = 0;
+		vec3 min_aabb_bound = vec3(0.0f);
+		vec3 max_aabb_bound = vec3(0.0f);
+	};
+
+	//empty cache, to be filled while loading the scene the slow way and then saved:
+	// 'key' describes configuration the payload depends on (e.g., vertex format)
+	explicit SceneCache(std::string const &key);
+
+	//try to read a cache of 'scene_file'; returns nullptr (with a message on stdout) if missing, corrupt, stale, or built from another scene:
+	// on success, the stored scene is moved into *scene.
+	static std::unique_ptr< SceneCache > load(std::string const &path, std::string const &scene_file, std::string const &key, S72 *scene);
+
+	//write everything recorded so far along with 'scene' (loaded from 'scene_file'):
+	// NOTE: throws on error
+	void save(std::string const &path, std::string const &scene_file, S72 const &scene) const;
+
+	//image lookup (by source path + orientation), nullptr if not present:
+	Image const *find_image(std::string const &path, bool flipped) const;
+	void add_image(std::string const &path, bool flipped, Image const &image);
+
+	std::string key;
+	bool loaded = false; //true => came from a cache file; false => recording
+
+	std::unordered_map< std::string, Mesh > meshes; //by mesh name
+	uint32_t vertex_stride = 0; //size of one vertex in 'vertices'
+	uint8_t const *vertices = nullptr;
+	size_t vertices_size = 0; //bytes
+	uint32_t const *indices = nullptr;
+	size_t indices_count = 0;
+
+	//when recording, vertex/index payloads are copied here:
+	void set_vertices(void const *data, size_t size, uint32_t stride);
+	void set_indices(uint32_t const *data, size_t count);
+
+private:
+	struct StoredImage {
+		std::string path;
+		bool flipped = false;
+		Image image;
+	};
+	std::unordered_map< std::string, StoredImage > images; //by path + orientation
+
+	std::vector< uint8_t > vertex_storage;
+	std::vector< uint32_t > index_storage;
+
+	MappedFile file; //backing store when loaded
+};
@@ -0,0 +1,81 @@
+#include "SubAllocator.hpp"
+
+#include <cassert>
+#include <iterator>
+
+SubAllocator::SubAllocator(uint64_t size_) : size(size_) {
+	if (size > 0) insert(0, size);
+}
+
+bool SubAllocator::allocate(uint64_t want, uint64_t alignment, uint64_t *offset_) {
+	assert(offset_);
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	if (want == 0) want = 1;
+
+	//best fit: smallest free range that still fits once aligned
+	// (only ranges that come up short because of padding get skipped, so this rarely looks at more than a few)
+	for (auto it = by_size.lower_bound(want); it != by_size.end(); ++it) {
+		uint64_t start = it->second;
+		uint64_t length = it->first;
+		uint64_t aligned = (start + alignment - 1) & ~(alignment - 1);
+		if (aligned + want > start + length) continue;
+
+		erase(by_offset.find(start));
+		if (aligned > start) insert(start, aligned - start);
+		if (aligned + want < start + length) insert(aligned + want, start + length - (aligned + want));
+
+		used += want;
+		allocations += 1;
+		*offset_ = aligned;
+		return true;
+	}
+	return false;
+}
+
+void SubAllocator::free(uint64_t offset, uint64_t length) {
+	if (length == 0) length = 1;
+	assert(allocations > 0 && used >= length);
+	assert(offset + length <= size);
+	used -= length;
+	allocations -= 1;
+
+	//merge with free neighbors:
+	auto next = by_offset.lower_bound(offset);
+	assert(next == by_offset.end() || next->first >= offset + length); //(not already free)
+	if (next != by_offset.end() && next->first == offset + length) {
+		length += next->second;
+		auto after = std::next(next);
+		erase(next);
+		next = after;
+	}
+	if (next != by_offset.begin()) {
+		auto prev = std::prev(next);
+		assert(prev->first + prev->second <= offset);
+		if (prev->first + prev->second == offset) {
+			offset = prev->first;
+			length += prev->second;
+			erase(prev);
+		}
+	}
+	insert(offset, length);
+}
+
+uint64_t SubAllocator::largest_free() const {
+	return by_size.empty() ? 0 : by_size.rbegin()->first;
+}
+
+void SubAllocator::insert(uint64_t offset, uint64_t length) {
+	by_offset.emplace(offset, length);
+	by_size.emplace(length, offset);
+}
+
+void SubAllocator::erase(std::map< uint64_t, uint64_t >::iterator at) {
+	auto range = by_size.equal_range(at->second);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == at->first) {
+			by_size.erase(it);
+			break;
+		}
+	}
+	by_offset.erase(at);
+}
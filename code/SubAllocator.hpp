@@ -0,0 +1,31 @@
+#pragma once
+
+//Hands out aligned byte ranges from one fixed-size span (e.g., a block of device memory):
+// - free ranges are kept by offset (so freed neighbors merge back together) and by size (for best-fit lookup)
+// - alignment padding in front of an allocation stays in the free list, so a range is freed with exactly
+//   the offset + size it was allocated with
+
+#include <cstdint>
+#include <map>
+
+struct SubAllocator {
+	explicit SubAllocator(uint64_t size);
+
+	//find room for 'size' bytes starting at a multiple of 'alignment' (a power of two); false if there isn't any:
+	bool allocate(uint64_t size, uint64_t alignment, uint64_t *offset);
+	//give back a range from allocate():
+	void free(uint64_t offset, uint64_t size);
+
+	uint64_t size = 0; //of the whole span
+	uint64_t used = 0; //bytes in allocated ranges
+	uint32_t allocations = 0;
+	uint64_t largest_free() const; //biggest single free range
+	bool empty() const { return allocations == 0; }
+
+private:
+	std::map< uint64_t, uint64_t > by_offset; //offset -> size
+	std::multimap< uint64_t, uint64_t > by_size; //size -> offset
+
+	void insert(uint64_t offset, uint64_t size);
+	void erase(std::map< uint64_t, uint64_t >::iterator at);
+};
@@ -0,0 +1,96 @@
+#include "TextureAtlas.hpp"
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "external/stb_image/stb_rect_pack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace TextureAtlas {
+
+//packing happens on a grid of Align x Align cells, so placements stay whole texels down to level MaxLevels-1:
+constexpr uint32_t Align = 1u << (MaxLevels - 1);
+static_assert(Gutter % Align == 0, "gutter keeps the texture itself aligned");
+
+void pack(std::vector< Input > const &inputs, uint32_t page_size, std::vector< Page > *pages_, std::vector< Placement > *placements_) {
+	assert(pages_ && placements_);
+	auto &pages = *pages_;
+	auto &placements = *placements_;
+	pages.clear();
+	placements.assign(inputs.size(), Placement{});
+	if (inputs.empty()) return;
+
+	if (page_size % Align != 0 || page_size < MaxSize + 2 * Gutter) {
+		throw std::runtime_error("Atlas page size " + std::to_string(page_size) + " must be a multiple of " + std::to_string(Align)
+			+ " and at least " + std::to_string(MaxSize + 2 * Gutter) + ".");
+	}
+	uint32_t cells = page_size / Align;
+
+	std::vector< stbrp_rect > remaining;
+	remaining.reserve(inputs.size());
+	for (uint32_t i = 0; i < inputs.size(); ++i) {
+		Input const &in = inputs[i];
+		if (in.width == 0 || in.height == 0 || in.width > MaxSize || in.height > MaxSize) {
+			throw std::runtime_error("Can't pack a " + std::to_string(in.width) + "x" + std::to_string(in.height) + " texture into an atlas.");
+		}
+		remaining.emplace_back(stbrp_rect{
+			.id = int(i),
+			.w = stbrp_coord((in.width + 2 * Gutter + Align - 1) / Align),
+			.h = stbrp_coord((in.height + 2 * Gutter + Align - 1) / Align),
+			.x = 0, .y = 0,
+			.was_packed = 0,
+		});
+	}
+
+	std::vector< stbrp_node > nodes(cells);
+	while (!remaining.empty()) {
+		stbrp_context context;
+		stbrp_init_target(&context, int(cells), int(cells), nodes.data(), int(nodes.size()));
+		stbrp_pack_rects(&context, remaining.data(), int(remaining.size()));
+
+		uint32_t page_index = uint32_t(pages.size());
+		Page &page = pages.emplace_back();
+		std::vector< stbrp_rect > next;
+		for (stbrp_rect const &r : remaining) {
+			if (!r.was_packed) {
+				next.emplace_back(r);
+				continue;
+			}
+			placements[r.id] = Placement{
+				.page = page_index,
+				.x = uint32_t(r.x) * Align + Gutter,
+				.y = uint32_t(r.y) * Align + Gutter,
+			};
+			page.width = std::max(page.width, uint32_t(r.x + r.w) * Align);
+			page.height = std::max(page.height, uint32_t(r.y + r.h) * Align);
+		}
+		if (next.size() == remaining.size()) {
+			throw std::runtime_error("Failed to pack any textures into an atlas page."); //(can't happen given the size checks above)
+		}
+		remaining = std::move(next);
+	}
+
+	//copy each texture (and its wrapped gutter) into its page:
+	for (Page &page : pages) {
+		page.rgba.assign(size_t(page.width) * page.height * 4, 0);
+	}
+	for (uint32_t i = 0; i < inputs.size(); ++i) {
+		Input const &in = inputs[i];
+		Placement const &at = placements[i];
+		Page &page = pages[at.page];
+		for (uint32_t y = 0; y < in.height + 2 * Gutter; ++y) {
+			uint32_t src_y = (y + in.height - Gutter % in.height) % in.height;
+			uint8_t *dst = &page.rgba[((size_t(at.y) - Gutter + y) * page.width + (at.x - Gutter)) * 4];
+			uint8_t const *src_row = in.rgba + size_t(src_y) * in.width * 4;
+			for (uint32_t x = 0; x < in.width + 2 * Gutter; ++x) {
+				uint32_t src_x = (x + in.width - Gutter % in.width) % in.width;
+				std::memcpy(dst + size_t(x) * 4, src_row + size_t(src_x) * 4, 4);
+			}
+		}
+	}
+}
+
+} //namespace TextureAtlas
@@ -0,0 +1,38 @@
+#pragma once
+
+//Packs small RGBA8 textures into larger atlas pages (with stb_rect_pack), so scenes with many tiny
+// textures need fewer images, allocations, and texture table entries.
+//
+// Each packed texture is surrounded by a Gutter of its own texels, wrapped around (so repeat-wrapped
+// sampling near an edge reads the right neighbors). Placements are aligned so that the first MaxLevels
+// mip levels of a page still line up with the texture boundaries; pages shouldn't use more levels than that.
+
+#include <cstdint>
+#include <vector>
+
+namespace TextureAtlas {
+	constexpr uint32_t MaxSize = 256; //textures no larger than this on either axis get packed
+	constexpr uint32_t Gutter = 8; //texels of wrapped border around each packed texture
+	constexpr uint32_t MaxLevels = 4; //mip levels a page can have before textures bleed into each other (Gutter >> (MaxLevels-1) >= 1)
+
+	struct Input {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint8_t const *rgba = nullptr; //width * height * 4 bytes
+	};
+
+	struct Placement {
+		uint32_t page = 0;
+		uint32_t x = 0, y = 0; //where the texture's top-left texel (inside its gutter) went
+	};
+
+	struct Page {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector< uint8_t > rgba; //width * height * 4 bytes; unused space is transparent black
+	};
+
+	//pack all inputs (each at most MaxSize on a side) into pages of at most page_size x page_size (a multiple of the alignment, 8);
+	// (*placements)[i] is where inputs[i] went. The last page is trimmed to what it uses.
+	void pack(std::vector< Input > const &inputs, uint32_t page_size, std::vector< Page > *pages, std::vector< Placement > *placements);
+}
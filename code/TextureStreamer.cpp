@@ -0,0 +1,269 @@
+#include "TextureStreamer.hpp"
+
+#include "RTG.hpp"
+#include "VK.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+TextureStreamer::Source TextureStreamer::from_baked(KTX2::File &&file) {
+	if (file.faces != 1) throw std::runtime_error("Can only stream 2D textures, not cube maps.");
+	Source source;
+	source.format = file.format;
+	source.width = file.width;
+	source.height = file.height;
+	for (KTX2::File::Level const &level : file.levels) {
+		source.levels.emplace_back(Source::Level{ .offset = level.offset, .size = level.size });
+	}
+	source.file = std::move(file);
+	return source;
+}
+
+TextureStreamer::Source TextureStreamer::from_rgba8(uint32_t width, uint32_t height, uint8_t const *rgba, VkFormat format, bool srgb) {
+	assert(width > 0 && height > 0);
+
+	float to_linear[256];
+	for (uint32_t i = 0; i < 256; ++i) {
+		float v = i / 255.0f;
+		to_linear[i] = (srgb ? (v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f)) : v);
+	}
+	auto to_byte = [&](float v) -> uint8_t {
+		if (srgb) v = (v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f);
+		return uint8_t(std::clamp(v * 255.0f + 0.5f, 0.0f, 255.0f));
+	};
+
+	//build the chain largest-first:
+	std::vector< std::vector< uint8_t > > chain;
+	chain.emplace_back(rgba, rgba + size_t(width) * height * 4);
+	for (uint32_t w = width, h = height; w > 1 || h > 1; ) {
+		uint32_t nw = std::max(1u, w / 2), nh = std::max(1u, h / 2);
+		std::vector< uint8_t > const &from = chain.back();
+		std::vector< uint8_t > to(size_t(nw) * nh * 4);
+		for (uint32_t y = 0; y < nh; ++y) {
+			uint32_t y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+			for (uint32_t x = 0; x < nw; ++x) {
+				uint32_t x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+				uint8_t const *px[4] = {
+					&from[(size_t(y0) * w + x0) * 4], &from[(size_t(y0) * w + x1) * 4],
+					&from[(size_t(y1) * w + x0) * 4], &from[(size_t(y1) * w + x1) * 4],
+				};
+				uint8_t *out = &to[(size_t(y) * nw + x) * 4];
+				for (uint32_t c = 0; c < 3; ++c) {
+					out[c] = to_byte(0.25f * (to_linear[px[0][c]] + to_linear[px[1][c]] + to_linear[px[2][c]] + to_linear[px[3][c]]));
+				}
+				//(alpha is never sRGB-encoded)
+				out[3] = uint8_t((uint32_t(px[0][3]) + px[1][3] + px[2][3] + px[3][3] + 2) / 4);
+			}
+		}
+		chain.emplace_back(std::move(to));
+		w = nw;
+		h = nh;
+	}
+
+	//...and store it smallest-first:
+	Source source;
+	source.format = format;
+	source.width = width;
+	source.height = height;
+	source.levels.resize(chain.size());
+	size_t total = 0;
+	for (auto const &level : chain) total += level.size();
+	source.texels.reserve(total);
+	for (uint32_t l = uint32_t(chain.size()); l > 0; --l) {
+		source.levels[l - 1] = Source::Level{ .offset = source.texels.size(), .size = chain[l - 1].size() };
+		source.texels.insert(source.texels.end(), chain[l - 1].begin(), chain[l - 1].end());
+	}
+	return source;
+}
+
+TextureStreamer::TextureStreamer(RTG &rtg_, std::vector< Helpers::AllocatedImage > &textures_, std::vector< VkImageView > &texture_views_,
+	size_t budget_bytes_, uint32_t frames_in_flight_, bool mip_chains_)
+	: budget_bytes(budget_bytes_), rtg(rtg_), textures(textures_), texture_views(texture_views_),
+	  frames_in_flight(frames_in_flight_), mip_chains(mip_chains_) {
+}
+
+TextureStreamer::~TextureStreamer() {
+	for (Retired &r : retired) {
+		if (r.view != VK_NULL_HANDLE) vkDestroyImageView(rtg.device, r.view, nullptr);
+		rtg.helpers.destroy_image(std::move(r.image));
+	}
+	retired.clear();
+}
+
+Helpers::AllocatedImage TextureStreamer::add(uint32_t slot, Source &&source) {
+	if (source.levels.empty()) throw std::runtime_error("Texture to stream has no levels.");
+
+	Entry entry;
+	entry.slot = slot;
+	entry.source = std::move(source);
+	uint32_t levels = uint32_t(entry.source.levels.size());
+	while (entry.floor + 1 < levels
+		&& std::max(entry.source.width >> entry.floor, entry.source.height >> entry.floor) > MinResidentSize) {
+		entry.floor += 1;
+	}
+	entry.resident = entry.wanted = entry.floor;
+
+	Helpers::AllocatedImage image = upload(entry, entry.floor);
+	resident_bytes += bytes(entry, entry.floor);
+
+	if (entry_of_slot.size() <= slot) entry_of_slot.resize(slot + 1, ~0u);
+	entry_of_slot[slot] = uint32_t(entries.size());
+	entries.emplace_back(std::move(entry));
+	return image;
+}
+
+void TextureStreamer::use(uint32_t slot, float pixels) {
+	if (slot >= entry_of_slot.size() || entry_of_slot[slot] == ~0u) return;
+	Entry &entry = entries[entry_of_slot[slot]];
+	if (entry.last_used != frame) {
+		entry.last_used = frame;
+		entry.pixels = 0.0f;
+	}
+	entry.pixels = std::max(entry.pixels, pixels);
+}
+
+void TextureStreamer::update() {
+	//destroy images that no frame in flight can still be using:
+	// (RTG calls update() before waiting on the next workspace, so a frame 'frames_in_flight' later is safe)
+	for (auto r = retired.begin(); r != retired.end(); ) {
+		if (r->frame + frames_in_flight <= frame) {
+			if (r->view != VK_NULL_HANDLE) vkDestroyImageView(rtg.device, r->view, nullptr);
+			rtg.helpers.destroy_image(std::move(r->image));
+			r = retired.erase(r);
+		} else {
+			++r;
+		}
+	}
+
+	//finest level each texture needs this frame:
+	// assumes UVs span the texture about once across the object, so one texel per covered pixel wants level log2(size / pixels)
+	std::vector< Entry * > wanting;
+	for (Entry &entry : entries) {
+		if (entry.last_used != frame) continue; //(not visible; keeps what it has until something needs the room)
+		float size = float(std::max(entry.source.width, entry.source.height));
+		float level = (entry.pixels > 0.0f ? std::floor(std::log2(size / entry.pixels)) : float(entry.floor));
+		entry.wanted = uint32_t(std::clamp(level, 0.0f, float(entry.floor)));
+		if (entry.wanted < entry.resident) wanting.emplace_back(&entry);
+	}
+	//biggest on screen first:
+	std::stable_sort(wanting.begin(), wanting.end(), [](Entry const *a, Entry const *b) {
+		return a->pixels > b->pixels;
+	});
+
+	size_t uploaded = 0;
+	for (Entry *entry : wanting) {
+		if (uploaded > 0 && uploaded >= MaxUploadPerFrame) break;
+
+		uint32_t level = entry->wanted;
+		//make room by evicting (least recently used first) textures not needed at their current resolution,
+		// settling for a coarser level if that isn't enough:
+		while (level < entry->resident && resident_bytes - bytes(*entry, entry->resident) + bytes(*entry, level) > budget_bytes) {
+			Entry *victim = nullptr;
+			for (Entry &other : entries) {
+				if (&other == entry) continue;
+				uint32_t target = (other.last_used == frame ? other.wanted : other.floor);
+				if (other.resident >= target) continue;
+				if (victim == nullptr || other.last_used < victim->last_used) victim = &other;
+			}
+			if (victim) {
+				set_resident(*victim, (victim->last_used == frame ? victim->wanted : victim->floor));
+				evicted += 1;
+			} else {
+				level += 1;
+			}
+		}
+		if (level >= entry->resident) continue;
+
+		size_t before = uploaded_bytes;
+		set_resident(*entry, level);
+		uploaded += size_t(uploaded_bytes - before);
+		streamed_in += 1;
+	}
+
+	//submit this frame's uploads as one batch (the frame is rendered on the same queue, after them):
+	rtg.helpers.flush_uploads();
+
+	frame += 1;
+}
+
+size_t TextureStreamer::bytes(Entry const &entry, uint32_t level) const {
+	if (!mip_chains) return entry.source.levels[level].size;
+	size_t total = 0;
+	for (uint32_t l = level; l < entry.source.levels.size(); ++l) {
+		total += entry.source.levels[l].size;
+	}
+	return total;
+}
+
+Helpers::AllocatedImage TextureStreamer::upload(Entry const &entry, uint32_t level) {
+	Source const &source = entry.source;
+	uint32_t levels = (mip_chains ? uint32_t(source.levels.size()) - level : 1);
+
+	Helpers::AllocatedImage image = rtg.helpers.create_image(
+		VkExtent2D{ .width = std::max(1u, source.width >> level), .height = std::max(1u, source.height >> level) },
+		source.format,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		Helpers::Unmapped,
+		0,
+		1,
+		levels
+	);
+
+	//the levels being uploaded are one contiguous range of the source data (smallest first):
+	size_t begin = std::numeric_limits< size_t >::max();
+	size_t end = 0;
+	for (uint32_t l = level; l < level + levels; ++l) {
+		begin = std::min(begin, source.levels[l].offset);
+		end = std::max(end, source.levels[l].offset + source.levels[l].size);
+	}
+	std::vector< size_t > level_offsets;
+	level_offsets.reserve(levels);
+	for (uint32_t l = level; l < level + levels; ++l) {
+		level_offsets.emplace_back(source.levels[l].offset - begin);
+	}
+	rtg.helpers.upload_image_levels(source.data() + begin, end - begin, level_offsets, image);
+
+	uploaded_bytes += end - begin;
+	return image;
+}
+
+void TextureStreamer::set_resident(Entry &entry, uint32_t level) {
+	assert(level <= entry.floor);
+	if (level == entry.resident) return;
+
+	Helpers::AllocatedImage image = upload(entry, level);
+
+	VkImageViewCreateInfo create_info {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.flags = 0,
+		.image = image.handle,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = image.format,
+		.subresourceRange{
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = image.mipLevels,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+	VkImageView view = VK_NULL_HANDLE;
+	VK(vkCreateImageView(rtg.device, &create_info, nullptr, &view));
+
+	retired.emplace_back(Retired{
+		.image = std::move(textures[entry.slot]),
+		.view = texture_views[entry.slot],
+		.frame = frame,
+	});
+	textures[entry.slot] = std::move(image);
+	texture_views[entry.slot] = view;
+
+	resident_bytes = resident_bytes - bytes(entry, entry.resident) + bytes(entry, level);
+	entry.resident = level;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+//Streams material texture mip levels in and out of GPU memory under a fixed budget (`--texture-budget-mb`):
+// - every streamed texture starts with just its small levels (<= MinResidentSize texels on a side) resident
+// - the renderer reports, each frame, how many pixels each visible texture covers (use())
+// - update() then swaps in images with finer levels for textures that need them, evicting the least recently used
+//   (or over-resolved) textures back down to what they need when the budget would be exceeded
+//
+// The streamer swaps images + views in place in the renderer's texture / view arrays, so descriptors
+// just need to be written from those arrays after update(). Replaced images are destroyed once no frame
+// in flight can still be using them.
+
+#include "Helpers.hpp"
+#include "KTX2.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+struct RTG;
+
+struct TextureStreamer {
+	//textures with a larger top level than this only start with their smaller levels resident:
+	static constexpr uint32_t MinResidentSize = 64;
+	//(soft) limit on bytes uploaded per update(), to bound per-frame hitches; at least one texture always gets to stream:
+	static constexpr size_t MaxUploadPerFrame = size_t(16) << 20;
+
+	//CPU-side copy of every level of a texture, to (re-)upload any part of the chain from:
+	struct Source {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		struct Level {
+			size_t offset = 0; //bytes from data()
+			size_t size = 0;
+		};
+		//level 0 (largest) first; smaller levels are stored *before* larger ones (as in KTX2 files),
+		// so any tail of the chain is one contiguous range:
+		std::vector< Level > levels;
+
+		//level data lives in one of these:
+		KTX2::File file;
+		std::vector< uint8_t > texels;
+		uint8_t const *data() const { return texels.empty() ? file.mapped.data() : texels.data(); }
+	};
+	//baked (block-compressed) texture; levels stay in the file mapping:
+	static Source from_baked(KTX2::File &&file);
+	//RGBA8 image; builds the rest of the mip chain with a box filter (averaging in linear space if 'srgb'):
+	static Source from_rgba8(uint32_t width, uint32_t height, uint8_t const *rgba, VkFormat format, bool srgb);
+
+	//'textures' and 'texture_views' are the renderer's arrays; the streamer replaces entries of streamed slots:
+	// ('mip_chains' == false => resident images hold only their finest resident level, for --no-mipmaps)
+	TextureStreamer(RTG &rtg, std::vector< Helpers::AllocatedImage > &textures, std::vector< VkImageView > &texture_views,
+		size_t budget_bytes, uint32_t frames_in_flight, bool mip_chains);
+	~TextureStreamer(); //destroys retired images + views (current ones still belong to textures / texture_views)
+
+	TextureStreamer(TextureStreamer const &) = delete;
+	TextureStreamer &operator=(TextureStreamer const &) = delete;
+
+	//start streaming the texture in textures[slot]; returns the (small) starting image to put there:
+	// (the view for the slot is expected to cover all of the image's levels)
+	Helpers::AllocatedImage add(uint32_t slot, Source &&source);
+
+	//texture in 'slot' covers (about) 'pixels' pixels across on screen this frame (ignored for non-streamed slots):
+	void use(uint32_t slot, float pixels);
+
+	//once per frame, after use()'ing this frame's textures; may replace entries in textures / texture_views:
+	void update();
+
+	//stats:
+	size_t budget_bytes = 0;
+	size_t resident_bytes = 0; //of streamed textures, including the always-resident small levels
+	uint64_t uploaded_bytes = 0;
+	uint32_t streamed_in = 0; //images replaced with finer ones
+	uint32_t evicted = 0; //images replaced with coarser ones
+	uint32_t streams() const { return uint32_t(entries.size()); }
+
+private:
+	RTG &rtg;
+	std::vector< Helpers::AllocatedImage > &textures;
+	std::vector< VkImageView > &texture_views;
+	uint32_t frames_in_flight;
+	bool mip_chains;
+
+	struct Entry {
+		uint32_t slot = 0;
+		Source source;
+		uint32_t floor = 0; //coarsest level that may be the finest resident level (always resident)
+		uint32_t resident = 0; //finest level currently resident
+		uint32_t wanted = 0; //finest level needed by this frame's use()s
+		float pixels = 0.0f; //largest use() this frame
+		uint64_t last_used = 0; //frame of last use()
+	};
+	std::vector< Entry > entries;
+	std::vector< uint32_t > entry_of_slot; //slot -> index in entries (or ~0u)
+
+	struct Retired {
+		Helpers::AllocatedImage image;
+		VkImageView view = VK_NULL_HANDLE;
+		uint64_t frame = 0; //frame it was replaced in
+	};
+	std::vector< Retired > retired;
+
+	uint64_t frame = 1;
+
+	size_t bytes(Entry const &entry, uint32_t level) const; //resident bytes with 'level' as the finest resident level
+	Helpers::AllocatedImage upload(Entry const &entry, uint32_t level); //new image with 'level' as its top level
+	void set_resident(Entry &entry, uint32_t level); //swap in a new image + view; retire the old ones
+};
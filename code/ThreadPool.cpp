@@ -0,0 +1,56 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threads) {
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	workers.reserve(threads);
+	for (uint32_t t = 0; t < threads; ++t) {
+		workers.emplace_back([this](){
+			for (;;) {
+				std::packaged_task< void() > job;
+				{
+					std::unique_lock< std::mutex > lock(mutex);
+					wake.wait(lock, [this](){ return quit || !jobs.empty(); });
+					if (jobs.empty()) return; //(quit and nothing left to do)
+					job = std::move(jobs.front());
+					jobs.pop();
+				}
+				job();
+			}
+		});
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+std::future< void > ThreadPool::run(std::function< void() > job) {
+	std::packaged_task< void() > task(std::move(job));
+	std::future< void > done = task.get_future();
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.emplace(std::move(task));
+	}
+	wake.notify_one();
+	return done;
+}
+
+void ThreadPool::run_all(uint32_t count, std::function< void(uint32_t) > const &job) {
+	std::vector< std::future< void > > done;
+	done.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		done.emplace_back(run([&job, i](){ job(i); }));
+	}
+	//wait for everything before rethrowing, since jobs refer to caller's data:
+	for (auto &d : done) d.wait();
+	for (auto &d : done) d.get();
+}
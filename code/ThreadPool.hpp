@@ -0,0 +1,38 @@
+#pragma once
+
+//Fixed-size pool of worker threads for load-time work
+// (scene resolution, image decoding, ...).
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+	//'threads' == 0 => one per hardware thread:
+	explicit ThreadPool(uint32_t threads = 0);
+	~ThreadPool(); //finishes queued jobs, then joins workers
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	uint32_t size() const { return uint32_t(workers.size()); }
+
+	//queue a job; the future becomes ready when it finishes (and rethrows anything it threw):
+	std::future< void > run(std::function< void() > job);
+
+	//run job(0) ... job(count-1) on the pool and wait for all of them:
+	// if any throw, rethrows the exception from the lowest-numbered job (so errors are deterministic)
+	void run_all(uint32_t count, std::function< void(uint32_t) > const &job);
+
+private:
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::queue< std::packaged_task< void() > > jobs;
+	bool quit = false;
+};
@@ -22,7 +22,7 @@ void Tutorial::LinesPipeline::create(RTG& rtg, VkRenderPass render_pass, uint32_
         std::array<VkDescriptorSetLayoutBinding, 1> bindings {
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
-                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, //(Camera lives in the workspace's per-frame buffer)
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
             },
@@ -4,10 +4,16 @@
 #include "refsol.hpp"
 #include "VK.hpp"
 
+#include <algorithm>
+
 static uint32_t vert_code[] =
 #include "spv/objects.vert.inl"
 ;
 
+static uint32_t packed_vert_code[] =
+#include "spv/objects-packed.vert.inl"
+;
+
 // Include both tone mapping variants
 static uint32_t frag_code_linear[] =
 #include "spv/objects.frag.tonemap_linear.inl"
@@ -20,7 +26,14 @@ static uint32_t frag_code_aces[] =
 
 void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint32_t subpass) {
 
-    VkShaderModule vert_module = rtg.helpers.create_shader_module(vert_code);
+    bool packed = (rtg.configuration.vertex_format == "packed");
+
+    VkShaderModule vert_module;
+    if (packed) {
+        vert_module = rtg.helpers.create_shader_module(packed_vert_code);
+    } else {
+        vert_module = rtg.helpers.create_shader_module(vert_code);
+    }
     VkShaderModule frag_module;
     
     if (rtg.configuration.tone_map_operator == "aces") {
@@ -35,7 +48,7 @@ void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint3
         std::array<VkDescriptorSetLayoutBinding, 3> bindings {
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
-                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, //(World and Transforms live in the workspace's per-frame buffer)
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
             },
@@ -66,7 +79,7 @@ void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint3
         std::array<VkDescriptorSetLayoutBinding, 1> bindings {
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
-                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
             },
@@ -81,14 +94,20 @@ void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint3
         VK(vkCreateDescriptorSetLayout(rtg.device, &create_info, nullptr, &set1_Transforms));
     }
 
-    {//set 3
-        std::array<VkDescriptorSetLayoutBinding, 1> bindings {
+    {//set 3 - Materials (binding 0) and TextureRects (binding 1)
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings {
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
                 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
             },
+            VkDescriptorSetLayoutBinding {
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+            },
         };
 
         VkDescriptorSetLayoutCreateInfo create_info {
@@ -100,42 +119,44 @@ void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint3
         VK(vkCreateDescriptorSetLayout(rtg.device, &create_info, nullptr, &set3_Material));
     }
 
-    {//set 2 - Texture samplers per slot
-        std::array<VkDescriptorSetLayoutBinding, 5> bindings {
+    {//set 2 - table of every material texture, indexed by the Material's *_tex fields
+        if (!rtg.device_features_12.runtimeDescriptorArray || !rtg.device_features_12.descriptorBindingPartiallyBound
+         || !rtg.device_features_12.descriptorBindingVariableDescriptorCount || !rtg.device_features.shaderSampledImageArrayDynamicIndexing) {
+            throw std::runtime_error("Objects pipeline needs descriptor indexing (runtime-sized, variable-count sampler arrays).");
+        }
+
+        //largest table the device allows, leaving room for the environment samplers in set 0:
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(rtg.physical_device, &props);
+        max_textures = std::min({
+            props.limits.maxPerStageDescriptorSamplers,
+            props.limits.maxPerStageDescriptorSampledImages,
+            props.limits.maxDescriptorSetSamplers,
+            props.limits.maxDescriptorSetSampledImages,
+        }) - 2;
+        max_textures = std::min(max_textures, MaxTextures);
+
+        std::array<VkDescriptorSetLayoutBinding, 1> bindings {
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
                 .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1,
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            },
-            VkDescriptorSetLayoutBinding {
-                .binding = 1,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1,
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            },
-            VkDescriptorSetLayoutBinding {
-                .binding = 2,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1,
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            },
-            VkDescriptorSetLayoutBinding {
-                .binding = 3,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1,
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            },
-            VkDescriptorSetLayoutBinding {
-                .binding = 4,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1,
+                .descriptorCount = max_textures,
                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
             },
         };
+        //actual size is picked when allocating (once the scene's textures are known):
+        std::array<VkDescriptorBindingFlags, 1> binding_flags {
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT,
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount = uint32_t(binding_flags.size()),
+            .pBindingFlags = binding_flags.data(),
+        };
 
         VkDescriptorSetLayoutCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = &flags_info,
             .bindingCount = uint32_t(bindings.size()),
             .pBindings = bindings.data(),
         };
@@ -251,7 +272,7 @@ void Tutorial::ObjectsPipeline::create(RTG& rtg, VkRenderPass render_pass, uint3
             .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
             .stageCount = uint32_t(stages.size()),
             .pStages = stages.data(),
-            .pVertexInputState = &Vertex::array_input_state,
+            .pVertexInputState = (packed ? &PackedVertex::array_input_state : &Vertex::array_input_state),
             .pInputAssemblyState = &input_assembly_state,
             .pViewportState = &viewport_state,
             .pRasterizationState = &rasterization_state,
@@ -3,6 +3,11 @@
 #include "VK.hpp"
 #include "S72.hpp"
 #include "Timer.hpp"
+#include "KTX2.hpp"
+#include "MeshLoader.hpp"
+#include "MeshOptimizer.hpp"
+#include "TextureAtlas.hpp"
+#include "MappedFile.hpp"
 //#include "refsol.hpp"
 
 #include <GLFW/glfw3.h>
@@ -16,7 +21,10 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
+#include <map>
 #include <numeric>
+#include <optional>
 #include <memory>
 #include <algorithm>
 
@@ -37,14 +45,49 @@ void flip_image_y_inplace_rgba(uint8_t* pixels, int width, int height)
     }
 }
 
+//decode an image to RGBA8 (thread-safe, so can run on a pool):
+static SceneCache::Image decode_image(std::string const &path, bool flip_y) {
+	int width, height, channels;
+	unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!data) {
+		throw std::runtime_error("Failed to load texture image: " + path);
+	}
+	if (flip_y) flip_image_y_inplace_rgba(data, width, height);
+
+	SceneCache::Image image;
+	image.width = uint32_t(width);
+	image.height = uint32_t(height);
+	image.texels = data;
+	image.storage = std::shared_ptr< uint8_t const >(data, [](uint8_t const *p){ stbi_image_free(const_cast< uint8_t * >(p)); });
+	return image;
+}
+
+static std::string image_key(std::string const &path, bool flip_y) {
+	return (flip_y ? "flipped:" : "plain:") + path;
+}
+
 Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 	//refsol::Tutorial_constructor(rtg, &depth_format, &render_pass, &command_pool);
+	Timer startup_timer([](double elapsed){
+		std::cout << "Scene ready in " << elapsed * 1000.0 << " ms." << std::endl;
+	});
 	viewport_rect = {0, 0, rtg.configuration.surface_extent.width, rtg.configuration.surface_extent.height};
 	//Scene Graph
-	try {
-		s72 = S72::load(rtg.configuration.scene_file);
-	} catch (std::exception &e) {
-		std::cerr << "Failed to load s72-format scene from '" << rtg.configuration.scene_file << "':\n" << e.what() << std::endl;
+	if (rtg.configuration.scene_cache != "") {
+		//payload depends on these options, so they are part of the cache's key:
+		std::string key = "vertex-format " + rtg.configuration.vertex_format + (rtg.configuration.optimize_meshes ? ", optimized" : "");
+		scene_cache = SceneCache::load(rtg.configuration.scene_cache, rtg.configuration.scene_file, key, &s72);
+		if (!scene_cache) scene_cache = std::make_unique< SceneCache >(key);
+	}
+	if (!scene_cache || !scene_cache->loaded) {
+		try {
+			S72::LoadTimings timings;
+			s72 = S72::load(rtg.configuration.scene_file, &timings);
+			std::cout << "Loaded scene '" << rtg.configuration.scene_file << "': parse " << timings.parse << " ms, resolve "
+			          << timings.resolve << " ms, paths " << timings.paths << " ms." << std::endl;
+		} catch (std::exception &e) {
+			std::cerr << "Failed to load s72-format scene from '" << rtg.configuration.scene_file << "':\n" << e.what() << std::endl;
+		}
 	}
 
 	if(rtg.configuration.print){
@@ -63,6 +106,92 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 		}
 	}
 
+	{ //start decoding every image the constructor uploads, and find flat textures whose image files are byte-identical to an
+		// earlier one's (in the same format), so they can share its image:
+		// (S72 only merges textures with the same src + type + format; exported scenes often have many copies of one image under different names)
+		// (decodes overlap with pipeline + mesh setup; uploads still happen one at a time as each image is reached)
+		image_pool = std::make_unique< ThreadPool >();
+		texture_same_as.resize(s72.tables.textures.size());
+		std::iota(texture_same_as.begin(), texture_same_as.end(), 0u);
+
+		//textures that will be decoded (images with an up-to-date baked version are uploaded from that instead, and images in
+		// the scene cache are already decoded, so neither is worth comparing):
+		std::vector< S72::Texture const * > decoded;
+		for (S72::Texture const *tex : s72.tables.textures) {
+			if (tex->type != S72::Texture::Type::flat) continue;
+			if (has_baked(tex->path) || (scene_cache && scene_cache->find_image(tex->path, true))) continue;
+			decoded.emplace_back(tex);
+		}
+
+		//only files whose size (and format) matches another's can be identical; hash just those, on the pool:
+		std::map< std::pair< uintmax_t, S72::Texture::Format >, std::vector< S72::Texture const * > > by_size;
+		for (S72::Texture const *tex : decoded) {
+			std::error_code error;
+			uintmax_t size = std::filesystem::file_size(tex->path, error);
+			if (error) continue; //(loading it reports the problem)
+			by_size[std::make_pair(size, tex->format)].emplace_back(tex);
+		}
+		struct Hashed {
+			S72::Texture const *tex;
+			std::future< uint64_t > hash;
+		};
+		std::vector< std::vector< Hashed > > collisions;
+		std::vector< bool > colliding(s72.tables.textures.size(), false);
+		for (auto const &[key, texs] : by_size) {
+			if (texs.size() < 2) continue;
+			std::vector< Hashed > &group = collisions.emplace_back();
+			for (S72::Texture const *tex : texs) {
+				colliding[tex->index] = true;
+				auto task = std::make_shared< std::packaged_task< uint64_t() > >([path = tex->path]() -> uint64_t {
+					MappedFile file(path);
+					uint64_t hash = 14695981039346656037ull; //FNV-1a
+					for (size_t i = 0; i < file.size(); ++i) {
+						hash = (hash ^ file.data()[i]) * 1099511628211ull;
+					}
+					return hash;
+				});
+				group.emplace_back(Hashed{ .tex = tex, .hash = task->get_future() });
+				image_pool->run([task](){ (*task)(); });
+			}
+		}
+
+		//start decoding everything that can't have a duplicate (queued after the hashes, so they aren't held up):
+		if (!s72.environments.empty()) {
+			std::string const &radiance = s72.environments.begin()->second.radiance->path;
+			if (!has_baked(radiance)) prefetch_image(radiance, false);
+			std::string const &lambertian = rtg.configuration.lambertian_env_output;
+			if (lambertian != "" && !has_baked(lambertian)) prefetch_image(lambertian, false);
+		}
+		for (S72::Texture const *tex : decoded) {
+			if (!colliding[tex->index]) prefetch_image(tex->path, true);
+		}
+
+		//confirm matching hashes byte-for-byte, then decode the first of each set of identical files:
+		for (std::vector< Hashed > &group : collisions) {
+			std::vector< std::pair< uint64_t, S72::Texture const * > > firsts;
+			for (Hashed &hashed : group) {
+				uint64_t hash = 0;
+				try {
+					hash = hashed.hash.get();
+				} catch (std::exception &) {
+					continue; //(loading it reports the problem)
+				}
+				for (auto const &[other_hash, other] : firsts) {
+					if (other_hash != hash) continue;
+					MappedFile file(hashed.tex->path), other_file(other->path);
+					if (other_file.size() == file.size() && std::memcmp(other_file.data(), file.data(), file.size()) == 0) {
+						texture_same_as[hashed.tex->index] = other->index;
+						break;
+					}
+				}
+				if (texture_same_as[hashed.tex->index] == hashed.tex->index) {
+					firsts.emplace_back(hash, hashed.tex);
+					prefetch_image(hashed.tex->path, true);
+				}
+			}
+		}
+	}
+
 	// Initialize culling mode from configuration
 	{
 		std::string c = rtg.configuration.culling;
@@ -184,25 +313,29 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 
 	{//create descriptor pool:
 		uint32_t per_workspace = uint32_t(rtg.workspaces.size());
-		std::array<VkDescriptorPoolSize, 3> pool_sizes {
+		std::array<VkDescriptorPoolSize, 4> pool_sizes {
+			VkDescriptorPoolSize{
+				.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+				.descriptorCount = 2 * per_workspace, //Camera, World per workspace
+			},
 			VkDescriptorPoolSize{
-				.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-				.descriptorCount = 2 * per_workspace,
+				.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+				.descriptorCount = 1 * per_workspace, //Transforms per workspace
 			},
 			VkDescriptorPoolSize{
 				.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-				.descriptorCount = 2 * per_workspace,
+				.descriptorCount = 2, //shared Material, TextureRects
 			},
 			VkDescriptorPoolSize{
 				.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				.descriptorCount = 1 * per_workspace,
+				.descriptorCount = 2 * per_workspace, //Env + Env_Lambertian in each World set
 			},
 		};
 
 		VkDescriptorPoolCreateInfo create_info {
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
 			.flags = 0,
-			.maxSets = 5 * per_workspace,
+			.maxSets = 3 * per_workspace + 1, //Camera, World, Transforms per workspace + shared Material
 			.poolSizeCount = uint32_t(pool_sizes.size()),
 			.pPoolSizes = pool_sizes.data(),
 		};
@@ -211,357 +344,141 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 	}
 
 
-	workspaces.resize(rtg.workspaces.size());
-	for (Workspace &workspace : workspaces) {
-		//refsol::Tutorial_constructor_workspace(rtg, command_pool, &workspace.command_buffer);
-		{//allocate command buffer:
-			VkCommandBufferAllocateInfo alloc_info {
-				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-				.commandPool = command_pool,
-				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				.commandBufferCount = 1,
-			};
-			VK(vkAllocateCommandBuffers(rtg.device, &alloc_info, &workspace.command_buffer));
+	//environment cube maps (immutable, so shared by all workspaces):
+	if (s72.environments.size() > 0) {//ENV
+		{
+			const S72::Texture &tex = *s72.environments.begin()->second.radiance; // for now just take the first environment's radiance texture
+			assert(tex.type == S72::Texture::Type::cube && tex.format == S72::Texture::Format::rgbe);
+			Env_src = load_rgbe_cube(tex.path);
 		}
 
-		{ //camera
-			workspace.Camera_src = rtg.helpers.create_buffer(
-				sizeof(LinesPipeline::Camera),
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				Helpers::Mapped
-			);
-
-			workspace.Camera = rtg.helpers.create_buffer(
-					sizeof(LinesPipeline::Camera),
-					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					Helpers::Unmapped
-			);
-			//Descriptor set
-			{
-				VkDescriptorSetAllocateInfo alloc_info {
-					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-					.descriptorPool = descriptor_pool,
-					.descriptorSetCount = 1,
-					.pSetLayouts = &lines_pipeline.set0_Camera,
-				};
-
-				VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Camera_descriptors));
-			}
-			{
-				VkDescriptorSetAllocateInfo alloc_info {
-					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-					.descriptorPool = descriptor_pool,
-					.descriptorSetCount = 1,
-					.pSetLayouts = &objects_pipeline.set1_Transforms,
-				};
+		{
+			VkImageViewCreateInfo create_info {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.flags = 0,
+				.image = Env_src.handle,
+				.viewType = VK_IMAGE_VIEW_TYPE_CUBE,
+				.format = Env_src.format,
+				.subresourceRange{
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = 0,
+					.levelCount = Env_src.mipLevels,
+					.baseArrayLayer = 0,
+					.layerCount = Env_src.arrayLayers,
+				},
+			};
 
-				VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Transforms_descriptors));
-			}
+			VK(vkCreateImageView(rtg.device, &create_info, nullptr, &Env));
 		}
 
-		{//World
-			workspace.World_src = rtg.helpers.create_buffer(
-				sizeof(ObjectsPipeline::World),
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				Helpers::Mapped
-			);
-
-			workspace.World = rtg.helpers.create_buffer(
-					sizeof(ObjectsPipeline::World),
-					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					Helpers::Unmapped
-			);
-			//Descriptor set
-			{
-				VkDescriptorSetAllocateInfo alloc_info {
-					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-					.descriptorPool = descriptor_pool,
-					.descriptorSetCount = 1,
-					.pSetLayouts = &objects_pipeline.set0_World,
-				};
+		{
+			VkSamplerCreateInfo create_info {
+				.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+				.flags = 0,
+				.magFilter = VK_FILTER_NEAREST,
+				.minFilter = VK_FILTER_NEAREST,
+				.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+				.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+				.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+				.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+				.mipLodBias = 0.0f,
+				.anisotropyEnable = VK_FALSE,
+				.maxAnisotropy = 0.0f,
+				.compareEnable = VK_FALSE,
+				.compareOp = VK_COMPARE_OP_ALWAYS,
+				.minLod = 0.0f,
+				.maxLod = 0.0f,
+				.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+				.unnormalizedCoordinates = VK_FALSE,
+			};
 
-				VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.World_descriptors));
-			}
+			VK(vkCreateSampler(rtg.device, &create_info, nullptr, &env_sampler));
 		}
 
-		if (s72.environments.size() > 0) {//ENV
-			{
-				// decide texture format and whether this is a cubemap
-				const S72::Texture &tex = *s72.environments.begin()->second.radiance; // for now just take the first environment's radiance texture
-				int width, height, channels;
-				unsigned char* data = stbi_load(tex.path.c_str(), &width, &height, &channels, 4);
-				if (!data) {
-					throw std::runtime_error("Failed to load env texture image: " + tex.path);
-				}
-				// flip to match Vulkan coordinate system
-				//flip_image_y_inplace_rgba(data, width, height);
-				
-				bool isCube = (tex.type == S72::Texture::Type::cube);
-				bool isRGBE = (tex.format == S72::Texture::Format::rgbe);
-
-				assert(isCube && isRGBE);
-
-				if (height % 6 != 0) {
-					throw std::runtime_error("Warning: cube texture " + tex.path + " height not divisible by 6; treating as 2D.");
-				}
-
-				// decode RGBE into float32 RGBA per pixel, and use R32G32B32A32_SFLOAT
-				uint32_t faceWidth = width;
-				uint32_t faceHeight = height / 6;
-				uint32_t layers = 6u;
-				// create CPU-side float buffer for all layers concatenated
-				std::vector<float> float_data;
-				float_data.reserve(size_t(faceWidth) * faceHeight * 4 * layers);
-
-				for (uint32_t layer = 0; layer < layers; ++layer) {
-					for (uint32_t y = 0; y < faceHeight; ++y) {
-						for (uint32_t x = 0; x < faceWidth; ++x) {
-							// vertical strip: faces stacked in Y, so offset Y by layer
-							uint32_t src_y = layer * faceHeight + y;
-							size_t idx = (size_t(src_y) * faceWidth + x);  // x is just x, no layer offset
-
-							glm::u8vec4 col(data[idx*4+0], data[idx*4+1], data[idx*4+2], data[idx*4+3]);
-							glm::vec3 rgb = rgbe_to_float(col);
-
-							float_data.push_back(rgb.r);
-							float_data.push_back(rgb.g);
-							float_data.push_back(rgb.b);
-							float_data.push_back(1.0f);
-						}
-					}
-				}
-
-				// create GPU image as float32 RGBA with arrayLayers = layers and cube flag if needed
-				workspace.Env_src = rtg.helpers.create_image(
-					VkExtent2D{.width = faceWidth, .height = faceHeight},
-					VK_FORMAT_R32G32B32A32_SFLOAT,
-					VK_IMAGE_TILING_OPTIMAL,
-					VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					Helpers::Unmapped,
-					VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-					layers
-				);
-
-				size_t byte_size = float_data.size() * sizeof(float);
-				rtg.helpers.transfer_to_image(float_data.data(), byte_size, workspace.Env_src);
-
-				stbi_image_free(data);
-			}
-
-			{
-				VkImageViewCreateInfo create_info {
-					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-					.flags = 0,
-					.image = workspace.Env_src.handle,
-					.viewType = VK_IMAGE_VIEW_TYPE_CUBE,
-					.format = workspace.Env_src.format,
-					.subresourceRange{
-						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-						.baseMipLevel = 0,
-						.levelCount = 1,
-						.baseArrayLayer = 0,
-						.layerCount = workspace.Env_src.arrayLayers,
-					},
-				};
-
-				VK(vkCreateImageView(rtg.device, &create_info, nullptr, &workspace.Env));
-			}
-
-			{
-				VkSamplerCreateInfo create_info {
-					.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-					.flags = 0,
-					.magFilter = VK_FILTER_NEAREST,
-					.minFilter = VK_FILTER_NEAREST,
-					.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
-					.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-					.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-					.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-					.mipLodBias = 0.0f,
-					.anisotropyEnable = VK_FALSE,
-					.maxAnisotropy = 0.0f,
-					.compareEnable = VK_FALSE,
-					.compareOp = VK_COMPARE_OP_ALWAYS,
-					.minLod = 0.0f,
-					.maxLod = 0.0f,
-					.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
-					.unnormalizedCoordinates = VK_FALSE,
-				};
-
-				VK(vkCreateSampler(rtg.device, &create_info, nullptr, &workspace.env_sampler));
-			}
-
-			std::string lambertian_path = rtg.configuration.lambertian_env_output;
-			if (lambertian_path != "") { // lambertian cubemap
-				//std::string lambertian_path = rtg.configuration.lambertian_env_output;
-				assert(lambertian_path != "");
-				int width, height, channels;
-				unsigned char* data = stbi_load(lambertian_path.c_str(), &width, &height, &channels, 4);
-				if (!data) {
-					throw std::runtime_error("Failed to load env texture image: " + lambertian_path);
-				}
-				// flip to match Vulkan coordinate system
-				//flip_image_y_inplace_rgba(data, width, height);
-
-				if (height % 6 != 0) {
-					throw std::runtime_error("Warning: cube lambertian texture " + lambertian_path + " height not divisible by 6; treating as 2D.");
-				}
-
-				// decode RGBE into float32 RGBA per pixel, and use R32G32B32A32_SFLOAT
-				uint32_t faceWidth = width;
-				uint32_t faceHeight = height / 6;
-				uint32_t layers = 6u;
-				// create CPU-side float buffer for all layers concatenated
-				std::vector<float> float_data;
-				float_data.reserve(size_t(faceWidth) * faceHeight * 4 * layers);
-
-				for (uint32_t layer = 0; layer < layers; ++layer) {
-					for (uint32_t y = 0; y < faceHeight; ++y) {
-						for (uint32_t x = 0; x < faceWidth; ++x) {
-							// vertical strip: faces stacked in Y, so offset Y by layer
-							uint32_t src_y = layer * faceHeight + y;
-							size_t idx = (size_t(src_y) * faceWidth + x);  // x is just x, no layer offset
-
-							glm::u8vec4 col(data[idx*4+0], data[idx*4+1], data[idx*4+2], data[idx*4+3]);
-							glm::vec3 rgb = rgbe_to_float(col);
-
-							float_data.push_back(rgb.r);
-							float_data.push_back(rgb.g);
-							float_data.push_back(rgb.b);
-							float_data.push_back(1.0f);
-						}
-					}
-				}
-
-				// create GPU image as float32 RGBA with arrayLayers = layers and cube flag if needed
-				workspace.Env_Lambertian_src = rtg.helpers.create_image(
-					VkExtent2D{.width = faceWidth, .height = faceHeight},
-					VK_FORMAT_R32G32B32A32_SFLOAT,
-					VK_IMAGE_TILING_OPTIMAL,
-					VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					Helpers::Unmapped,
-					VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-					layers
-				);
-
-				size_t byte_size = float_data.size() * sizeof(float);
-				rtg.helpers.transfer_to_image(float_data.data(), byte_size, workspace.Env_Lambertian_src);
-
-				stbi_image_free(data);
-			
+		std::string lambertian_path = rtg.configuration.lambertian_env_output;
+		if (lambertian_path != "") { // lambertian cubemap
+			//std::string lambertian_path = rtg.configuration.lambertian_env_output;
+			assert(lambertian_path != "");
+			Env_Lambertian_src = load_rgbe_cube(lambertian_path);
+		
 
-			
-				VkImageViewCreateInfo create_info {
-					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-					.flags = 0,
-					.image = workspace.Env_Lambertian_src.handle,
-					.viewType = VK_IMAGE_VIEW_TYPE_CUBE,
-					.format = workspace.Env_Lambertian_src.format,
-					.subresourceRange{
-						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-						.baseMipLevel = 0,
-						.levelCount = 1,
-						.baseArrayLayer = 0,
-						.layerCount = workspace.Env_Lambertian_src.arrayLayers,
-					},
-				};
+		
+			VkImageViewCreateInfo create_info {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.flags = 0,
+				.image = Env_Lambertian_src.handle,
+				.viewType = VK_IMAGE_VIEW_TYPE_CUBE,
+				.format = Env_Lambertian_src.format,
+				.subresourceRange{
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = 0,
+					.levelCount = Env_Lambertian_src.mipLevels,
+					.baseArrayLayer = 0,
+					.layerCount = Env_Lambertian_src.arrayLayers,
+				},
+			};
 
-				VK(vkCreateImageView(rtg.device, &create_info, nullptr, &workspace.Env_Lambertian));
-			}
+			VK(vkCreateImageView(rtg.device, &create_info, nullptr, &Env_Lambertian));
 		}
-		
-		{//Material
-			size_t matCount = std::max(size_t(1), s72.materials.size());
-			workspace.Material_src = rtg.helpers.create_buffer(
-					sizeof(ObjectsPipeline::Material) * matCount,
-					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					Helpers::Mapped
-			);
+	}
 
-			workspace.Material = rtg.helpers.create_buffer(
-				sizeof(ObjectsPipeline::Material) * matCount,
-				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				Helpers::Unmapped
-			);
+	{ //sub-allocations of the per-frame buffers get bound as uniform, storage, and vertex buffers, so need to meet all their offset alignments:
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(rtg.physical_device, &props);
+		frame_alignment = std::max({VkDeviceSize(16), props.limits.minUniformBufferOffsetAlignment, props.limits.minStorageBufferOffsetAlignment});
+	}
 
-			// rtg.helpers.transfer_to_buffer(materials.data(), bytes, Material);
+	workspaces.resize(rtg.workspaces.size());
+	for (Workspace &workspace : workspaces) {
+		//refsol::Tutorial_constructor_workspace(rtg, command_pool, &workspace.command_buffer);
+		{//allocate command buffer:
+			VkCommandBufferAllocateInfo alloc_info {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.commandPool = command_pool,
+				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1,
+			};
+			VK(vkAllocateCommandBuffers(rtg.device, &alloc_info, &workspace.command_buffer));
+		}
 
+		{ //descriptor sets (buffer bindings point into the per-frame buffer, see write_frame_descriptors):
 			VkDescriptorSetAllocateInfo alloc_info {
 				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 				.descriptorPool = descriptor_pool,
 				.descriptorSetCount = 1,
-				.pSetLayouts = &objects_pipeline.set3_Material,
+				.pSetLayouts = &lines_pipeline.set0_Camera,
 			};
+			VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Camera_descriptors));
 
-			VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Material_descriptors));
-		}
+			alloc_info.pSetLayouts = &objects_pipeline.set0_World;
+			VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.World_descriptors));
 
-		//descriptor write
-		{
-			VkDescriptorBufferInfo Camera_info{
-				.buffer = workspace.Camera.handle,
-				.offset = 0,
-				.range = workspace.Camera.size,
-			};
-			VkDescriptorBufferInfo World_info{
-					.buffer = workspace.World.handle,
-					.offset = 0,
-					.range = workspace.World.size,
-			};
+			alloc_info.pSetLayouts = &objects_pipeline.set1_Transforms;
+			VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Transforms_descriptors));
+		}
 
-			VkDescriptorBufferInfo Material_info{
-				.buffer = workspace.Material.handle,
-				.offset = 0,
-				.range = workspace.Material.size,
-			};
+		//per-frame buffer, sized for a frame's Camera + World + a few transforms to start; render() grows it if needed:
+		workspace.Transforms_range = 64 * sizeof(ObjectsPipeline::Transform);
+		workspace.Frame = rtg.helpers.create_dynamic_buffer(
+			VkDeviceSize(64) << 10,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+		);
+		write_frame_descriptors(workspace);
 
+		//environment maps (shared by all workspaces):
+		{
 			VkDescriptorImageInfo Env_info{
-					.sampler = workspace.env_sampler,
-					.imageView = workspace.Env,
+					.sampler = env_sampler,
+					.imageView = Env,
 					.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 			};
 			VkDescriptorImageInfo Env_Lambertian_info{
-					.sampler = workspace.env_sampler,
-					.imageView = workspace.Env_Lambertian,
+					.sampler = env_sampler,
+					.imageView = Env_Lambertian,
 					.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 			};
 
-			std::array<VkWriteDescriptorSet, 5> writes{
-				VkWriteDescriptorSet{
-					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-					.dstSet = workspace.Camera_descriptors,
-					.dstBinding = 0,
-					.dstArrayElement = 0,
-					.descriptorCount = 1,
-					.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-					.pBufferInfo = &Camera_info,
-				},
-				VkWriteDescriptorSet{
-					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-					.dstSet = workspace.World_descriptors,
-					.dstBinding = 0,
-					.dstArrayElement = 0,
-					.descriptorCount = 1,
-					.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-					.pBufferInfo = &World_info,
-				},
-				VkWriteDescriptorSet{
-					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-					.dstSet = workspace.Material_descriptors,
-					.dstBinding = 0,
-					.dstArrayElement = 0,
-					.descriptorCount = 1,
-					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-					.pBufferInfo = &Material_info,
-				},
+			std::array<VkWriteDescriptorSet, 2> writes{
 				VkWriteDescriptorSet{
 					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 					.dstSet = workspace.World_descriptors,
@@ -581,16 +498,18 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 					.pImageInfo = &Env_Lambertian_info,
 				},
 			};
-			bool has_env = (workspace.Env != VK_NULL_HANDLE && workspace.env_sampler != VK_NULL_HANDLE);
-			bool has_env_lambertian = (workspace.Env_Lambertian != VK_NULL_HANDLE);
-			uint32_t write_count = has_env ? (has_env_lambertian ? 5 : 4) : 3;
-			vkUpdateDescriptorSets(
-				rtg.device,
-				write_count,
-				writes.data(),
-				0, //descriptor copy count
-				nullptr
-			);
+			bool has_env = (Env != VK_NULL_HANDLE && env_sampler != VK_NULL_HANDLE);
+			bool has_env_lambertian = (Env_Lambertian != VK_NULL_HANDLE);
+			uint32_t write_count = has_env ? (has_env_lambertian ? 2 : 1) : 0;
+			if (write_count > 0) {
+				vkUpdateDescriptorSets(
+					rtg.device,
+					write_count,
+					writes.data(),
+					0, //descriptor copy count
+					nullptr
+				);
+			}
 		}
 	}
 
@@ -624,14 +543,11 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 				.flags = ObjectsPipeline::BRDF_LAMBERTIAN,
 				.roughness = 0.5f,
 				.metalness = 0.0f,
-				.padding_scalar = 0,
+				.displacement_tex = 0,
 			});
-			uint32_t index = 0;
-			material_ptr_to_index.clear();
-			for (auto &pair : s72.materials) {
-				const S72::Material& mat = pair.second; 
-				material_ptr_to_index[&pair.second] = index;
-				ObjectsPipeline::Material& mat_out = materials[index];
+			for (S72::Material const *mat_ptr : s72.tables.materials) {
+				const S72::Material& mat = *mat_ptr;
+				ObjectsPipeline::Material& mat_out = materials[mat.index];
 				if (auto* p = std::get_if<S72::Material::PBR>(&mat.brdf)) {
 					mat_out.flags = ObjectsPipeline::BRDF_PBR;
 					if (auto* albedo =  std::get_if<S72::color>(&p->albedo)) {
@@ -674,8 +590,6 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 				if (mat.displacement_map != nullptr) {
 					mat_out.flags |= ObjectsPipeline::MAT_FLAG_HAS_DISPLACEMENT_TEX;
 				}
-				
-				index++;
 			}
 		} else {
 			materials.emplace_back(ObjectsPipeline::Material{
@@ -683,77 +597,153 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 				.flags = ObjectsPipeline::BRDF_LAMBERTIAN,
 				.roughness = 0.5f,
 				.metalness = 0.0f,
-				.padding_scalar = 0,
+				.displacement_tex = 0,
 			});
 		}
 	}
 
 	{ //objects
 		std::vector< PosNorTanTexVertex > vertices;
-		uint32_t first_offset = 0;
-		for (auto const &pair : s72.meshes) {
-			const std::string& mesh_name = pair.first;
-			const S72::Mesh&   mesh      = pair.second;
-			ObjectVertices obj_vertices{
-				.first = first_offset,
-				.count = mesh.count,
-			};
-			std::cout << "Parsing mesh: " << mesh_name << std::endl;
-			//read attributes
-			auto getAttribute = [&mesh](const std::string& _name) -> const S72::Mesh::Attribute& {
-				auto it = mesh.attributes.find(_name);
-				if (it != mesh.attributes.end()) {
-					return it->second;
-				} else {
-					throw std::runtime_error("Attribute not found: " + mesh.name + ": " +  _name);
+		std::vector< uint32_t > indices;
+		MeshLoader loader;
+		packed_vertices = (rtg.configuration.vertex_format == "packed");
+
+		//what ends up in the vertex/index buffers:
+		void const *vertex_data = nullptr;
+		size_t vertex_bytes = 0;
+		std::vector< ObjectsPipeline::PackedVertex > packed;
+
+		bool from_cache = (scene_cache && scene_cache->loaded);
+		if (from_cache) {
+			//ranges + final (packed/optimized) payloads come straight out of the mapped cache file:
+			uint32_t stride = uint32_t(packed_vertices ? sizeof(ObjectsPipeline::PackedVertex) : sizeof(PosNorTanTexVertex));
+			if (scene_cache->vertex_stride != stride) {
+				throw std::runtime_error("Scene cache '" + rtg.configuration.scene_cache + "' has vertex stride " + std::to_string(scene_cache->vertex_stride) + ", expected " + std::to_string(stride) + ".");
+			}
+			object_vertices_list.resize(s72.tables.meshes.size());
+			for (auto const &[mesh_name, mesh] : scene_cache->meshes) {
+				auto f = s72.meshes.find(mesh_name);
+				if (f == s72.meshes.end()) throw std::runtime_error("Scene cache '" + rtg.configuration.scene_cache + "' has ranges for unknown mesh '" + mesh_name + "'.");
+				object_vertices_list[f->second.index] = ObjectVertices{
+					.first = mesh.first,
+					.count = mesh.count,
+					.first_index = mesh.first_index,
+					.index_count = mesh.index_count,
+					.min_aabb_bound = mesh.min_aabb_bound,
+					.max_aabb_bound = mesh.max_aabb_bound,
+				};
+			}
+			vertex_data = scene_cache->vertices;
+			vertex_bytes = scene_cache->vertices_size;
+			std::cout << "Loaded " << scene_cache->meshes.size() << " meshes (" << vertex_bytes << " vertex bytes, "
+			          << scene_cache->indices_count << " indices) from scene cache." << std::endl;
+		} else {
+			Timer timer([&](double elapsed){
+				std::cout << "Loaded " << loader.meshes_loaded << " meshes (" << vertices.size() << " vertices, "
+				          << indices.size() << " indices in " << loader.indexed_meshes << " indexed meshes, "
+				          << loader.fast_path_meshes << " by direct copy) from " << loader.files.size() << " data files ("
+				          << loader.bytes_mapped << " bytes mapped) in " << elapsed * 1000.0 - loader.optimize_ms << " ms." << std::endl;
+			});
+
+			//reserve once so the per-mesh appends don't reallocate:
+			// (for indexed meshes this over-reserves vertices, which is fine)
+			size_t total = 0;
+			size_t total_indices = 0;
+			for (S72::Mesh const *mesh : s72.tables.meshes) {
+				total += mesh->count;
+				if (mesh->indices) total_indices += mesh->count;
+			}
+			vertices.reserve(total);
+			indices.reserve(total_indices);
+
+			object_vertices_list.reserve(s72.tables.meshes.size());
+			for (S72::Mesh const *mesh_ptr : s72.tables.meshes) {
+				const S72::Mesh& mesh = *mesh_ptr;
+				//copy attributes (and indices) out of the mapped data files, growing the AABB as we go:
+				// (indices stay relative to the mesh's first vertex, which is passed as vertexOffset when drawing)
+				MeshLoader::Range range = loader.append(mesh, vertices, indices, rtg.configuration.optimize_meshes);
+				ObjectVertices obj_vertices{
+					.first = range.first,
+					.count = range.count,
+					.first_index = range.first_index,
+					.index_count = range.index_count,
+					.min_aabb_bound = range.min,
+					.max_aabb_bound = range.max,
+				};
+
+				assert(object_vertices_list.size() == mesh.index);
+				object_vertices_list.emplace_back(obj_vertices);
+			}
+		}
+
+		if (!from_cache && rtg.configuration.optimize_meshes) {
+			MeshOptimizer::Stats const &stats = loader.optimize_stats;
+			std::cout << "Optimized " << stats.triangles << " triangles: vertices " << stats.vertices_before << " -> " << stats.vertices_after
+			          << ", ACMR (FIFO " << MeshOptimizer::DefaultCacheSize << ") " << stats.acmr_before() << " -> " << stats.acmr_after()
+			          << " (in " << loader.optimize_ms << " ms)." << std::endl;
+		}
+
+		if (from_cache) {
+			//payload in the cache file is already packed
+		} else if (packed_vertices) {
+			//quantize each mesh against its own AABB (the AABB is folded back in by makeInstanceData):
+			packed.resize(vertices.size());
+			for (ObjectVertices const &obj_vertices : object_vertices_list) {
+				float min[3] = {obj_vertices.min_aabb_bound.x, obj_vertices.min_aabb_bound.y, obj_vertices.min_aabb_bound.z};
+				float max[3] = {obj_vertices.max_aabb_bound.x, obj_vertices.max_aabb_bound.y, obj_vertices.max_aabb_bound.z};
+				for (uint32_t i = obj_vertices.first; i < obj_vertices.first + obj_vertices.count; ++i) {
+					packed[i] = ObjectsPipeline::PackedVertex::pack(vertices[i], min, max);
 				}
-			};
-			const auto& position = getAttribute("POSITION");
-			// S72::Mesh::Attribute normal = mesh.attributes["NORMAL"];
-			// S72::Mesh::Attribute tangent = mesh.attributes["TANGENT"];
-			// S72::Mesh::Attribute texCoord = mesh.attributes["TEXCOORD"];
-			std::ifstream in(position.src.path, std::ios::binary);
-			if (!in) throw std::runtime_error("Failed to open data file: " + position.src.path);
-			//std::cout << "position info" << position.src.path << " stride: " << position.stride << position.offset << std::endl;
-			for (uint32_t i = 0; i < mesh.count; ++i) {
-				vertices.emplace_back(); 
-				assert(vertices.size() == (first_offset + i + 1));
-				PosNorTanTexVertex& v = vertices[first_offset + i];
-				// POSITION: R32G32B32_SFLOAT, offset 0, stride 48 (example)
-				in.seekg(i * position.stride + position.offset, std::ios::beg);
-				in.read(reinterpret_cast<char*>(&v.Position), sizeof(v.Position));
-				obj_vertices.min_aabb_bound.x = std::min(obj_vertices.min_aabb_bound.x, v.Position.x);
-				obj_vertices.min_aabb_bound.y = std::min(obj_vertices.min_aabb_bound.y, v.Position.y);
-				obj_vertices.min_aabb_bound.z = std::min(obj_vertices.min_aabb_bound.z, v.Position.z);
-
-				obj_vertices.max_aabb_bound.x = std::max(obj_vertices.max_aabb_bound.x, v.Position.x);
-				obj_vertices.max_aabb_bound.y = std::max(obj_vertices.max_aabb_bound.y, v.Position.y);
-				obj_vertices.max_aabb_bound.z = std::max(obj_vertices.max_aabb_bound.z, v.Position.z);
-				//std::cout << "Vertex " << i << " position: " << v.Position.x << v.Position.y << v.Position.z << std::endl;
-				// NORMAL
-				// in.seekg(i * normal.stride + normal.offset, std::ios::beg);
-				in.read(reinterpret_cast<char*>(&v.Normal), sizeof(v.Normal));
-				// TANGENT: R32G32B32A32_SFLOAT, offset 24, stride 48
-				// in.seekg(i * tangent.stride + tangent.offset, std::ios::beg);
-				in.read(reinterpret_cast<char*>(&v.Tangent), sizeof(v.Tangent));
-				// TEXCOORD: R32G32_SFLOAT, offset 40, stride 48
-				// in.seekg(i * texCoord.stride + texCoord.offset, std::ios::beg);
-				in.read(reinterpret_cast<char*>(&v.TexCoord), sizeof(v.TexCoord));
 			}
-			first_offset += mesh.count;
-			object_vertices_list.emplace(mesh_name, obj_vertices); 
+			vertex_data = packed.data();
+			vertex_bytes = packed.size() * sizeof(packed[0]);
+			std::cout << "Packed vertices: " << vertex_bytes << " bytes (vs " << vertices.size() * sizeof(vertices[0]) << " unpacked)." << std::endl;
+		} else {
+			vertex_data = vertices.data();
+			vertex_bytes = vertices.size() * sizeof(vertices[0]);
+		}
+
+		uint32_t const *index_data = (from_cache ? scene_cache->indices : indices.data());
+		size_t index_count = (from_cache ? scene_cache->indices_count : indices.size());
+
+		if (scene_cache && !from_cache) {
+			//record exactly what gets uploaded:
+			scene_cache->set_vertices(vertex_data, vertex_bytes, uint32_t(packed_vertices ? sizeof(ObjectsPipeline::PackedVertex) : sizeof(PosNorTanTexVertex)));
+			scene_cache->set_indices(index_data, index_count);
+			for (uint32_t m = 0; m < object_vertices_list.size(); ++m) {
+				ObjectVertices const &obj_vertices = object_vertices_list[m];
+				scene_cache->meshes.emplace(s72.tables.meshes[m]->name, SceneCache::Mesh{
+					.first = obj_vertices.first,
+					.count = obj_vertices.count,
+					.first_index = obj_vertices.first_index,
+					.index_count = obj_vertices.index_count,
+					.min_aabb_bound = obj_vertices.min_aabb_bound,
+					.max_aabb_bound = obj_vertices.max_aabb_bound,
+				});
+			}
 		}
-		
-		size_t bytes = vertices.size() * sizeof(vertices[0]);
 
 		object_vertices = rtg.helpers.create_buffer(
-			bytes,
+			vertex_bytes,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			Helpers::Unmapped
 		);
 
-		rtg.helpers.transfer_to_buffer(vertices.data(), bytes, object_vertices);
+		rtg.helpers.upload_buffer(vertex_data, vertex_bytes, object_vertices);
+
+		if (index_count != 0) {
+			size_t index_bytes = index_count * sizeof(uint32_t);
+
+			object_indices = rtg.helpers.create_buffer(
+				index_bytes,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				Helpers::Unmapped
+			);
+
+			rtg.helpers.upload_buffer(index_data, index_bytes, object_indices);
+		}
 	}
 
 	// Helper function to map S72 texture format to Vulkan format
@@ -771,49 +761,215 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 	};
 
 	{//texture
+		//decoded textures that turn out to be one flat color get folded into the Material scalars instead of uploaded, if every use allows it:
+		// (albedo, roughness, and metalness have scalar fallbacks; a normal map only if it's the "straight out" normal; displacement never)
+		enum : uint8_t { UseScalar = 1, UseNormal = 2, UseOther = 4 };
+		std::vector< uint8_t > texture_uses(s72.tables.textures.size(), 0); //by S72::Texture::index (of the first identical texture)
+		for (S72::Material const *mat : s72.tables.materials) {
+			auto use = [&](S72::Texture const *tex, uint8_t how) {
+				if (tex) texture_uses[texture_same_as[tex->index]] |= how;
+			};
+			if (auto* p = std::get_if<S72::Material::PBR>(&mat->brdf)) {
+				if (auto* tex = std::get_if<S72::Texture*>(&p->albedo)) use(*tex, UseScalar);
+				if (auto* tex = std::get_if<S72::Texture*>(&p->roughness)) use(*tex, UseScalar);
+				if (auto* tex = std::get_if<S72::Texture*>(&p->metalness)) use(*tex, UseScalar);
+			} else if (auto* l = std::get_if<S72::Material::Lambertian>(&mat->brdf)) {
+				if (auto* tex = std::get_if<S72::Texture*>(&l->albedo)) use(*tex, UseScalar);
+			}
+			use(mat->normal_map, UseNormal);
+			use(mat->displacement_map, UseOther);
+		}
+		std::vector< std::optional< std::array< uint8_t, 4 > > > constant_texels(s72.tables.textures.size()); //by S72::Texture::index, for folded textures
+		uint32_t folded = 0;
+
 		{ //make some textures
 			textures.reserve(1);
-			texture_ptr_to_index.clear();
-			if (!s72.textures.empty()) {
-				uint32_t index = 0;
-				// map S72 texture address -> index in textures/textures_views
-				for (auto& pair : s72.textures) {
-					texture_ptr_to_index[&pair.second] = index;
-					const S72::Texture& tex = pair.second;
-					int width, height, channels;
-					unsigned char* data = stbi_load(tex.path.c_str(), &width, &height, &channels, 4);
-					if (!data) {
-						throw std::runtime_error("Failed to load texture image: " + tex.path);
-					}
-					// flip to match Vulkan coordinate system
-					flip_image_y_inplace_rgba(data, width, height);
+			texture_slots.assign(s72.tables.textures.size(), std::numeric_limits<uint32_t>::max());
+			if (rtg.configuration.texture_budget_mb > 0) {
+				texture_streamer = std::make_unique< TextureStreamer >(rtg, textures, texture_views,
+					size_t(rtg.configuration.texture_budget_mb) << 20, uint32_t(rtg.workspaces.size()), rtg.configuration.mipmaps);
+			}
+			//small decoded textures (with --atlas-textures) wait here to get packed into atlas pages after the loop:
+			struct Atlased {
+				uint32_t id; //in texture_rects
+				VkFormat format;
+				SceneCache::Image image;
+			};
+			std::vector< Atlased > atlased;
+			auto try_atlas = [&](uint32_t id, VkFormat format, SceneCache::Image const &image) -> bool {
+				if (!rtg.configuration.atlas_textures || image.width > TextureAtlas::MaxSize || image.height > TextureAtlas::MaxSize) return false;
+				atlased.emplace_back(Atlased{ .id = id, .format = format, .image = image });
+				return true;
+			};
+
+			uint32_t deduplicated = 0; //textures sharing an identical earlier texture's id
 
+			//fold a just-decoded texture (which has just been given the last id) into constant_texels, if possible:
+			auto try_constant = [&](S72::Texture const &tex, SceneCache::Image const &image) -> bool {
+				uint8_t uses = texture_uses[tex.index];
+				if (uses & UseOther) return false;
+				size_t count = size_t(image.width) * image.height;
+				for (size_t i = 1; i < count; ++i) {
+					if (std::memcmp(image.texels + i * 4, image.texels, 4) != 0) return false;
+				}
+				std::array< uint8_t, 4 > texel{ image.texels[0], image.texels[1], image.texels[2], image.texels[3] };
+				if ((uses & UseNormal) && !(std::abs(int(texel[0]) - 128) <= 1 && std::abs(int(texel[1]) - 128) <= 1 && texel[2] >= 254)) return false;
+
+				assert(texture_slots[tex.index] + 1 == texture_rects.size());
+				texture_rects.pop_back();
+				texture_slots[tex.index] = std::numeric_limits<uint32_t>::max();
+				constant_texels[tex.index] = texel;
+				folded += 1;
+				return true;
+			};
+
+			if (!s72.textures.empty()) {
+				// map S72 texture index -> texture id (index in texture_rects)
+				for (S72::Texture const *tex_ptr : s72.tables.textures) {
+					const S72::Texture& tex = *tex_ptr;
 					
 					if (tex.type == S72::Texture::Type::flat) {
+						if (uint32_t same = texture_same_as[tex.index]; same != tex.index) {
+							//(earlier in the table, so already has an id)
+							texture_slots[tex.index] = texture_slots[same];
+							deduplicated += 1;
+							continue;
+						}
+
+						uint32_t id = uint32_t(texture_rects.size());
+						texture_slots[tex.index] = id;
+						//all of the next image (atlased textures get pointed at their page after the loop):
+						texture_rects.emplace_back(ObjectsPipeline::TextureRect{
+							.scale{ .x = 1.0f, .y = 1.0f },
+							.offset{ .x = 0.0f, .y = 0.0f },
+							.index = uint32_t(textures.size()),
+						});
+						//baked version (block-compressed, mips included) if there is one:
+						std::vector< VkFormat > baked_formats;
+						if (tex.format == S72::Texture::Format::srgb) baked_formats = {VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK};
+						else baked_formats = {VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK};
+						if (texture_streamer) {
+							//start with just the small levels; update() streams in finer ones as they are needed:
+							KTX2::File file;
+							if (open_baked(tex.path, baked_formats, 1, &file)) {
+								textures.emplace_back(texture_streamer->add(uint32_t(textures.size()), TextureStreamer::from_baked(std::move(file))));
+								baked_images_used += 1;
+							} else {
+								SceneCache::Image image = load_image(tex.path, true);
+								if (try_constant(tex, image)) continue;
+								if (try_atlas(id, getTextureFormat(tex.format), image)) continue;
+								textures.emplace_back(texture_streamer->add(uint32_t(textures.size()), TextureStreamer::from_rgba8(
+									image.width, image.height, image.texels, getTextureFormat(tex.format), tex.format == S72::Texture::Format::srgb
+								)));
+							}
+							continue;
+						}
+
+						Helpers::AllocatedImage baked;
+						if (load_baked(tex.path, baked_formats, 1, &baked)) {
+							textures.emplace_back(std::move(baked));
+							continue;
+						}
+
+						// flipped to match Vulkan coordinate system
+						SceneCache::Image image = load_image(tex.path, true);
+						uint32_t width = image.width, height = image.height;
+
 						// normal 2D texture
 						VkFormat texFormat = getTextureFormat(tex.format);
+						if (try_constant(tex, image)) continue;
+						if (try_atlas(id, texFormat, image)) continue;
+						// full mip chain, generated from level 0 by upload_image:
+						VkExtent2D extent{.width = width, .height = height};
+						uint32_t mip_levels = (rtg.configuration.mipmaps ? Helpers::full_mip_levels(extent) : 1);
 						
 						textures.emplace_back(rtg.helpers.create_image(
-							VkExtent2D{.width = uint32_t(width), .height = uint32_t(height)},
+							extent,
 							texFormat,
 							VK_IMAGE_TILING_OPTIMAL,
-							VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+							VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (mip_levels > 1 ? VkImageUsageFlags(VK_IMAGE_USAGE_TRANSFER_SRC_BIT) : 0),
 							VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-							Helpers::Unmapped
+							Helpers::Unmapped,
+							0,
+							1,
+							mip_levels
 						));
 
 						size_t image_size = size_t(width) * size_t(height) * 4; // 4 bytes per pixel (RGBA)
-						rtg.helpers.transfer_to_image(data, image_size, textures.back());
-
-						stbi_image_free(data);
-						index++;
+						rtg.helpers.upload_image(image.texels, image_size, textures.back());
 					} else if (tex.type == S72::Texture::Type::cube) {
 						continue; //skip in textures array
 					} else {
 						throw std::runtime_error("Unsupported texture type for texture: " + tex.path);
 					}
 				}
-			} 
+			} 
+
+			if (!atlased.empty()) {
+				//pages as large as the device allows, up to 2048 (and a multiple of the atlas alignment):
+				VkPhysicalDeviceProperties props;
+				vkGetPhysicalDeviceProperties(rtg.physical_device, &props);
+				uint32_t page_size = std::min(2048u, props.limits.maxImageDimension2D) / 8u * 8u;
+
+				uint32_t page_count = 0;
+				for (VkFormat format : {VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM}) {
+					std::vector< TextureAtlas::Input > inputs;
+					std::vector< uint32_t > ids;
+					for (Atlased const &small : atlased) {
+						if (small.format != format) continue;
+						inputs.emplace_back(TextureAtlas::Input{ .width = small.image.width, .height = small.image.height, .rgba = small.image.texels });
+						ids.emplace_back(small.id);
+					}
+					if (inputs.empty()) continue;
+
+					std::vector< TextureAtlas::Page > pages;
+					std::vector< TextureAtlas::Placement > placements;
+					TextureAtlas::pack(inputs, page_size, &pages, &placements);
+
+					uint32_t first_page = uint32_t(textures.size());
+					for (TextureAtlas::Page const &page : pages) {
+						VkExtent2D extent{.width = page.width, .height = page.height};
+						//(only as many levels as the gutters keep separate)
+						uint32_t mip_levels = (rtg.configuration.mipmaps ? std::min(TextureAtlas::MaxLevels, Helpers::full_mip_levels(extent)) : 1);
+						textures.emplace_back(rtg.helpers.create_image(
+							extent,
+							format,
+							VK_IMAGE_TILING_OPTIMAL,
+							VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (mip_levels > 1 ? VkImageUsageFlags(VK_IMAGE_USAGE_TRANSFER_SRC_BIT) : 0),
+							VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+							Helpers::Unmapped,
+							0,
+							1,
+							mip_levels
+						));
+						rtg.helpers.upload_image(page.rgba.data(), page.rgba.size(), textures.back());
+					}
+					for (uint32_t i = 0; i < inputs.size(); ++i) {
+						TextureAtlas::Placement const &at = placements[i];
+						TextureAtlas::Page const &page = pages[at.page];
+						texture_rects[ids[i]] = ObjectsPipeline::TextureRect{
+							.scale{ .x = inputs[i].width / float(page.width), .y = inputs[i].height / float(page.height) },
+							.offset{ .x = at.x / float(page.width), .y = at.y / float(page.height) },
+							.index = first_page + at.page,
+						};
+					}
+					page_count += uint32_t(pages.size());
+				}
+				std::cout << "Packed " << atlased.size() << " small textures into " << page_count << " atlas pages." << std::endl;
+				atlased.clear();
+			}
+
+			if (folded > 0) {
+				std::cout << "Folded " << folded << " single-color textures into material constants." << std::endl;
+			}
+			if (deduplicated > 0) {
+				std::cout << "Reused images for " << deduplicated << " textures whose image files duplicate an earlier texture's." << std::endl;
+			}
+
+			if (texture_streamer) {
+				std::cout << "Streaming " << texture_streamer->streams() << " textures within a " << rtg.configuration.texture_budget_mb << " MB budget ("
+				          << texture_streamer->resident_bytes / 1024 << " kB resident to start)." << std::endl;
+			}
 
 			if (textures.empty()) {
 				//dark grey / light grey checkerboard with a red square at the origin
@@ -849,7 +1005,79 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 				));
 
 				//transfer data
-				rtg.helpers.transfer_to_image(data.data(), sizeof(data[0]) * data.size(), textures.back());
+				rtg.helpers.upload_image(data.data(), sizeof(data[0]) * data.size(), textures.back());
+
+				//(no flat textures in the scene -- or all were folded -- so nothing refers to it; but the texture rect buffer can't be empty)
+				texture_rects.emplace_back(ObjectsPipeline::TextureRect{
+					.scale{ .x = 1.0f, .y = 1.0f },
+					.offset{ .x = 0.0f, .y = 0.0f },
+					.index = 0,
+				});
+			}
+		}
+
+		//materials refer to their textures by texture id (index in texture_rects, which says where in the texture table it is):
+		for (S72::Material const *mat : s72.tables.materials) {
+			ObjectsPipeline::Material &mat_out = materials[mat->index];
+			auto table_index = [&](S72::Texture const *tex) -> uint32_t {
+				if (tex == nullptr || texture_slots[tex->index] >= texture_rects.size()) return 0;
+				return texture_slots[tex->index];
+			};
+			S72::Texture const *albedo = nullptr, *roughness = nullptr, *metalness = nullptr;
+			if (auto* p = std::get_if<S72::Material::PBR>(&mat->brdf)) {
+				if (auto* tex = std::get_if<S72::Texture*>(&p->albedo)) albedo = *tex;
+				if (auto* tex = std::get_if<S72::Texture*>(&p->roughness)) roughness = *tex;
+				if (auto* tex = std::get_if<S72::Texture*>(&p->metalness)) metalness = *tex;
+			} else if (auto* l = std::get_if<S72::Material::Lambertian>(&mat->brdf)) {
+				if (auto* tex = std::get_if<S72::Texture*>(&l->albedo)) albedo = *tex;
+			}
+			mat_out.albedo_tex = table_index(albedo);
+			mat_out.normal_tex = table_index(mat->normal_map);
+			mat_out.displacement_tex = table_index(mat->displacement_map);
+			mat_out.roughness_tex = table_index(roughness);
+			mat_out.metalness_tex = table_index(metalness);
+
+			//single-color textures were folded; use their color in place of sampling them:
+			auto constant_color = [&](S72::Texture const *tex, vec4 *color) -> bool {
+				if (tex == nullptr) return false;
+				std::optional< std::array< uint8_t, 4 > > const &texel = constant_texels[texture_same_as[tex->index]];
+				if (!texel) return false;
+				float c[4];
+				for (uint32_t i = 0; i < 4; ++i) {
+					c[i] = (*texel)[i] / 255.0f;
+					//(decode as sampling the sRGB image would have)
+					if (i < 3 && tex->format == S72::Texture::Format::srgb) {
+						c[i] = (c[i] <= 0.04045f ? c[i] / 12.92f : std::pow((c[i] + 0.055f) / 1.055f, 2.4f));
+					}
+				}
+				*color = vec4(c[0], c[1], c[2], c[3]);
+				return true;
+			};
+			vec4 color;
+			if (constant_color(albedo, &color)) {
+				mat_out.albedo = vec4(color.r, color.g, color.b, 1.0f);
+				mat_out.flags &= ~ObjectsPipeline::MAT_FLAG_HAS_ALBEDO_TEX;
+			}
+			if (constant_color(roughness, &color)) {
+				mat_out.roughness = color.r;
+				mat_out.flags &= ~ObjectsPipeline::MAT_FLAG_HAS_ROUGHNESS_TEX;
+			}
+			if (constant_color(metalness, &color)) {
+				mat_out.metalness = color.r;
+				mat_out.flags &= ~ObjectsPipeline::MAT_FLAG_HAS_METALNESS_TEX;
+			}
+			if (constant_color(mat->normal_map, &color)) {
+				//(only the flat normal gets folded, and it's the same as no normal map)
+				mat_out.flags &= ~ObjectsPipeline::MAT_FLAG_HAS_NORMAL_TEX;
+			}
+		}
+
+		//normal maps baked to BC5 only store x and y, so the shader needs to rebuild z:
+		for (S72::Material const *mat : s72.tables.materials) {
+			if (mat->normal_map == nullptr) continue;
+			uint32_t id = texture_slots[mat->normal_map->index];
+			if (id < texture_rects.size() && textures[texture_rects[id].index].format == VK_FORMAT_BC5_UNORM_BLOCK) {
+				materials[mat->index].flags |= ObjectsPipeline::MAT_FLAG_NORMAL_TEX_XY;
 			}
 		}
 
@@ -867,7 +1095,7 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 					.subresourceRange{
 						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
 						.baseMipLevel = 0,
-						.levelCount = 1,
+						.levelCount = image.mipLevels,
 						.baseArrayLayer = 0,
 						.layerCount = 1,
 					},
@@ -881,22 +1109,30 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 		}
 
 		{ //make a sampler for the textures
+			//trilinear (+ anisotropic, if the device supports it) over the mip chains; nearest with --no-mipmaps:
+			bool mipmaps = rtg.configuration.mipmaps;
+			float anisotropy = 1.0f;
+			if (mipmaps && rtg.device_features.samplerAnisotropy) {
+				VkPhysicalDeviceProperties props;
+				vkGetPhysicalDeviceProperties(rtg.physical_device, &props);
+				anisotropy = std::min(rtg.configuration.max_anisotropy, props.limits.maxSamplerAnisotropy);
+			}
 			VkSamplerCreateInfo create_info {
 				.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
 				.flags = 0,
-				.magFilter = VK_FILTER_NEAREST,
-				.minFilter = VK_FILTER_NEAREST,
-				.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+				.magFilter = (mipmaps ? VK_FILTER_LINEAR : VK_FILTER_NEAREST),
+				.minFilter = (mipmaps ? VK_FILTER_LINEAR : VK_FILTER_NEAREST),
+				.mipmapMode = (mipmaps ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST),
 				.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
 				.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
 				.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
 				.mipLodBias = 0.0f,
-				.anisotropyEnable = VK_FALSE,
-				.maxAnisotropy = 0.0f,
+				.anisotropyEnable = (anisotropy > 1.0f ? VK_TRUE : VK_FALSE),
+				.maxAnisotropy = anisotropy,
 				.compareEnable = VK_FALSE,
 				.compareOp = VK_COMPARE_OP_ALWAYS,
 				.minLod = 0.0f,
-				.maxLod = 0.0f,
+				.maxLod = (mipmaps ? VK_LOD_CLAMP_NONE : 0.0f),
 				.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
 				.unnormalizedCoordinates = VK_FALSE,
 			};
@@ -906,6 +1142,249 @@ Tutorial::Tutorial(RTG &rtg_) : rtg(rtg_) {
 
 	}
 
+	{ //Material + TextureRects buffers (after textures, which can set material flags and pack atlases):
+		Material = rtg.helpers.create_buffer(
+			sizeof(ObjectsPipeline::Material) * materials.size(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			Helpers::Unmapped
+		);
+		rtg.helpers.upload_buffer(materials.data(), Material.size, Material);
+
+		TextureRects = rtg.helpers.create_buffer(
+			sizeof(ObjectsPipeline::TextureRect) * texture_rects.size(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			Helpers::Unmapped
+		);
+		rtg.helpers.upload_buffer(texture_rects.data(), TextureRects.size, TextureRects);
+
+		VkDescriptorSetAllocateInfo alloc_info {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = descriptor_pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &objects_pipeline.set3_Material,
+		};
+		VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &Material_descriptors));
+
+		VkDescriptorBufferInfo Material_info{
+			.buffer = Material.handle,
+			.offset = 0,
+			.range = Material.size,
+		};
+		VkDescriptorBufferInfo TextureRects_info{
+			.buffer = TextureRects.handle,
+			.offset = 0,
+			.range = TextureRects.size,
+		};
+		std::array<VkWriteDescriptorSet, 2> writes{
+			VkWriteDescriptorSet{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.dstSet = Material_descriptors,
+				.dstBinding = 0,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				.pBufferInfo = &Material_info,
+			},
+			VkWriteDescriptorSet{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.dstSet = Material_descriptors,
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				.pBufferInfo = &TextureRects_info,
+			},
+		};
+		vkUpdateDescriptorSets(rtg.device, uint32_t(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	{ //texture table (descriptor array of every texture view) for each workspace; render() keeps them up to date:
+		uint32_t count = uint32_t(texture_views.size());
+		if (count > objects_pipeline.max_textures) {
+			throw std::runtime_error("Scene has " + std::to_string(count) + " textures, but the texture table only holds " + std::to_string(objects_pipeline.max_textures) + ".");
+		}
+		uint32_t per_workspace = uint32_t(workspaces.size());
+
+		VkDescriptorPoolSize pool_size{
+			.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = count * per_workspace,
+		};
+		VkDescriptorPoolCreateInfo pool_info{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = 0,
+			.maxSets = per_workspace,
+			.poolSizeCount = 1,
+			.pPoolSizes = &pool_size,
+		};
+		VK(vkCreateDescriptorPool(rtg.device, &pool_info, nullptr, &texture_descriptor_pool));
+
+		for (Workspace &workspace : workspaces) {
+			VkDescriptorSetVariableDescriptorCountAllocateInfo count_info{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+				.descriptorSetCount = 1,
+				.pDescriptorCounts = &count,
+			};
+			VkDescriptorSetAllocateInfo alloc_info{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.pNext = &count_info,
+				.descriptorPool = texture_descriptor_pool,
+				.descriptorSetCount = 1,
+				.pSetLayouts = &objects_pipeline.set2_TEXTURE,
+			};
+			VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, &workspace.Textures_descriptors));
+			workspace.Textures_written.assign(count, VK_NULL_HANDLE); //(nothing written yet)
+		}
+	}
+
+	if (scene_cache) {
+		if (!scene_cache->loaded) {
+			try {
+				scene_cache->save(rtg.configuration.scene_cache, rtg.configuration.scene_file, s72);
+			} catch (std::exception &e) {
+				std::cerr << "Failed to write scene cache '" << rtg.configuration.scene_cache << "': " << e.what() << std::endl;
+			}
+		}
+		scene_cache.reset(); //everything has been uploaded; release the mapping / recorded payloads
+	}
+
+	if (image_pool) {
+		std::cout << "Decoded " << pending_images.size() << " images on " << image_pool->size() << " threads; waited "
+		          << image_wait_ms << " ms for decodes; uploaded " << baked_images_used << " baked images." << std::endl;
+		pending_images.clear();
+		image_pool.reset();
+	}
+
+	//submit the last batch of uploads (rendering is on the same queue, so it comes after them without waiting here):
+	rtg.helpers.flush_uploads();
+
+	rtg.helpers.print_memory_stats();
+}
+
+SceneCache::Image Tutorial::load_image(std::string const &path, bool flip_y) {
+	if (scene_cache) {
+		if (SceneCache::Image const *cached = scene_cache->find_image(path, flip_y)) return *cached;
+	}
+
+	SceneCache::Image image;
+	if (auto f = pending_images.find(image_key(path, flip_y)); f != pending_images.end()) {
+		{
+			Timer timer([&](double elapsed){ image_wait_ms += elapsed * 1000.0; });
+			f->second.done.get(); //(rethrows decode errors)
+		}
+		image = *f->second.image;
+	} else {
+		image = decode_image(path, flip_y);
+	}
+
+	//remembered so later requests (e.g., other workspaces) and the cache file can reuse the decode:
+	if (scene_cache) scene_cache->add_image(path, flip_y, image);
+	return image;
+}
+
+void Tutorial::prefetch_image(std::string const &path, bool flip_y) {
+	assert(image_pool);
+	if (scene_cache && scene_cache->find_image(path, flip_y)) return;
+	std::string key = image_key(path, flip_y);
+	if (pending_images.count(key)) return;
+
+	auto image = std::make_shared< SceneCache::Image >();
+	std::shared_future< void > done = image_pool->run([image, path, flip_y](){
+		*image = decode_image(path, flip_y);
+	}).share();
+	pending_images.emplace(key, PendingImage{ .image = image, .done = done });
+}
+
+Helpers::AllocatedImage Tutorial::load_rgbe_cube(std::string const &path) {
+	Helpers::AllocatedImage image;
+	if (load_baked(path, {VK_FORMAT_BC6H_UFLOAT_BLOCK}, 6, &image)) return image;
+
+	SceneCache::Image source = load_image(path, false);
+	if (source.height % 6 != 0 || source.height / 6 == 0) {
+		throw std::runtime_error("Cube texture " + path + " height not divisible by 6.");
+	}
+	uint32_t face_width = source.width;
+	uint32_t face_height = source.height / 6;
+	size_t face_texels = size_t(face_width) * face_height;
+
+	//RGBE -> shared-exponent E5B9G9R9 is an exact integer repack (4 bytes per texel, vs. 16 for RGBA32F):
+	// (vertical strip: faces are stacked in y, so texels are already in layer order)
+	std::vector< uint32_t > packed(face_texels * 6);
+	auto pack_face = [&](uint32_t face) {
+		uint8_t const *rgbe = source.texels + face * face_texels * 4;
+		uint32_t *out = packed.data() + face * face_texels;
+		for (size_t i = 0; i < face_texels; ++i) {
+			out[i] = rgbe_to_e5b9g9r9(glm::u8vec4(rgbe[4*i+0], rgbe[4*i+1], rgbe[4*i+2], rgbe[4*i+3]));
+		}
+	};
+	if (image_pool) image_pool->run_all(6, pack_face);
+	else for (uint32_t face = 0; face < 6; ++face) pack_face(face);
+
+	//(E5B9G9R9 sampling + linear filtering is required of every Vulkan implementation)
+	image = rtg.helpers.create_image(
+		VkExtent2D{.width = face_width, .height = face_height},
+		VK_FORMAT_E5B9G9R9_UFLOAT_PACK32,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		Helpers::Unmapped,
+		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+		6
+	);
+	rtg.helpers.upload_image(packed.data(), packed.size() * sizeof(packed[0]), image);
+	return image;
+}
+
+bool Tutorial::has_baked(std::string const &path) const {
+	return rtg.configuration.baked_textures && rtg.device_features.textureCompressionBC && KTX2::baked_is_current(path);
+}
+
+bool Tutorial::open_baked(std::string const &path, std::vector< VkFormat > const &formats, uint32_t faces, KTX2::File *file) {
+	assert(file);
+	if (!has_baked(path)) return false;
+	std::string baked_path = KTX2::baked_path(path);
+
+	try {
+		*file = KTX2::load(baked_path);
+	} catch (std::exception &e) {
+		std::cerr << "Ignoring baked image '" << baked_path << "': " << e.what() << std::endl;
+		return false;
+	}
+	if (std::find(formats.begin(), formats.end(), file->format) == formats.end() || file->faces != faces) {
+		std::cerr << "Ignoring baked image '" << baked_path << "': " << string_VkFormat(file->format) << " with " << file->faces
+		          << " face(s) doesn't match how '" << path << "' is used (re-run bake?)." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Tutorial::load_baked(std::string const &path, std::vector< VkFormat > const &formats, uint32_t faces, Helpers::AllocatedImage *image) {
+	assert(image);
+	KTX2::File file;
+	if (!open_baked(path, formats, faces, &file)) return false;
+
+	//--no-mipmaps uses just the top level:
+	uint32_t levels = (rtg.configuration.mipmaps ? uint32_t(file.levels.size()) : 1);
+	*image = rtg.helpers.create_image(
+		VkExtent2D{.width = file.width, .height = file.height},
+		file.format,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		Helpers::Unmapped,
+		(faces == 6 ? VkImageCreateFlags(VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT) : 0),
+		faces,
+		levels
+	);
+	std::vector< size_t > level_offsets;
+	for (uint32_t level = 0; level < levels; ++level) {
+		level_offsets.emplace_back(file.levels[level].offset);
+	}
+	rtg.helpers.upload_image_levels(file.mapped.data(), file.mapped.size(), level_offsets, *image);
+
+	baked_images_used += 1;
+	return true;
 }
 
 Tutorial::~Tutorial() {
@@ -919,13 +1398,12 @@ Tutorial::~Tutorial() {
 	if(texture_descriptor_pool) {
 		vkDestroyDescriptorPool(rtg.device, texture_descriptor_pool, nullptr);
 		texture_descriptor_pool = nullptr;
-
-		texture_descriptors.clear();
 	}
 	if(texture_sampler) {
 		vkDestroySampler(rtg.device, texture_sampler, nullptr);
 		texture_sampler = VK_NULL_HANDLE;
 	}
+	texture_streamer.reset(); //(destroys images it has replaced; current ones are destroyed below)
 	for(VkImageView &view : texture_views) {
 		vkDestroyImageView(rtg.device, view, nullptr);
 		view = VK_NULL_HANDLE;
@@ -937,8 +1415,9 @@ Tutorial::~Tutorial() {
 	textures.clear();
 
 	rtg.helpers.destroy_buffer(std::move(object_vertices));
+	rtg.helpers.destroy_buffer(std::move(object_indices));
 
-	if (swapchain_depth_image.handle != VK_NULL_HANDLE) {
+	if (!render_targets.targets.empty()) {
 		destroy_framebuffers();
 	}
 
@@ -949,55 +1428,37 @@ Tutorial::~Tutorial() {
 		workspace.command_buffer = VK_NULL_HANDLE;
 		}
 
-		if(workspace.lines_vertices_src.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.lines_vertices_src));
-		}
-		if(workspace.lines_vertices.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.lines_vertices));
-		}
-
-		if(workspace.Camera_src.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Camera_src));
+		if(workspace.Frame.handle != VK_NULL_HANDLE) {
+			rtg.helpers.destroy_buffer(std::move(workspace.Frame));
 		}
-		if(workspace.Camera.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Camera));
-		}
-		if(workspace.World_src.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.World_src));
-		}
-		if(workspace.World.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.World));
-		}
-		if(workspace.Transforms_src.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Transforms_src));
-		}
-		if(workspace.Transforms.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Transforms));
-		}
-		if(workspace.Material_src.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Material_src));
-		}
-		if(workspace.Material.handle != VK_NULL_HANDLE) {
-			rtg.helpers.destroy_buffer(std::move(workspace.Material));
-		}
-		if(workspace.env_sampler != VK_NULL_HANDLE) {
-			vkDestroySampler(rtg.device, workspace.env_sampler, nullptr);
-			workspace.env_sampler = VK_NULL_HANDLE;
-		}
-		if(workspace.Env != VK_NULL_HANDLE) {
-			vkDestroyImageView(rtg.device, workspace.Env, nullptr);
-			workspace.Env = VK_NULL_HANDLE;
-		}
-		rtg.helpers.destroy_image(std::move(workspace.Env_src));
-
-		if(workspace.Env_Lambertian != VK_NULL_HANDLE) {
-			vkDestroyImageView(rtg.device, workspace.Env_Lambertian, nullptr);
-			workspace.Env_Lambertian = VK_NULL_HANDLE;
-		}
-		rtg.helpers.destroy_image(std::move(workspace.Env_Lambertian_src));
 	}
 	workspaces.clear();
 
+	if(Material.handle != VK_NULL_HANDLE) {
+		rtg.helpers.destroy_buffer(std::move(Material));
+	}
+	if(TextureRects.handle != VK_NULL_HANDLE) {
+		rtg.helpers.destroy_buffer(std::move(TextureRects));
+	}
+	if(env_sampler != VK_NULL_HANDLE) {
+		vkDestroySampler(rtg.device, env_sampler, nullptr);
+		env_sampler = VK_NULL_HANDLE;
+	}
+	if(Env != VK_NULL_HANDLE) {
+		vkDestroyImageView(rtg.device, Env, nullptr);
+		Env = VK_NULL_HANDLE;
+	}
+	if(Env_src.handle != VK_NULL_HANDLE) {
+		rtg.helpers.destroy_image(std::move(Env_src));
+	}
+	if(Env_Lambertian != VK_NULL_HANDLE) {
+		vkDestroyImageView(rtg.device, Env_Lambertian, nullptr);
+		Env_Lambertian = VK_NULL_HANDLE;
+	}
+	if(Env_Lambertian_src.handle != VK_NULL_HANDLE) {
+		rtg.helpers.destroy_image(std::move(Env_Lambertian_src));
+	}
+
 	background_pipeline.destroy(rtg);
 	lines_pipeline.destroy(rtg);
 	objects_pipeline.destroy(rtg);
@@ -1048,22 +1509,28 @@ void Tutorial::on_swapchain(RTG &rtg_, RTG::SwapchainEvent const &swapchain) {
 	//[re]create framebuffers:
 	//refsol::Tutorial_on_swapchain(rtg, swapchain, depth_format, render_pass, &swapchain_depth_image, &swapchain_depth_image_view, &swapchain_framebuffers);
 	//Clean up existing framebuffers
-	if(swapchain_depth_image.handle != VK_NULL_HANDLE) {
+	if(!render_targets.targets.empty()) {
 		destroy_framebuffers();
 	}
-	//allocate depth image for framebuffers to share
-	swapchain_depth_image = rtg.helpers.create_image(
-		swapchain.extent,
-		depth_format,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		Helpers::Unmapped
-	);
+	//allocate transient attachments (with lifetimes in passes; ones that don't overlap share memory):
+	// (the depth image is shared by all framebuffers, and only used by the main pass)
+	render_targets = rtg.helpers.create_render_target_pool({
+		Helpers::RenderTarget{ //depth
+			.extent = swapchain.extent,
+			.format = depth_format,
+			.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+			.first_pass = MainPass,
+			.last_pass = MainPass,
+		},
+	});
+	if (rtg.configuration.debug) {
+		std::cout << "Transient render targets: " << render_targets.targets.size() << " images in " << (render_targets.peak_bytes >> 10)
+		          << " kB (" << (render_targets.unaliased_bytes >> 10) << " kB without aliasing)." << std::endl;
+	}
 	{//create an image view of the depth images
 		VkImageViewCreateInfo create_info {
 			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-			.image = swapchain_depth_image.handle,
+			.image = render_targets.targets[DepthTarget].handle,
 			.viewType = VK_IMAGE_VIEW_TYPE_2D,
 			.format = depth_format,
 			.subresourceRange{
@@ -1108,10 +1575,60 @@ void Tutorial::destroy_framebuffers() {
 	assert(swapchain_depth_image_view != VK_NULL_HANDLE);
 	vkDestroyImageView(rtg.device, swapchain_depth_image_view, nullptr);
 	swapchain_depth_image_view = VK_NULL_HANDLE;
-	rtg.helpers.destroy_image(std::move(swapchain_depth_image));
+	rtg.helpers.destroy_render_target_pool(std::move(render_targets));
 }
 
 
+void Tutorial::write_frame_descriptors(Workspace &workspace) {
+	//(ranges are fixed; render() picks where in the buffer each frame's data is with dynamic offsets)
+	VkDescriptorBufferInfo Camera_info{
+		.buffer = workspace.Frame.handle,
+		.offset = 0,
+		.range = sizeof(LinesPipeline::Camera),
+	};
+	VkDescriptorBufferInfo World_info{
+		.buffer = workspace.Frame.handle,
+		.offset = 0,
+		.range = sizeof(ObjectsPipeline::World),
+	};
+	VkDescriptorBufferInfo Transforms_info{
+		.buffer = workspace.Frame.handle,
+		.offset = 0,
+		.range = workspace.Transforms_range,
+	};
+
+	std::array<VkWriteDescriptorSet, 3> writes{
+		VkWriteDescriptorSet{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = workspace.Camera_descriptors,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.pBufferInfo = &Camera_info,
+		},
+		VkWriteDescriptorSet{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = workspace.World_descriptors,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.pBufferInfo = &World_info,
+		},
+		VkWriteDescriptorSet{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = workspace.Transforms_descriptors,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+			.pBufferInfo = &Transforms_info,
+		},
+	};
+	vkUpdateDescriptorSets(rtg.device, uint32_t(writes.size()), writes.data(), 0, nullptr);
+}
+
 void Tutorial::render(RTG &rtg_, RTG::RenderParams const &render_params) {
 	//assert that parameters are valid:
 	assert(&rtg == &rtg_);
@@ -1156,193 +1673,68 @@ void Tutorial::render(RTG &rtg_, RTG::RenderParams const &render_params) {
 		query_to_frame[workspace.query_index] = this_frame;
 	}
 
-	if (!lines_vertices.empty()) {
-		size_t needed_bytes = lines_vertices.size() * sizeof(lines_vertices[0]);
-		if(workspace.lines_vertices_src.handle == VK_NULL_HANDLE || workspace.lines_vertices_src.size < needed_bytes) {
-			size_t new_bytes = ((needed_bytes + 4096) / 4096) * 4096;
-			if(workspace.lines_vertices_src.handle) {
-				rtg.helpers.destroy_buffer(std::move(workspace.lines_vertices_src));
-			}
-
-			if(workspace.lines_vertices.handle) {
-				rtg.helpers.destroy_buffer(std::move(workspace.lines_vertices));
-			}
-
-			workspace.lines_vertices_src = rtg.helpers.create_buffer(
-				new_bytes,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				Helpers::Mapped
-			);
-
-			workspace.lines_vertices = rtg.helpers.create_buffer(
+	//per-frame data goes into this workspace's Frame buffer, which the GPU reads in place:
+	// (render() runs once the workspace's fence has signaled, so everything last written there is done with)
+	VkDeviceSize lines_offset = 0, Camera_offset = 0, World_offset = 0, Transforms_offset = 0;
+	{
+		auto aligned = [&](VkDeviceSize size) { return (size + frame_alignment - 1) / frame_alignment * frame_alignment; };
+
+		//grow the buffer (and the Transforms range) if this frame won't fit:
+		VkDeviceSize transforms_bytes = object_instances.size() * sizeof(ObjectsPipeline::Transform);
+		bool grow = false;
+		if (workspace.Transforms_range < transforms_bytes) {
+			workspace.Transforms_range = aligned(transforms_bytes + transforms_bytes / 2);
+			grow = true;
+		}
+		VkDeviceSize needed = aligned(lines_vertices.size() * sizeof(lines_vertices[0]))
+			+ aligned(sizeof(LinesPipeline::Camera))
+			+ aligned(sizeof(world))
+			+ aligned(workspace.Transforms_range);
+		if (workspace.Frame.size < needed) grow = true;
+		if (grow) {
+			VkDeviceSize new_bytes = std::max(workspace.Frame.size, (needed + needed / 2 + 4095) / 4096 * 4096);
+			rtg.helpers.destroy_buffer(std::move(workspace.Frame));
+			workspace.Frame = rtg.helpers.create_dynamic_buffer(
 				new_bytes,
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				Helpers::Unmapped
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
 			);
-
-			std::cout << "Re-allocated lines buffer to " << new_bytes << " bytes." << std::endl;
+			write_frame_descriptors(workspace);
+			std::cout << "Re-allocated per-frame buffer to " << new_bytes << " bytes." << std::endl;
 		}
 
-		assert(workspace.lines_vertices_src.size == workspace.lines_vertices.size);
-		assert(workspace.lines_vertices_src.size >= needed_bytes);
-
-		assert(workspace.lines_vertices_src.allocation.mapped);
-		std::memcpy(workspace.lines_vertices_src.allocation.data(), lines_vertices.data(), needed_bytes);
-
-		VkBufferCopy copy_region {
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = needed_bytes,
+		//bump-allocate this frame's data:
+		workspace.Frame_used = 0;
+		auto allocate = [&](VkDeviceSize size) -> VkDeviceSize {
+			VkDeviceSize offset = workspace.Frame_used;
+			workspace.Frame_used += aligned(size);
+			assert(workspace.Frame_used <= workspace.Frame.size);
+			return offset;
 		};
-		vkCmdCopyBuffer(workspace.command_buffer, workspace.lines_vertices_src.handle, workspace.lines_vertices.handle, 1, &copy_region);
-	}
+		char *frame_data = reinterpret_cast< char * >(workspace.Frame.allocation.data());
+
+		if (!lines_vertices.empty()) {
+			size_t bytes = lines_vertices.size() * sizeof(lines_vertices[0]);
+			lines_offset = allocate(bytes);
+			std::memcpy(frame_data + lines_offset, lines_vertices.data(), bytes);
+		}
 
-	{ // camera info
 		LinesPipeline::Camera camera{
 			.CLIP_FROM_WORLD = CLIP_FROM_WORLD,
 		};
-		assert(workspace.Camera_src.size == sizeof(camera));
+		Camera_offset = allocate(sizeof(camera));
+		std::memcpy(frame_data + Camera_offset, &camera, sizeof(camera));
 
-		memcpy(workspace.Camera_src.allocation.data(), &camera, sizeof(camera));
+		World_offset = allocate(sizeof(world));
+		std::memcpy(frame_data + World_offset, &world, sizeof(world));
 
-		assert(workspace.Camera_src.size == workspace.Camera.size);
-		VkBufferCopy copy_region {
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = workspace.Camera_src.size,
-		};
-		vkCmdCopyBuffer(workspace.command_buffer, workspace.Camera_src.handle, workspace.Camera.handle, 1, &copy_region);
-	}
-
-	{ //upload world info:
-		assert(workspace.World_src.size == sizeof(world)); //TODO:Check werid
-
-		//host-side copy into World_src:
-		memcpy(workspace.World_src.allocation.data(), &world, sizeof(world));
-
-		//add device-side copy from World_src -> World:
-		assert(workspace.World_src.size == workspace.World.size);
-		VkBufferCopy copy_region{
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = workspace.World_src.size,
-		};
-		vkCmdCopyBuffer(workspace.command_buffer, workspace.World_src.handle, workspace.World.handle, 1, &copy_region);
-	}
-
-	{//update material info
-		assert(workspace.Material_src.size == materials.size() * sizeof(ObjectsPipeline::Material)); //TODO:Check werid
-
-		//host-side copy into Material_src:
-		// memcpy(workspace.Material_src.allocation.data(), &materials, sizeof(workspace.Material));
-		ObjectsPipeline::Material *out = reinterpret_cast<ObjectsPipeline::Material*>(workspace.Material_src.allocation.data());
-		for(ObjectsPipeline::Material const &inst : materials) {
-			*out = inst;
+		//(always the whole range, which the Transforms descriptor covers)
+		Transforms_offset = allocate(workspace.Transforms_range);
+		ObjectsPipeline::Transform *out = reinterpret_cast< ObjectsPipeline::Transform * >(frame_data + Transforms_offset);
+		for (ObjectInstance const &inst : object_instances) {
+			*out = inst.transform;
 			++out;
 		}
-
-		//add device-side copy from Material_src -> Material:
-		assert(workspace.Material_src.size == workspace.Material.size);
-		VkBufferCopy copy_region{
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = workspace.Material_src.size,
-		};
-		vkCmdCopyBuffer(workspace.command_buffer, workspace.Material_src.handle, workspace.Material.handle, 1, &copy_region);
-	}
-
-	if (!object_instances.empty()) {
-		size_t needed_bytes = object_instances.size() * sizeof(ObjectsPipeline::Transform);
-		if(workspace.Transforms_src.handle == VK_NULL_HANDLE || workspace.Transforms_src.size < needed_bytes) {
-			size_t new_bytes = ((needed_bytes + 4096) / 4096) * 4096;
-			if(workspace.Transforms_src.handle) {
-				rtg.helpers.destroy_buffer(std::move(workspace.Transforms_src));
-			}
-
-			if(workspace.Transforms.handle) {
-				rtg.helpers.destroy_buffer(std::move(workspace.Transforms));
-			}
-
-			workspace.Transforms_src = rtg.helpers.create_buffer(
-				new_bytes,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				Helpers::Mapped
-			);
-
-			workspace.Transforms = rtg.helpers.create_buffer(
-				new_bytes,
-				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				Helpers::Unmapped
-			);
-
-			VkDescriptorBufferInfo Transforms_info{
-				.buffer = workspace.Transforms.handle,
-				.offset = 0,
-				.range = workspace.Transforms.size,
-			};
-
-			std::array<VkWriteDescriptorSet, 1> writes{
-				VkWriteDescriptorSet{
-					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-					.dstSet = workspace.Transforms_descriptors,
-					.dstBinding = 0,
-					.dstArrayElement = 0,
-					.descriptorCount = 1,
-					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-					.pBufferInfo = &Transforms_info,
-				},
-			};
-
-			vkUpdateDescriptorSets(
-				rtg.device,
-				uint32_t(writes.size()),
-				writes.data(),
-				0, //descriptor copy count
-				nullptr
-			);
-
-			std::cout << "Re-allocated object transforms buffer to " << new_bytes << " bytes." << std::endl;
-		}
-
-		assert(workspace.Transforms_src.size == workspace.Transforms.size);
-		assert(workspace.Transforms_src.size >= needed_bytes);
-
-		{
-			assert(workspace.Transforms_src.allocation.mapped);
-			ObjectsPipeline::Transform *out = reinterpret_cast<ObjectsPipeline::Transform*>(workspace.Transforms_src.allocation.data());
-			for(ObjectInstance const &inst : object_instances) {
-				*out = inst.transform;
-				++out;
-			}
-		}
-
-		VkBufferCopy copy_region {
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = needed_bytes,
-		};
-		vkCmdCopyBuffer(workspace.command_buffer, workspace.Transforms_src.handle, workspace.Transforms.handle, 1, &copy_region);
-	}
-
-	{//memory barrier
-		VkMemoryBarrier memory_barrier {
-			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-			.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
-			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-		};
-
-		vkCmdPipelineBarrier(workspace.command_buffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-			0, //dependency flags
-			1, &memory_barrier, //memorybarries
-			0, nullptr, //buffer memory b
-			0, nullptr //image mem b
-		);
+		//(host-coherent writes are visible to the GPU once the command buffer is submitted, so no barrier is needed)
 	}
 
 	//GPU Commands
@@ -1405,21 +1797,24 @@ void Tutorial::render(RTG &rtg_, RTG::RenderParams const &render_params) {
 		if(!lines_vertices.empty()){//draw with the lines pipeline:
 			vkCmdBindPipeline(workspace.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lines_pipeline.handle);
 			{
-				std::array<VkBuffer, 1> vertex_buffers {workspace.lines_vertices.handle};
-				std::array<VkDeviceSize, 1> offsets{0};
+				std::array<VkBuffer, 1> vertex_buffers {workspace.Frame.handle};
+				std::array<VkDeviceSize, 1> offsets{lines_offset};
 				vkCmdBindVertexBuffers(workspace.command_buffer, 0, uint32_t(vertex_buffers.size()), vertex_buffers.data(), offsets.data());
 			}
 			{
 				std::array<VkDescriptorSet, 1> descriptor_sets{
 					workspace.Camera_descriptors,
 				};
+				std::array<uint32_t, 1> dynamic_offsets{
+					uint32_t(Camera_offset),
+				};
 				vkCmdBindDescriptorSets(
 					workspace.command_buffer,
 					VK_PIPELINE_BIND_POINT_GRAPHICS,
 					lines_pipeline.layout,
 					0, //first set
 					uint32_t(descriptor_sets.size()), descriptor_sets.data(),
-					0, nullptr //dynamic offsets count, ptr
+					uint32_t(dynamic_offsets.size()), dynamic_offsets.data() //dynamic offsets count, ptr
 				);
 			}
 			vkCmdDraw(workspace.command_buffer, uint32_t(lines_vertices.size()), 1, 0, 0); // vertex count, instance count, first vertex, first instance.
@@ -1433,12 +1828,47 @@ void Tutorial::render(RTG &rtg_, RTG::RenderParams const &render_params) {
 					std::array<VkDeviceSize, 1> offsets{0};
 					vkCmdBindVertexBuffers(workspace.command_buffer, 0, uint32_t(vertex_buffers.size()), vertex_buffers.data(), offsets.data());
 				}
+				if (object_indices.handle != VK_NULL_HANDLE) { // indexbuffer
+					vkCmdBindIndexBuffer(workspace.command_buffer, object_indices.handle, 0, VK_INDEX_TYPE_UINT32);
+				}
+				{//bring this workspace's texture table up to date (only views that changed, e.g. by streaming, get written):
+					std::vector< VkDescriptorImageInfo > infos;
+					std::vector< VkWriteDescriptorSet > writes;
+					infos.reserve(texture_views.size()); //(writes point into infos)
+					for (uint32_t i = 0; i < texture_views.size(); ++i) {
+						if (workspace.Textures_written[i] == texture_views[i]) continue;
+						infos.emplace_back(VkDescriptorImageInfo{
+							.sampler = texture_sampler,
+							.imageView = texture_views[i],
+							.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						});
+						writes.emplace_back(VkWriteDescriptorSet{
+							.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+							.dstSet = workspace.Textures_descriptors,
+							.dstBinding = 0,
+							.dstArrayElement = i,
+							.descriptorCount = 1,
+							.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+							.pImageInfo = &infos.back(),
+						});
+						workspace.Textures_written[i] = texture_views[i];
+					}
+					if (!writes.empty()) {
+						vkUpdateDescriptorSets(rtg.device, uint32_t(writes.size()), writes.data(), 0, nullptr);
+					}
+				}
 				//Camera descriptor set is still bond but unused
-				{//bind transform descriptor
-					std::array<VkDescriptorSet, 3> descriptor_sets{
+				{//bind world, transforms, materials, and texture table once for all draws:
+					std::array<VkDescriptorSet, 4> descriptor_sets{
 						workspace.World_descriptors,
 						workspace.Transforms_descriptors,
-						workspace.Material_descriptors,
+						Material_descriptors,
+						workspace.Textures_descriptors,
+					};
+					//(in set order: World, then Transforms)
+					std::array<uint32_t, 2> dynamic_offsets{
+						uint32_t(World_offset),
+						uint32_t(Transforms_offset),
 					};
 					vkCmdBindDescriptorSets(
 						workspace.command_buffer,
@@ -1446,99 +1876,17 @@ void Tutorial::render(RTG &rtg_, RTG::RenderParams const &render_params) {
 						objects_pipeline.layout,
 						0, //first set
 						uint32_t(descriptor_sets.size()), descriptor_sets.data(),
-						0, nullptr //dynamic offsets count, ptr
+						uint32_t(dynamic_offsets.size()), dynamic_offsets.data() //dynamic offsets count, ptr
 					);
 				}
 
-				// Ensure texture descriptors exist and are up to date for visible instances
-				uint32_t set_count = static_cast<uint32_t>(object_instances.size());
-				bool need_recreate = texture_descriptor_pool == VK_NULL_HANDLE || texture_descriptors.size() < set_count;
-				if (need_recreate) {
-					if (texture_descriptor_pool != VK_NULL_HANDLE) {
-						vkDestroyDescriptorPool(rtg.device, texture_descriptor_pool, nullptr);
-						texture_descriptor_pool = VK_NULL_HANDLE;
-					}
-
-					VkDescriptorPoolSize pool_size{
-						.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-						.descriptorCount = set_count * 5u,
-					};
-					VkDescriptorPoolCreateInfo pool_info{
-						.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-						.pNext = nullptr,
-						.flags = 0,
-						.maxSets = set_count,
-						.poolSizeCount = 1,
-						.pPoolSizes = &pool_size,
-					};
-					VK(vkCreateDescriptorPool(rtg.device, &pool_info, nullptr, &texture_descriptor_pool));
-
-					std::vector<VkDescriptorSetLayout> layouts(set_count, objects_pipeline.set2_TEXTURE);
-					VkDescriptorSetAllocateInfo alloc_info{
-						.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-						.pNext = nullptr,
-						.descriptorPool = texture_descriptor_pool,
-						.descriptorSetCount = set_count,
-						.pSetLayouts = layouts.data(),
-					};
-					texture_descriptors.resize(set_count, VK_NULL_HANDLE);
-					VK(vkAllocateDescriptorSets(rtg.device, &alloc_info, texture_descriptors.data()));
-				} else {
-					texture_descriptors.resize(set_count);
-				}
-
-				for (size_t i = 0; i < object_instances.size(); ++i) {
-					ObjectInstance &inst = object_instances[i];
-					VkDescriptorSet descriptor_set = texture_descriptors[i];
-					inst.texture_set = descriptor_set;
-
-					std::array<VkWriteDescriptorSet, 5> writes{};
-					std::array<VkDescriptorImageInfo, 5> infos{};
-					uint32_t write_count = 0;
-
-					auto add_write = [&](uint32_t binding, uint32_t tex_index) {
-						if (tex_index == std::numeric_limits<uint32_t>::max()) return;
-						if (tex_index >= texture_views.size()) return;
-						infos[binding] = VkDescriptorImageInfo{
-							.sampler = texture_sampler,
-							.imageView = texture_views[tex_index],
-							.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-						};
-						writes[write_count++] = VkWriteDescriptorSet{
-							.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-							.dstSet = descriptor_set,
-							.dstBinding = binding,
-							.dstArrayElement = 0,
-							.descriptorCount = 1,
-							.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-							.pImageInfo = &infos[binding],
-						};
-					};
-
-					add_write(0, inst.albedo_tex);
-					add_write(1, inst.normal_tex);
-					add_write(2, inst.displacement_tex);
-					add_write(3, inst.roughness_tex);
-					add_write(4, inst.metalness_tex);
-
-					if (write_count > 0) {
-						vkUpdateDescriptorSets(rtg.device, write_count, writes.data(), 0, nullptr);
-					}
-				}
-
 				for (ObjectInstance const &inst : object_instances) {
 					uint32_t index = uint32_t(&inst - &object_instances[0]);
-					if (inst.texture_set != VK_NULL_HANDLE) {
-						vkCmdBindDescriptorSets(
-							workspace.command_buffer,
-							VK_PIPELINE_BIND_POINT_GRAPHICS,
-							objects_pipeline.layout,
-							3, // texture set
-							1, &inst.texture_set,
-							0, nullptr //dynamic offsets count, ptr
-						);
+					if (inst.vertices.index_count != 0) {
+						vkCmdDrawIndexed(workspace.command_buffer, inst.vertices.index_count, 1, inst.vertices.first_index, int32_t(inst.vertices.first), index); // index count, instance count, first index, vertex offset, first instance.
+					} else {
+						vkCmdDraw(workspace.command_buffer, inst.vertices.count, 1, inst.vertices.first, index); // vertex count, instance count, first vertex, first instance.
 					}
-					vkCmdDraw(workspace.command_buffer, inst.vertices.count, 1, inst.vertices.first, index); // vertex count, instance count, first vertex, first instance.
 				}
 			}
 		}
@@ -1975,6 +2323,17 @@ void Tutorial::update(float dt) {
 			object_instances.swap(filtered);
 		}
 	}
+
+	if (texture_streamer) {
+		//report how large each visible instance's textures are on screen, then stream in / evict:
+		for (ObjectInstance const &inst : object_instances) {
+			float pixels = screen_size(CLIP_FROM_WORLD, inst);
+			for (uint32_t tex : {inst.albedo_tex, inst.normal_tex, inst.displacement_tex, inst.roughness_tex, inst.metalness_tex}) {
+				if (tex != std::numeric_limits<uint32_t>::max()) texture_streamer->use(texture_rects[tex].index, pixels);
+			}
+		}
+		texture_streamer->update();
+	}
 }
 
 
@@ -2014,12 +2373,8 @@ void Tutorial::on_input(InputEvent const &evt) {
 
 	if (evt.type == InputEvent::KeyDown && evt.key.key == GLFW_KEY_RIGHT) {
 		//cycle scene camera 
-		auto it = s72.cameras.find(cur_scene_camera->name);
-		assert(it != s72.cameras.end());
-		++it;
-		if (it == s72.cameras.end())
-			it = s72.cameras.begin();
-		cur_scene_camera = &it->second;
+		assert(cur_scene_camera);
+		cur_scene_camera = s72.tables.cameras[(cur_scene_camera->index + 1) % s72.tables.cameras.size()];
 		//std::cout << "Current Scene Camera Updated: " <<  << std::endl;
 		return;
 	}
@@ -2263,18 +2618,16 @@ void Tutorial::traverse_children(S72 &_s72, S72::Node* node, size_t &id, mat4 lo
 	//Print node information
 	if(node->camera != nullptr){
 		// std::cout << "Camera: " << node->camera->name;
-		s72.cameras[node->camera->name].transform = local_trans;
+		node->camera->transform = local_trans;
 	}
 	if(node->mesh != nullptr){
 		//std::cout << "Mesh: " << node->mesh->name;
 		//make objectvertices
-		auto it = object_vertices_list.find(node->mesh->name);
-		if (it == object_vertices_list.end()) throw std::runtime_error("Failed to find the mesh in object vertices list");
+		ObjectVertices const &obj_vertices = object_vertices_list[node->mesh->index];
 		uint32_t matId = 0;
 		auto tex_lookup = [&](S72::Texture* tex) -> uint32_t {
 			if (!tex) return std::numeric_limits<uint32_t>::max();
-			auto tex_it = texture_ptr_to_index.find(tex);
-			return (tex_it != texture_ptr_to_index.end()) ? tex_it->second : std::numeric_limits<uint32_t>::max();
+			return texture_slots[tex->index];
 		};
 
 		uint32_t texAlbedo = std::numeric_limits<uint32_t>::max();
@@ -2284,12 +2637,7 @@ void Tutorial::traverse_children(S72 &_s72, S72::Node* node, size_t &id, mat4 lo
 		uint32_t texMetalness = std::numeric_limits<uint32_t>::max();
 
 		if(node->mesh->material != nullptr){
-			auto mat_it = material_ptr_to_index.find(node->mesh->material);
-			if (mat_it != material_ptr_to_index.end()) {
-				matId = mat_it->second;
-			} else {
-				throw std::runtime_error("Failed to find the material in material list");
-    		}
+			matId = node->mesh->material->index;
 
 			//todo given material handle different brdf and find texture id:
 			if (auto* p = std::get_if<S72::Material::PBR>(&node->mesh->material->brdf)) {
@@ -2312,8 +2660,9 @@ void Tutorial::traverse_children(S72 &_s72, S72::Node* node, size_t &id, mat4 lo
 			texDisplacement = tex_lookup(node->mesh->material->displacement_map);
 		}
 		ObjectInstance obj = ObjectInstance{
-			.vertices = it->second,
-			.transform = makeInstanceData(local_trans, matId),
+			.vertices = obj_vertices,
+			.transform = makeInstanceData(local_trans, matId, obj_vertices),
+			.world_from_local = local_trans,
 			.albedo_tex = texAlbedo,
 			.normal_tex = texNormal,
 			.displacement_tex = texDisplacement,
@@ -2326,7 +2675,7 @@ void Tutorial::traverse_children(S72 &_s72, S72::Node* node, size_t &id, mat4 lo
 		
 		//draw bouding box
 		if (camera_mode == CameraMode::Debug) {
-			auto corners = get_aabb_corners(it->second.min_aabb_bound, it->second.max_aabb_bound);
+			auto corners = get_aabb_corners(obj_vertices.min_aabb_bound, obj_vertices.max_aabb_bound);
 			std::vector<PosColVertex> debug_vertices;
 			for (vec3 &corner : corners) {
 				vec4 transformed_corner = local_trans * vec4(corner, 1.0f);
@@ -2391,10 +2740,17 @@ void Tutorial::fill_scene_graph(S72 &_s72, std::vector<ObjectInstance> &objects)
 	// }
 }
 
-Tutorial::ObjectsPipeline::Transform Tutorial::makeInstanceData(mat4 world_from_local, uint32_t material_index) {
+Tutorial::ObjectsPipeline::Transform Tutorial::makeInstanceData(mat4 world_from_local, uint32_t material_index, ObjectVertices const &vertices) {
+	mat4 world_from_vertex = world_from_local;
+	if (packed_vertices) {
+		//packed positions are [0,1] within the mesh's AABB:
+		world_from_vertex = world_from_local
+			* glm::translate(glm::mat4(1.0f), vertices.min_aabb_bound)
+			* glm::scale(glm::mat4(1.0f), glm::max(vertices.max_aabb_bound - vertices.min_aabb_bound, vec3(0.0f)));
+	}
 	return ObjectsPipeline::Transform {
-		.CLIP_FROM_LOCAL = CLIP_FROM_WORLD * world_from_local,
-		.WORLD_FROM_LOCAL = world_from_local,
+		.CLIP_FROM_LOCAL = CLIP_FROM_WORLD * world_from_vertex,
+		.WORLD_FROM_LOCAL = world_from_vertex,
 		.WORLD_FROM_LOCAL_NORMAL = world_from_local, //since our matrices are orthonormal, the inverse transpose is simply the matrix itself.
 		.MATERIAL_INDEX = material_index,
 	};
@@ -2473,7 +2829,7 @@ bool Tutorial::aabb_intersects_frustum_SAT(const mat4& clip, const ObjectInstanc
 	assert(axes.size() <= 5 && "Expected at most 5 unique frustum normals");
         
     // --- 2. Box face normals (in world space) ---
-	const mat4& world_from_local = instance.transform.WORLD_FROM_LOCAL;
+	const mat4& world_from_local = instance.world_from_local;
 
     // Transform local axes to world
     vec3 boxAxesWorld[3] = {
@@ -2528,5 +2884,20 @@ bool Tutorial::aabb_intersects_frustum_SAT(const mat4& clip, const ObjectInstanc
     return true; // no separating axis -> intersection
 }
 
-
-
+float Tutorial::screen_size(const mat4& clip, const ObjectInstance& instance) {
+	float full = float(std::max(rtg.swapchain_extent.width, rtg.swapchain_extent.height));
+	float min_x = std::numeric_limits<float>::max(), min_y = std::numeric_limits<float>::max();
+	float max_x = std::numeric_limits<float>::lowest(), max_y = std::numeric_limits<float>::lowest();
+	for (vec3 const &corner : get_aabb_corners(instance.vertices.min_aabb_bound, instance.vertices.max_aabb_bound)) {
+		vec4 p = clip * (instance.world_from_local * vec4(corner, 1.0f));
+		if (p.w <= 1e-6f) return full; //(box reaches behind the eye, so it is close enough to want full detail)
+		min_x = std::min(min_x, p.x / p.w);
+		min_y = std::min(min_y, p.y / p.w);
+		max_x = std::max(max_x, p.x / p.w);
+		max_y = std::max(max_y, p.y / p.w);
+	}
+	//NDC spans 2 units across the swapchain:
+	float w = 0.5f * (max_x - min_x) * rtg.swapchain_extent.width;
+	float h = 0.5f * (max_y - min_y) * rtg.swapchain_extent.height;
+	return std::min(std::max(w, h), full);
+}
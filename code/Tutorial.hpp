@@ -2,8 +2,16 @@
 
 #include "PosColVertex.hpp"
 #include "PosNorTanTexVertex.hpp"
+#include "PosNorTanTexPackedVertex.hpp"
 #include "mat4.hpp"
 #include "RTG.hpp"
+#include "SceneCache.hpp"
+#include "TextureStreamer.hpp"
+#include "ThreadPool.hpp"
+
+#include <future>
+#include <memory>
+#include <unordered_map>
 
 struct Tutorial : RTG::Application {
 
@@ -69,7 +77,7 @@ struct Tutorial : RTG::Application {
 		// descriptor set layouts
 		VkDescriptorSetLayout set0_World = VK_NULL_HANDLE;
 		VkDescriptorSetLayout set1_Transforms = VK_NULL_HANDLE;
-		VkDescriptorSetLayout set2_TEXTURE = VK_NULL_HANDLE;
+		VkDescriptorSetLayout set2_TEXTURE = VK_NULL_HANDLE; //runtime-sized array of every material texture
 		VkDescriptorSetLayout set3_Material = VK_NULL_HANDLE;
 
 		//types for descriptors
@@ -101,30 +109,54 @@ struct Tutorial : RTG::Application {
 		// Material flags packing in bits:
 		// bits 0-1: BRDF type
 		// bits 2-6: hasAlbedoTex, hasNormalTex, hasRoughnessTex, hasMetalnessTex, hasDisplacementTex
+		// bit 7: normal texture is two-channel
 		static constexpr uint32_t MAT_FLAG_BRDF_MASK              = 0x00000003u;
 		static constexpr uint32_t MAT_FLAG_HAS_ALBEDO_TEX         = 0x00000004u;
 		static constexpr uint32_t MAT_FLAG_HAS_NORMAL_TEX         = 0x00000008u;
 		static constexpr uint32_t MAT_FLAG_HAS_ROUGHNESS_TEX      = 0x00000010u;
 		static constexpr uint32_t MAT_FLAG_HAS_METALNESS_TEX      = 0x00000020u;
 		static constexpr uint32_t MAT_FLAG_HAS_DISPLACEMENT_TEX   = 0x00000040u;
+		static constexpr uint32_t MAT_FLAG_NORMAL_TEX_XY          = 0x00000080u; //normal texture only stores x, y (BC5); z is rebuilt
 
 		struct Material {
 			// Slot 0 (16 bytes)
 			vec4 albedo;                    // RGBA color or placeholder
 			
 			// Slot 1 (16 bytes) - packed scalars
-			uint32_t flags;                 // brdf type (bits 0-1) + texture presence flags (bits 2-6)
+			uint32_t flags;                 // brdf type (bits 0-1) + texture flags (bits 2-7)
 			float roughness;                // default roughness when not textured (PBR)
 			float metalness;                // default metalness when not textured (PBR)
-			uint32_t padding_scalar;        // padding to align to 16 bytes
+			uint32_t displacement_tex;      // texture id (when MAT_FLAG_HAS_DISPLACEMENT_TEX)
+
+			// Slot 2 (16 bytes) - texture ids (each used only when its MAT_FLAG_HAS_*_TEX bit is set)
+			uint32_t albedo_tex;
+			uint32_t normal_tex;
+			uint32_t roughness_tex;
+			uint32_t metalness_tex;
+		};
+		static_assert(sizeof(Material) == 48, "Material should be 48 bytes (3 x 16-byte slots)");
+
+		//where a texture id's texels are: TEXTURES[index], at offset + fract(uv) * scale
+		// (scale 1, offset 0 for textures with their own image; a sub-rectangle for textures packed into an atlas page)
+		struct TextureRect {
+			struct { float x, y; } scale;
+			struct { float x, y; } offset;
+			uint32_t index;
+			uint32_t padding_[3];
 		};
-		static_assert(sizeof(Material) == 32, "Material should be 32 bytes (2 x 16-byte slots)");
+		static_assert(sizeof(TextureRect) == 32, "TextureRect is laid out as expected.");
+
+		//size of the texture table is limited by the device (see create()) and by this:
+		static constexpr uint32_t MaxTextures = 4096;
+		uint32_t max_textures = 0;
+
 		//no push constants
 
 		//layout
 		VkPipelineLayout layout = VK_NULL_HANDLE;
 
 		using Vertex = PosNorTanTexVertex;
+		using PackedVertex = PosNorTanTexPackedVertex; //used with `--vertex-format packed`
 
 		VkPipeline handle = VK_NULL_HANDLE;
 
@@ -140,37 +172,28 @@ struct Tutorial : RTG::Application {
 	struct Workspace {
 		VkCommandBuffer command_buffer = VK_NULL_HANDLE; //from the command pool above; reset at the start of every render.
 
-		Helpers::AllocatedBuffer lines_vertices_src;
-		Helpers::AllocatedBuffer lines_vertices; //decive local
-
-		Helpers::AllocatedBuffer Camera_src;
-		Helpers::AllocatedBuffer Camera;
-		VkDescriptorSet Camera_descriptors;
+		//this frame's lines vertices, Camera, World, and Transforms, bump-allocated from one persistently-mapped buffer
+		// that the GPU reads in place (with dynamic offsets; device-local where the CPU can write that directly, see
+		// Helpers::create_dynamic_buffer); reset by each render(), once the workspace's fence has signaled:
+		Helpers::AllocatedBuffer Frame;
+		VkDeviceSize Frame_used = 0; //bytes allocated so far this frame
+		VkDeviceSize Transforms_range = 0; //size of the Transforms descriptor's range (and of each frame's Transforms allocation)
 
-		Helpers::AllocatedBuffer World_src;
-		Helpers::AllocatedBuffer World;
+		VkDescriptorSet Camera_descriptors; //(lines pipeline)
 		VkDescriptorSet World_descriptors;
+		VkDescriptorSet Transforms_descriptors;
 
-		Helpers::AllocatedImage Env_src;
-		VkImageView Env;
-		VkSampler env_sampler = VK_NULL_HANDLE;
-		
-		Helpers::AllocatedImage Env_Lambertian_src;
-		VkImageView Env_Lambertian;
-
-		//ObjectsPipeline::Transofrms data
-		Helpers::AllocatedBuffer Transforms_src;
-		Helpers::AllocatedBuffer Transforms;
-		VkDescriptorSet Transforms_descriptors;	
-
-		Helpers::AllocatedBuffer Material_src;
-		Helpers::AllocatedBuffer Material;
-		VkDescriptorSet Material_descriptors;
+		//texture table (one per workspace, so it can be updated while other workspaces' frames are in flight):
+		VkDescriptorSet Textures_descriptors = VK_NULL_HANDLE;
+		std::vector< VkImageView > Textures_written; //views currently in Textures_descriptors (vs texture_views)
 
 		// index of the first timestamp query assigned to this workspace (uses two queries: start/end)
 		uint32_t query_index = 0;
 	};
 	std::vector< Workspace > workspaces;
+	VkDeviceSize frame_alignment = 16; //for sub-allocations of Workspace::Frame
+	//point a workspace's Camera, World, and Transforms descriptors at its (new) Frame buffer:
+	void write_frame_descriptors(Workspace &workspace);
 
 	// Query pool for GPU timestamp measurements
 	VkQueryPool query_pool = VK_NULL_HANDLE;
@@ -199,28 +222,65 @@ struct Tutorial : RTG::Application {
 
 	//-------------------------------------------------------------------
 	//static scene resources:
-	Helpers::AllocatedBuffer object_vertices;
+	Helpers::AllocatedBuffer object_vertices; //ObjectsPipeline::Vertex or ::PackedVertex (see packed_vertices)
+	bool packed_vertices = false; //positions are quantized to each mesh's AABB
+
+	//only used during construction; loaded from (or recorded to) `--scene-cache`:
+	std::unique_ptr< SceneCache > scene_cache;
+	//only used during construction; images decoding in the background (see prefetch_image):
+	std::unique_ptr< ThreadPool > image_pool;
+	struct PendingImage {
+		std::shared_ptr< SceneCache::Image > image; //written by the decode job
+		std::shared_future< void > done; //ready (or holding the decode's exception) once image is written
+	};
+	std::unordered_map< std::string, PendingImage > pending_images; //by orientation + path
+	double image_wait_ms = 0.0; //time the constructor spent blocked on decodes
+	uint32_t baked_images_used = 0; //images uploaded from `bake`d .ktx2 files instead of being decoded
+	std::vector< uint32_t > texture_same_as; //only used during construction; S72::Texture::index -> index of the first texture with an identical image file (itself if none)
+	Helpers::AllocatedBuffer object_indices; //all meshes' indices, widened to VK_INDEX_TYPE_UINT32
 	struct ObjectVertices{
-		uint32_t first = 0;
-		uint32_t count = 0;
+		uint32_t first = 0; //first vertex (also the vertexOffset for indexed draws)
+		uint32_t count = 0; //vertex count
+		uint32_t first_index = 0;
+		uint32_t index_count = 0; //0 => non-indexed mesh, use vkCmdDraw
 		vec3 min_aabb_bound = vec3(std::numeric_limits<float>::max());
 		vec3 max_aabb_bound = vec3(std::numeric_limits<float>::lowest());
 	};
-	//a performant way would be unordered_map<string, ObjectVertices>
-	std::unordered_map<std::string, ObjectVertices> object_vertices_list;
+	std::vector<ObjectVertices> object_vertices_list; //indexed by S72::Mesh::index
 
 	std::vector<Helpers::AllocatedImage> textures;
 	std::vector<VkImageView> texture_views;
 	VkSampler texture_sampler = VK_NULL_HANDLE;
-	VkDescriptorPool texture_descriptor_pool = VK_NULL_HANDLE;
-	std::vector<VkDescriptorSet> texture_descriptors;
+	VkDescriptorPool texture_descriptor_pool = VK_NULL_HANDLE; //(for the workspaces' Textures_descriptors)
+	//streams flat textures' mip levels in and out under `--texture-budget-mb` (null => textures are fully resident);
+	// replaces entries of textures / texture_views from update():
+	std::unique_ptr< TextureStreamer > texture_streamer;
+
+	//environment cube maps, shared by every workspace's World descriptor set:
+	Helpers::AllocatedImage Env_src;
+	VkImageView Env = VK_NULL_HANDLE;
+	VkSampler env_sampler = VK_NULL_HANDLE;
+	Helpers::AllocatedImage Env_Lambertian_src;
+	VkImageView Env_Lambertian = VK_NULL_HANDLE;
+
+	//materials don't change after loading, so one buffer (uploaded once) serves every workspace:
+	Helpers::AllocatedBuffer Material; //ObjectsPipeline::Material, indexed by S72::Material::index
+	Helpers::AllocatedBuffer TextureRects; //ObjectsPipeline::TextureRect, indexed by texture id
+	VkDescriptorSet Material_descriptors = VK_NULL_HANDLE;
 
 	//--------------------------------------------------------------------
 	//Resources that change when the swapchain is resized:
 
 	virtual void on_swapchain(RTG &, RTG::SwapchainEvent const &) override;
 
-	Helpers::AllocatedImage swapchain_depth_image;
+	//passes in frame order, and the transient attachments they use (aliased in memory where their pass ranges don't overlap):
+	enum Pass : uint32_t {
+		MainPass = 0, //objects + lines, into the swapchain image
+	};
+	enum Target : uint32_t {
+		DepthTarget = 0, //(shared by all the framebuffers)
+	};
+	Helpers::RenderTargetPool render_targets; //indexed by Target
 	VkImageView swapchain_depth_image_view = VK_NULL_HANDLE;
 	std::vector< VkFramebuffer > swapchain_framebuffers;
 	//used from on_swapchain and the destructor: (framebuffers are created in on_swapchain)
@@ -294,19 +354,19 @@ struct Tutorial : RTG::Application {
 
 	std::vector<LinesPipeline::Vertex> lines_vertices;
 	ObjectsPipeline::World world;
-	std::vector<ObjectsPipeline::Material> materials;
-	std::unordered_map<S72::Material*, uint32_t> material_ptr_to_index;
-	std::unordered_map<S72::Texture*, uint32_t> texture_ptr_to_index;
+	std::vector<ObjectsPipeline::Material> materials; //indexed by S72::Material::index
+	std::vector<uint32_t> texture_slots; //S72::Texture::index -> texture id, i.e., index in texture_rects (max if not in there)
+	std::vector<ObjectsPipeline::TextureRect> texture_rects; //texture id -> where in textures / texture_views it is
 
 	struct ObjectInstance {
 		ObjectVertices vertices;
 		ObjectsPipeline::Transform transform;
+		mat4 world_from_local; //(transform.WORLD_FROM_LOCAL also includes dequantization when using packed vertices)
 		uint32_t albedo_tex = std::numeric_limits<uint32_t>::max();
 		uint32_t normal_tex = std::numeric_limits<uint32_t>::max();
 		uint32_t displacement_tex = std::numeric_limits<uint32_t>::max();
 		uint32_t roughness_tex = std::numeric_limits<uint32_t>::max();
 		uint32_t metalness_tex = std::numeric_limits<uint32_t>::max();
-		VkDescriptorSet texture_set = VK_NULL_HANDLE;
 		// std::string material = "";
 	};
 	std::vector<ObjectInstance> object_instances;
@@ -315,8 +375,24 @@ struct Tutorial : RTG::Application {
 	//Helper functions:
 	void traverse_children(S72 &s72, S72::Node* node, size_t &instanceIndex, mat4 local_trans, std::vector<ObjectInstance> &objects);
 	void fill_scene_graph(S72 &s72,  std::vector<ObjectInstance> &object_instances);
-	ObjectsPipeline::Transform makeInstanceData(mat4 world_from_local, uint32_t material_index);
+	//decoded RGBA8 image (optionally flipped in y), from the scene cache if possible:
+	// (waits for a prefetch_image() decode of the same image, if there is one)
+	SceneCache::Image load_image(std::string const &path, bool flip_y);
+	//start decoding an image on image_pool, unless it is already cached or on its way:
+	void prefetch_image(std::string const &path, bool flip_y);
+	//RGBE vertical-strip cube map (or its baked version) -> cube-compatible image, E5B9G9R9 (or BC6H if baked):
+	Helpers::AllocatedImage load_rgbe_cube(std::string const &path);
+	//is there an up-to-date baked (.ktx2) version of this image that may be used?
+	bool has_baked(std::string const &path) const;
+	//create + upload *image from the baked version of path, if there is one in one of 'formats' with 'faces' faces (6 => cube compatible):
+	// returns false (with a warning if a baked file was present but unusable) so the caller can fall back to the source image
+	bool load_baked(std::string const &path, std::vector< VkFormat > const &formats, uint32_t faces, Helpers::AllocatedImage *image);
+	//(just the checking + loading part of load_baked, for callers that upload the levels themselves)
+	bool open_baked(std::string const &path, std::vector< VkFormat > const &formats, uint32_t faces, KTX2::File *file);
+	ObjectsPipeline::Transform makeInstanceData(mat4 world_from_local, uint32_t material_index, ObjectVertices const &vertices);
 	bool aabb_intersects_frustum_SAT(const mat4& clip, const ObjectInstance& instance);
+	//approximate size (in pixels, along the larger screen axis) of an instance's bounding box when drawn with clip:
+	float screen_size(const mat4& clip, const ObjectInstance& instance);
 
 	//--------------------------------------------------------------------
 	//Rendering function, uses all the resources above to queue work to draw a frame:
@@ -0,0 +1,357 @@
+//Offline texture baker:
+//  bake scene.s72 [--lambertian lambertian.png] [--force]
+//
+//Converts every image a scene's materials and environments use into a block-compressed KTX2 file
+// next to the source image (see KTX2::baked_path), which the viewer then loads instead of the source:
+// - albedo: BC1 (BC3 if any texel has alpha < 255), sRGB if the texture is "srgb"
+// - roughness / metalness / displacement: BC1 / BC3, linear
+// - normal maps: BC5 (x, y only; the shader rebuilds z)
+// - RGBE cube maps (environment radiance, and the lambertian map given with --lambertian): BC6H, 6 faces
+//
+// 2D textures get a full mip chain (box filtered; sRGB averaged in linear, normals renormalized) and are
+// stored flipped in y, matching what the viewer uploads. Cube maps get one level, since the viewer samples them at level 0.
+// Files whose baked version is already newer than the source are skipped unless --force is given.
+
+#include "BlockCompress.hpp"
+#include "KTX2.hpp"
+#include "S72.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb_image/stb_image.h"
+
+#include <cstring> //(stb_dxt's implementation uses memcpy without including it)
+#define STB_DXT_IMPLEMENTATION
+#include "external/stb_image/stb_dxt.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class Kind {
+	Color, //albedo
+	Data, //roughness, metalness, displacement
+	Normal, //tangent-space normal map
+	Cube, //RGBE cube map
+};
+
+char const *kind_name(Kind kind) {
+	switch (kind) {
+		case Kind::Color: return "color";
+		case Kind::Data: return "data";
+		case Kind::Normal: return "normal";
+		case Kind::Cube: return "cube";
+	}
+	return "?";
+}
+
+struct Job {
+	std::string path;
+	Kind kind;
+	bool srgb;
+};
+
+//decoded RGBA8 image; stb_image owns the texels:
+struct Source {
+	uint32_t width = 0, height = 0;
+	std::unique_ptr< uint8_t, void(*)(void *) > texels{nullptr, stbi_image_free};
+};
+
+Source load_source(std::string const &path) {
+	int width, height, channels;
+	uint8_t *data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!data) throw std::runtime_error("Failed to load image '" + path + "': " + stbi_failure_reason());
+	Source source;
+	source.width = uint32_t(width);
+	source.height = uint32_t(height);
+	source.texels.reset(data);
+	return source;
+}
+
+float srgb_to_linear(float v) {
+	return (v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f));
+}
+float linear_to_srgb(float v) {
+	return (v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f);
+}
+
+//RGBA float image used while building mips:
+struct Level {
+	uint32_t width = 0, height = 0;
+	std::vector< float > texels; //width * height * 4
+};
+
+//2x2 box filter (the last row / column repeats for odd sizes):
+Level downsample(Level const &from, Kind kind) {
+	Level to;
+	to.width = std::max(1u, from.width / 2);
+	to.height = std::max(1u, from.height / 2);
+	to.texels.resize(size_t(to.width) * to.height * 4);
+	for (uint32_t y = 0; y < to.height; ++y) {
+		for (uint32_t x = 0; x < to.width; ++x) {
+			float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (uint32_t dy = 0; dy < 2; ++dy) {
+				uint32_t sy = std::min(2 * y + dy, from.height - 1);
+				for (uint32_t dx = 0; dx < 2; ++dx) {
+					uint32_t sx = std::min(2 * x + dx, from.width - 1);
+					float const *t = &from.texels[(size_t(sy) * from.width + sx) * 4];
+					for (uint32_t c = 0; c < 4; ++c) sum[c] += t[c];
+				}
+			}
+			float *t = &to.texels[(size_t(y) * to.width + x) * 4];
+			for (uint32_t c = 0; c < 4; ++c) t[c] = 0.25f * sum[c];
+			if (kind == Kind::Normal) {
+				float len = std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+				if (len > 0.0f) for (uint32_t c = 0; c < 3; ++c) t[c] /= len;
+			}
+		}
+	}
+	return to;
+}
+
+//RGBA8 -> the space mips are averaged in (linear color, [-1,1] normals, or [0,1] data):
+Level to_float(uint32_t width, uint32_t height, uint8_t const *rgba, Kind kind, bool srgb) {
+	Level level;
+	level.width = width;
+	level.height = height;
+	level.texels.resize(size_t(width) * height * 4);
+	float srgb_table[256];
+	for (uint32_t i = 0; i < 256; ++i) srgb_table[i] = srgb_to_linear(i / 255.0f);
+	for (size_t i = 0; i < level.texels.size(); ++i) {
+		bool alpha = (i % 4 == 3);
+		if (kind == Kind::Normal && !alpha) level.texels[i] = rgba[i] / 255.0f * 2.0f - 1.0f;
+		else if (srgb && !alpha) level.texels[i] = srgb_table[rgba[i]];
+		else level.texels[i] = rgba[i] / 255.0f;
+	}
+	return level;
+}
+
+std::vector< uint8_t > to_rgba8(Level const &level, Kind kind, bool srgb) {
+	std::vector< uint8_t > rgba(level.texels.size());
+	for (size_t i = 0; i < level.texels.size(); ++i) {
+		bool alpha = (i % 4 == 3);
+		float v = level.texels[i];
+		if (kind == Kind::Normal && !alpha) v = v * 0.5f + 0.5f;
+		else if (srgb && !alpha) v = linear_to_srgb(v);
+		rgba[i] = uint8_t(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+	return rgba;
+}
+
+//stb_dxt block encoders, in the form BlockCompress::rgba8_blocks wants:
+void bc1_block(uint8_t const rgba[16 * 4], uint8_t *out) {
+	stb_compress_dxt_block(out, rgba, 0, STB_DXT_HIGHQUAL);
+}
+void bc3_block(uint8_t const rgba[16 * 4], uint8_t *out) {
+	stb_compress_dxt_block(out, rgba, 1, STB_DXT_HIGHQUAL);
+}
+void bc5_block(uint8_t const rgba[16 * 4], uint8_t *out) {
+	uint8_t rg[16 * 2];
+	for (uint32_t i = 0; i < 16; ++i) {
+		rg[2 * i + 0] = rgba[4 * i + 0];
+		rg[2 * i + 1] = rgba[4 * i + 1];
+	}
+	stb_compress_bc5_block(out, rg);
+}
+
+KTX2::Image bake_flat(Job const &job) {
+	Source source = load_source(job.path);
+
+	bool has_alpha = false;
+	for (size_t i = 3; i < size_t(source.width) * source.height * 4; i += 4) {
+		if (source.texels.get()[i] != 255) { has_alpha = true; break; }
+	}
+
+	KTX2::Image image;
+	image.width = source.width;
+	image.height = source.height;
+	image.orientation = "ru";
+	if (job.kind == Kind::Normal) image.format = VK_FORMAT_BC5_UNORM_BLOCK;
+	else if (has_alpha) image.format = (job.srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK);
+	else image.format = (job.srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+
+	//level 0 is compressed straight from the source, flipped in y as the viewer does for 2D textures:
+	std::vector< uint8_t > rgba(size_t(source.width) * source.height * 4);
+	for (uint32_t y = 0; y < source.height; ++y) {
+		std::copy_n(source.texels.get() + size_t(source.height - 1 - y) * source.width * 4, size_t(source.width) * 4, rgba.data() + size_t(y) * source.width * 4);
+	}
+	source.texels.reset();
+
+	Level level = to_float(image.width, image.height, rgba.data(), job.kind, job.srgb);
+	while (true) {
+		if (image.format == VK_FORMAT_BC5_UNORM_BLOCK) image.levels.emplace_back(BlockCompress::rgba8_blocks(level.width, level.height, rgba.data(), 16, bc5_block));
+		else if (has_alpha) image.levels.emplace_back(BlockCompress::rgba8_blocks(level.width, level.height, rgba.data(), 16, bc3_block));
+		else image.levels.emplace_back(BlockCompress::rgba8_blocks(level.width, level.height, rgba.data(), 8, bc1_block));
+		if (level.width == 1 && level.height == 1) break;
+		level = downsample(level, job.kind);
+		rgba = to_rgba8(level, job.kind, job.srgb);
+	}
+	return image;
+}
+
+KTX2::Image bake_cube(Job const &job) {
+	Source source = load_source(job.path);
+	//vertical strip of six square faces, as the viewer expects:
+	if (source.height != source.width * 6) {
+		throw std::runtime_error("Cube map '" + job.path + "' is " + std::to_string(source.width) + "x" + std::to_string(source.height) + ", not a 1x6 vertical strip.");
+	}
+	uint32_t size = source.width;
+
+	KTX2::Image image;
+	image.format = VK_FORMAT_BC6H_UFLOAT_BLOCK;
+	image.width = size;
+	image.height = size;
+	image.faces = 6;
+	image.levels.emplace_back();
+
+	std::vector< float > rgb(size_t(size) * size * 3);
+	for (uint32_t face = 0; face < 6; ++face) {
+		uint8_t const *src = source.texels.get() + size_t(face) * size * size * 4;
+		for (size_t i = 0; i < size_t(size) * size; ++i) {
+			glm::vec3 c = rgbe_to_float(glm::u8vec4(src[4 * i + 0], src[4 * i + 1], src[4 * i + 2], src[4 * i + 3]));
+			rgb[3 * i + 0] = c.r;
+			rgb[3 * i + 1] = c.g;
+			rgb[3 * i + 2] = c.b;
+		}
+		std::vector< uint8_t > blocks = BlockCompress::bc6h(size, size, rgb.data());
+		image.levels[0].insert(image.levels[0].end(), blocks.begin(), blocks.end());
+	}
+	return image;
+}
+
+} //namespace
+
+int main(int argc, char **argv) {
+	std::string scene_file;
+	std::string lambertian_file;
+	bool force = false;
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--lambertian") {
+			if (argi + 1 >= argc) {
+				std::cerr << "--lambertian requires a parameter (a lambertian cube map file name)." << std::endl;
+				return 1;
+			}
+			argi += 1;
+			lambertian_file = argv[argi];
+		} else if (arg == "--force") {
+			force = true;
+		} else if (scene_file == "" && arg.substr(0, 2) != "--") {
+			scene_file = arg;
+		} else {
+			std::cerr << "Unrecognized argument '" << arg << "'." << std::endl;
+			scene_file = "";
+			break;
+		}
+	}
+	if (scene_file == "") {
+		std::cerr << "Usage: bake scene.s72 [--lambertian lambertian.png] [--force]" << std::endl;
+		return 1;
+	}
+
+	S72 s72;
+	try {
+		s72 = S72::load(scene_file);
+	} catch (std::exception &e) {
+		std::cerr << "Failed to load s72-format scene from '" << scene_file << "':\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	//collect images by path (in file order), with how they are used:
+	std::vector< Job > jobs;
+	std::map< std::string, size_t > job_index;
+	auto add = [&](S72::Texture const *tex, Kind kind) {
+		if (!tex) return;
+		bool srgb = (tex->format == S72::Texture::Format::srgb);
+		if (kind == Kind::Cube && (tex->type != S72::Texture::Type::cube || tex->format != S72::Texture::Format::rgbe)) {
+			std::cerr << "Skipping '" << tex->path << "': only RGBE cube maps can be baked as cube maps." << std::endl;
+			return;
+		}
+		if (kind != Kind::Cube && tex->type != S72::Texture::Type::flat) {
+			std::cerr << "Skipping '" << tex->path << "': cube maps are only baked for environments." << std::endl;
+			return;
+		}
+		auto [it, added] = job_index.emplace(tex->path, jobs.size());
+		if (added) {
+			jobs.emplace_back(Job{ .path = tex->path, .kind = kind, .srgb = srgb });
+			return;
+		}
+		Job &job = jobs[it->second];
+		if (job.srgb != srgb || (job.kind == Kind::Cube) != (kind == Kind::Cube)) {
+			std::cerr << "Warning: '" << tex->path << "' is used as both " << kind_name(job.kind) << (job.srgb ? " (srgb)" : "")
+			          << " and " << kind_name(kind) << (srgb ? " (srgb)" : "") << "; baking it for the first use only." << std::endl;
+		} else if (job.kind != kind) {
+			//shared between a normal map and other linear data: keep all channels
+			job.kind = Kind::Data;
+		}
+	};
+	for (S72::Material const *mat : s72.tables.materials) {
+		add(mat->normal_map, Kind::Normal);
+		add(mat->displacement_map, Kind::Data);
+		if (auto pbr = std::get_if< S72::Material::PBR >(&mat->brdf)) {
+			if (auto tex = std::get_if< S72::Texture * >(&pbr->albedo)) add(*tex, Kind::Color);
+			if (auto tex = std::get_if< S72::Texture * >(&pbr->roughness)) add(*tex, Kind::Data);
+			if (auto tex = std::get_if< S72::Texture * >(&pbr->metalness)) add(*tex, Kind::Data);
+		} else if (auto lambertian = std::get_if< S72::Material::Lambertian >(&mat->brdf)) {
+			if (auto tex = std::get_if< S72::Texture * >(&lambertian->albedo)) add(*tex, Kind::Color);
+		}
+	}
+	for (S72::Environment const *env : s72.tables.environments) {
+		add(env->radiance, Kind::Cube);
+	}
+	if (lambertian_file != "" && !job_index.count(lambertian_file)) {
+		job_index.emplace(lambertian_file, jobs.size());
+		jobs.emplace_back(Job{ .path = lambertian_file, .kind = Kind::Cube, .srgb = false });
+	}
+
+	std::atomic< uint32_t > baked{0}, skipped{0}, failed{0};
+	std::atomic< size_t > source_bytes{0}, baked_bytes{0};
+	std::mutex print_mutex; //(so lines from different jobs don't interleave)
+	{
+		ThreadPool pool;
+		Timer timer([&](double elapsed){
+			std::cout << "Baked " << baked << " images (" << skipped << " already current, " << failed << " failed) on "
+			          << pool.size() << " threads in " << elapsed * 1000.0 << " ms; "
+			          << source_bytes / 1024 << " KiB as RGBA8 -> " << baked_bytes / 1024 << " KiB compressed." << std::endl;
+		});
+		pool.run_all(uint32_t(jobs.size()), [&](uint32_t i) {
+			Job const &job = jobs[i];
+			std::string out = KTX2::baked_path(job.path);
+			if (!force && KTX2::baked_is_current(job.path)) {
+				++skipped;
+				return;
+			}
+			try {
+				KTX2::Image image = (job.kind == Kind::Cube ? bake_cube(job) : bake_flat(job));
+				KTX2::save(out, image);
+
+				size_t bytes = 0;
+				for (auto const &level : image.levels) bytes += level.size();
+				size_t rgba_bytes = size_t(image.width) * image.height * 4 * image.faces;
+				if (image.levels.size() > 1) rgba_bytes = rgba_bytes * 4 / 3; //(as the viewer would mip it)
+				source_bytes += rgba_bytes;
+				baked_bytes += bytes;
+				++baked;
+				std::lock_guard< std::mutex > lock(print_mutex);
+				std::cout << "  '" << job.path << "' -> " << string_VkFormat(image.format) << " " << image.width << "x" << image.height
+				          << (image.faces == 6 ? " cube" : "") << ", " << image.levels.size() << " levels, " << bytes / 1024 << " KiB" << std::endl;
+			} catch (std::exception &e) {
+				std::lock_guard< std::mutex > lock(print_mutex);
+				std::cerr << "Failed to bake '" << job.path << "':\n" << e.what() << std::endl;
+				++failed;
+			}
+		});
+	}
+
+	return (failed ? 1 : 0);
+}
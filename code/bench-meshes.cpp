@@ -0,0 +1,298 @@
+//Mesh loading benchmark:
+//  bench-meshes [--vertices N] [--meshes M] [--runs R] [--dir folder] [--check-optimize]
+//
+//Writes a synthetic scene (bench-meshes.s72 + bench-meshes.b72, interleaved PosNorTanTex data, M meshes
+// sharing one data file, N vertices in total) to folder, then times loading every mesh's vertices
+// with MeshLoader against the per-vertex seekg / read loop the viewer used before it.
+// Both loaders' output is checked against each other, so the comparison is of equal work.
+//
+//With --check-optimize, every other mesh gets an index stream instead, and the scene is loaded through
+// MeshLoader::append with and without mesh optimization (as --optimize-meshes does in the viewer).
+// Every mesh must still draw the same triangles afterward; exits with an error if one doesn't.
+
+#include "MeshLoader.hpp"
+#include "S72.hpp"
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+//write the synthetic scene + data file:
+// if 'indexed', odd meshes draw their vertices through an index stream (stored after the vertices)
+void write_scene(std::string const &folder, uint32_t vertices, uint32_t meshes, bool indexed) {
+	constexpr uint32_t stride = uint32_t(sizeof(PosNorTanTexVertex));
+
+	//split the vertices into (triangle-sized) runs; unevenly when indexed, so no two meshes' ranges line up:
+	std::vector< uint32_t > firsts(meshes + 1, vertices);
+	uint64_t weights = (indexed ? uint64_t(meshes) * (meshes + 1) / 2 : meshes);
+	for (uint32_t m = 0, weight = 0; m < meshes; ++m) {
+		firsts[m] = uint32_t(uint64_t(vertices / 3) * weight / weights) * 3;
+		weight += (indexed ? m + 1 : 1);
+	}
+	auto mesh_first = [&](uint32_t m) { return firsts[m]; };
+	auto mesh_count = [&](uint32_t m) { return firsts[m + 1] - firsts[m]; };
+	auto mesh_indexed = [&](uint32_t m) { return indexed && (m % 2) == 1; };
+
+	std::vector< uint32_t > index_offsets(meshes, 0);
+	{ //data file, written in chunks:
+		std::ofstream out(folder + "/bench-meshes.b72", std::ios::binary);
+		if (!out) throw std::runtime_error("Failed to open '" + folder + "/bench-meshes.b72' for writing.");
+		std::vector< PosNorTanTexVertex > chunk;
+		chunk.reserve(1 << 16);
+		for (uint32_t i = 0; i < vertices; ) {
+			chunk.clear();
+			for (; i < vertices && chunk.size() < chunk.capacity(); ++i) {
+				float t = float(i) / float(vertices);
+				chunk.emplace_back(PosNorTanTexVertex{
+					.Position{ .x = t * 10.0f, .y = float(i % 1024) * 0.01f, .z = float(i % 7) - 3.0f },
+					.Normal{ .x = 0.0f, .y = 0.0f, .z = 1.0f },
+					.Tangent{ .x = 1.0f, .y = 0.0f, .z = 0.0f, .w = 1.0f },
+					.TexCoord{ .s = t, .t = 1.0f - t },
+				});
+			}
+			out.write(reinterpret_cast< char const * >(chunk.data()), chunk.size() * stride);
+		}
+		//index streams, drawing the mesh's triangles in reverse order, with corners rotated by a per-mesh amount:
+		uint32_t offset = vertices * stride;
+		for (uint32_t m = 0; m < meshes; ++m) {
+			if (!mesh_indexed(m)) continue;
+			index_offsets[m] = offset;
+			std::vector< uint32_t > indices;
+			indices.reserve(mesh_count(m));
+			uint32_t rotate = (m / 2) % 3;
+			for (uint32_t t = mesh_count(m) / 3; t > 0; --t) {
+				for (uint32_t c = 0; c < 3; ++c) {
+					indices.emplace_back(3 * (t - 1) + (c + rotate) % 3);
+				}
+			}
+			out.write(reinterpret_cast< char const * >(indices.data()), indices.size() * sizeof(uint32_t));
+			offset += uint32_t(indices.size() * sizeof(uint32_t));
+		}
+		if (!out) throw std::runtime_error("Failed to write '" + folder + "/bench-meshes.b72'.");
+	}
+
+	{ //scene file:
+		std::ofstream out(folder + "/bench-meshes.s72");
+		if (!out) throw std::runtime_error("Failed to open '" + folder + "/bench-meshes.s72' for writing.");
+		out << "[\"s72-v2\",\n";
+		out << "{\"type\":\"SCENE\",\"name\":\"bench\",\"roots\":[]}";
+		for (uint32_t m = 0; m < meshes; ++m) {
+			uint32_t first = mesh_first(m);
+			uint32_t count = (mesh_indexed(m) ? mesh_count(m) / 3 * 3 : mesh_count(m)); //(indexed meshes' count is their index count)
+			auto attribute = [&](char const *name, uint32_t offset, char const *format) {
+				out << "\"" << name << "\":{\"src\":\"bench-meshes.b72\",\"offset\":" << first * stride + offset
+				    << ",\"stride\":" << stride << ",\"format\":\"" << format << "\"}";
+			};
+			out << ",\n{\"type\":\"MESH\",\"name\":\"mesh" << m << "\",\"topology\":\"TRIANGLE_LIST\",\"count\":" << count << ",\"attributes\":{";
+			attribute("POSITION", offsetof(PosNorTanTexVertex, Position), "R32G32B32_SFLOAT"); out << ",";
+			attribute("NORMAL", offsetof(PosNorTanTexVertex, Normal), "R32G32B32_SFLOAT"); out << ",";
+			attribute("TANGENT", offsetof(PosNorTanTexVertex, Tangent), "R32G32B32A32_SFLOAT"); out << ",";
+			attribute("TEXCOORD", offsetof(PosNorTanTexVertex, TexCoord), "R32G32_SFLOAT");
+			out << "}";
+			if (mesh_indexed(m)) {
+				out << ",\"indices\":{\"src\":\"bench-meshes.b72\",\"offset\":" << index_offsets[m] << ",\"format\":\"UINT32\"}";
+			}
+			out << "}";
+		}
+		out << "\n]\n";
+		if (!out) throw std::runtime_error("Failed to write '" + folder + "/bench-meshes.s72'.");
+	}
+}
+
+//the viewer's original loader: one seekg per vertex, then sequential reads of each attribute
+// (assumes the interleaved layout, as it did)
+void load_seekg(S72 const &s72, std::vector< PosNorTanTexVertex > &vertices, vec3 *min, vec3 *max) {
+	for (S72::Mesh const *mesh_ptr : s72.tables.meshes) {
+		S72::Mesh const &mesh = *mesh_ptr;
+		auto const &position = mesh.attributes.at("POSITION");
+		std::ifstream in(position.src.path, std::ios::binary);
+		if (!in) throw std::runtime_error("Failed to open data file: " + position.src.path);
+		for (uint32_t i = 0; i < mesh.count; ++i) {
+			PosNorTanTexVertex &v = vertices.emplace_back();
+			in.seekg(std::streamoff(i) * position.stride + position.offset, std::ios::beg);
+			in.read(reinterpret_cast< char * >(&v.Position), sizeof(v.Position));
+			min->x = std::min(min->x, v.Position.x);
+			min->y = std::min(min->y, v.Position.y);
+			min->z = std::min(min->z, v.Position.z);
+			max->x = std::max(max->x, v.Position.x);
+			max->y = std::max(max->y, v.Position.y);
+			max->z = std::max(max->z, v.Position.z);
+			in.read(reinterpret_cast< char * >(&v.Normal), sizeof(v.Normal));
+			in.read(reinterpret_cast< char * >(&v.Tangent), sizeof(v.Tangent));
+			in.read(reinterpret_cast< char * >(&v.TexCoord), sizeof(v.TexCoord));
+		}
+		if (!in) throw std::runtime_error("Failed to read data file: " + position.src.path);
+	}
+}
+
+void load_mapped(S72 const &s72, std::vector< PosNorTanTexVertex > &vertices, vec3 *min, vec3 *max) {
+	MeshLoader loader;
+	for (S72::Mesh const *mesh : s72.tables.meshes) {
+		loader.load_vertices(*mesh, mesh->count, vertices, min, max);
+	}
+}
+
+//the triangles a mesh draws from the shared arrays, sorted (so they can be compared regardless of order):
+using Triangle = std::array< PosNorTanTexVertex, 3 >;
+std::vector< Triangle > drawn_triangles(S72::Mesh const &mesh, MeshLoader::Range const &range, std::vector< PosNorTanTexVertex > const &vertices, std::vector< uint32_t > const &indices) {
+	if (size_t(range.first) + range.count > vertices.size() || size_t(range.first_index) + range.index_count > indices.size()) {
+		throw std::runtime_error("Mesh \"" + mesh.name + "\"'s range lies outside the shared vertex / index arrays.");
+	}
+	auto vertex = [&](uint32_t i) -> PosNorTanTexVertex const & {
+		if (i >= range.count) throw std::runtime_error("Mesh \"" + mesh.name + "\" draws vertex " + std::to_string(i) + " of " + std::to_string(range.count) + ".");
+		return vertices[range.first + i];
+	};
+	uint32_t drawn = (range.index_count ? range.index_count : range.count);
+	std::vector< Triangle > triangles;
+	triangles.reserve(drawn / 3);
+	for (uint32_t i = 0; i + 2 < drawn; i += 3) {
+		Triangle &t = triangles.emplace_back();
+		for (uint32_t c = 0; c < 3; ++c) {
+			t[c] = vertex(range.index_count ? indices[range.first_index + i + c] : i + c);
+		}
+	}
+	std::sort(triangles.begin(), triangles.end(), [](Triangle const &a, Triangle const &b) {
+		return std::memcmp(a.data(), b.data(), sizeof(Triangle)) < 0;
+	});
+	return triangles;
+}
+
+//load the (mixed indexed / non-indexed) scene with and without optimization and compare what each mesh draws:
+void check_optimize(S72 const &s72) {
+	struct Load {
+		MeshLoader loader;
+		std::vector< PosNorTanTexVertex > vertices;
+		std::vector< uint32_t > indices;
+		std::vector< MeshLoader::Range > ranges;
+	};
+	Load plain, optimized;
+	for (S72::Mesh const *mesh : s72.tables.meshes) {
+		plain.ranges.emplace_back(plain.loader.append(*mesh, plain.vertices, plain.indices, false));
+		optimized.ranges.emplace_back(optimized.loader.append(*mesh, optimized.vertices, optimized.indices, true));
+	}
+
+	//(only after every mesh is appended, since a later append could clobber an earlier mesh's data)
+	for (S72::Mesh const *mesh : s72.tables.meshes) {
+		std::vector< Triangle > before = drawn_triangles(*mesh, plain.ranges[mesh->index], plain.vertices, plain.indices);
+		std::vector< Triangle > after = drawn_triangles(*mesh, optimized.ranges[mesh->index], optimized.vertices, optimized.indices);
+		if (before.size() != after.size() || std::memcmp(before.data(), after.data(), before.size() * sizeof(Triangle)) != 0) {
+			throw std::runtime_error("Mesh \"" + mesh->name + "\" draws different triangles after optimization.");
+		}
+	}
+
+	MeshOptimizer::Stats const &stats = optimized.loader.optimize_stats;
+	std::cout << "  " << s72.tables.meshes.size() << " meshes (" << plain.loader.indexed_meshes << " indexed) draw the same triangles after optimization." << std::endl;
+	std::cout << "  optimized " << stats.triangles << " triangles: vertices " << stats.vertices_before << " -> " << stats.vertices_after
+	          << ", ACMR (FIFO " << MeshOptimizer::DefaultCacheSize << ") " << stats.acmr_before() << " -> " << stats.acmr_after()
+	          << " (in " << optimized.loader.optimize_ms << " ms)." << std::endl;
+}
+
+} //namespace
+
+int main(int argc, char **argv) {
+	uint32_t vertices = 4'000'002;
+	uint32_t meshes = 16;
+	uint32_t runs = 5;
+	std::string folder = std::filesystem::temp_directory_path().string();
+	bool check = false;
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if ((arg == "--vertices" || arg == "--meshes" || arg == "--runs" || arg == "--dir") && argi + 1 >= argc) {
+			std::cerr << arg << " requires a parameter." << std::endl;
+			return 1;
+		}
+		if (arg == "--vertices") {
+			argi += 1;
+			vertices = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--meshes") {
+			argi += 1;
+			meshes = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--runs") {
+			argi += 1;
+			runs = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--dir") {
+			argi += 1;
+			folder = argv[argi];
+		} else if (arg == "--check-optimize") {
+			check = true;
+		} else {
+			std::cerr << "Unrecognized argument '" << arg << "'." << std::endl;
+			std::cerr << "Usage: bench-meshes [--vertices N] [--meshes M] [--runs R] [--dir folder] [--check-optimize]" << std::endl;
+			return 1;
+		}
+	}
+	if (meshes == 0 || runs == 0 || vertices < 3 * (check ? meshes * (meshes + 1) / 2 : meshes) || uint64_t(vertices) * (sizeof(PosNorTanTexVertex) + sizeof(uint32_t)) > std::numeric_limits< uint32_t >::max()) {
+		std::cerr << "Need at least one mesh and run, three vertices per mesh (per unit of mesh size with --check-optimize), and a data file under 4GB." << std::endl;
+		return 1;
+	}
+
+	try {
+		write_scene(folder, vertices, meshes, check);
+		S72 s72 = S72::load(folder + "/bench-meshes.s72");
+		std::cout << "Scene: " << s72.tables.meshes.size() << " meshes, " << vertices << " vertices ("
+		          << uint64_t(vertices) * sizeof(PosNorTanTexVertex) << " bytes) in '" << folder << "/bench-meshes.b72'." << std::endl;
+
+		if (check) {
+			check_optimize(s72);
+			return 0;
+		}
+
+		struct Result {
+			char const *name;
+			void (*load)(S72 const &, std::vector< PosNorTanTexVertex > &, vec3 *, vec3 *);
+			double best = std::numeric_limits< double >::infinity();
+			double total = 0.0;
+			std::vector< PosNorTanTexVertex > vertices;
+			vec3 min = vec3(std::numeric_limits< float >::max());
+			vec3 max = vec3(std::numeric_limits< float >::lowest());
+		};
+		Result results[2] = {
+			Result{ .name = "seekg/read", .load = load_seekg },
+			Result{ .name = "MeshLoader", .load = load_mapped },
+		};
+
+		//runs alternate between loaders so both see the same page cache state:
+		for (uint32_t run = 0; run < runs; ++run) {
+			for (Result &result : results) {
+				result.vertices.clear();
+				result.vertices.shrink_to_fit();
+				result.vertices.reserve(vertices); //(as the viewer does)
+				result.min = vec3(std::numeric_limits< float >::max());
+				result.max = vec3(std::numeric_limits< float >::lowest());
+				Timer timer([&](double elapsed){
+					result.best = std::min(result.best, elapsed * 1000.0);
+					result.total += elapsed * 1000.0;
+				});
+				result.load(s72, result.vertices, &result.min, &result.max);
+			}
+		}
+
+		auto same = [](vec3 const &a, vec3 const &b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+		if (results[0].vertices.size() != results[1].vertices.size()
+		 || std::memcmp(results[0].vertices.data(), results[1].vertices.data(), results[0].vertices.size() * sizeof(PosNorTanTexVertex)) != 0
+		 || !same(results[0].min, results[1].min) || !same(results[0].max, results[1].max)) {
+			throw std::runtime_error("Loaders disagree about the loaded vertices.");
+		}
+
+		for (Result const &result : results) {
+			std::cout << "  " << result.name << ": best " << result.best << " ms, mean " << result.total / runs << " ms over " << runs << " runs." << std::endl;
+		}
+		std::cout << "  speedup (best): " << results[0].best / results[1].best << "x" << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "Benchmark failed:\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
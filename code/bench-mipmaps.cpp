@@ -0,0 +1,216 @@
+//Mipmap sampling benchmark (A/B of --no-mipmaps against mip chains, on the GPU):
+//  bench-mipmaps [--viewer path] [--frames F] [--runs R] [--dir folder]
+//
+//Writes a synthetic scene to folder (bench-mipmaps.s72 + .b72 + .png: a large ground grid tiled with
+// a 2048x2048 noise texture, seen from a camera just above it, so most of the frame is heavily minified),
+// then runs the viewer headless on it (F frames per run) in each configuration below, R times, interleaved.
+// The viewer prints a PERF line with the average GPU time (from its timestamp queries) every 60 frames;
+// the first PERF line of each run is dropped as warm-up, and the rest are averaged.
+//
+//NOTE: needs the viewer binary and a Vulkan device with timestamp support.
+
+#define _CRT_SECURE_NO_WARNINGS
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "external/stb_image/stb_image_write.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace {
+
+//ground grid extent (scene units; the texture repeats once per unit):
+constexpr uint32_t Cells = 50; //per side
+constexpr float CellSize = 80.0f;
+constexpr uint32_t TextureSize = 2048;
+
+void write_scene(std::string const &folder) {
+	{ //data file: Cells x Cells quads in the z = 0 plane, in front of (+y) a camera at the origin:
+		std::ofstream out(folder + "/bench-mipmaps.b72", std::ios::binary);
+		if (!out) throw std::runtime_error("Failed to open '" + folder + "/bench-mipmaps.b72' for writing.");
+		auto vertex = [&](float x, float y) {
+			//position, normal, tangent, texcoord (48 bytes, as in the s72 attributes below):
+			float v[12] = { x, y, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, x, y };
+			out.write(reinterpret_cast< char const * >(v), sizeof(v));
+		};
+		for (uint32_t j = 0; j < Cells; ++j) {
+			for (uint32_t i = 0; i < Cells; ++i) {
+				float x0 = (float(i) - 0.5f * Cells) * CellSize, x1 = x0 + CellSize;
+				float y0 = float(j) * CellSize, y1 = y0 + CellSize;
+				vertex(x0, y0); vertex(x1, y0); vertex(x1, y1);
+				vertex(x0, y0); vertex(x1, y1); vertex(x0, y1);
+			}
+		}
+		if (!out) throw std::runtime_error("Failed to write '" + folder + "/bench-mipmaps.b72'.");
+	}
+
+	{ //texture: per-texel noise over a coarse checker (so every mip level differs from its neighbors):
+		std::vector< uint8_t > pixels(size_t(TextureSize) * TextureSize * 4);
+		uint32_t state = 0x12345678u;
+		for (uint32_t y = 0; y < TextureSize; ++y) {
+			for (uint32_t x = 0; x < TextureSize; ++x) {
+				state = state * 1664525u + 1013904223u; //(LCG)
+				uint8_t base = (((x / 64) + (y / 64)) % 2 ? 160 : 64);
+				uint8_t *px = &pixels[(size_t(y) * TextureSize + x) * 4];
+				px[0] = uint8_t(base + (state >> 24) % 64);
+				px[1] = uint8_t(base + (state >> 16) % 64);
+				px[2] = uint8_t(base + (state >> 8) % 64);
+				px[3] = 255;
+			}
+		}
+		std::string path = folder + "/bench-mipmaps.png";
+		if (!stbi_write_png(path.c_str(), int(TextureSize), int(TextureSize), 4, pixels.data(), int(TextureSize) * 4)) {
+			throw std::runtime_error("Failed to write '" + path + "'.");
+		}
+	}
+
+	std::ofstream out(folder + "/bench-mipmaps.s72");
+	if (!out) throw std::runtime_error("Failed to open '" + folder + "/bench-mipmaps.s72' for writing.");
+	auto attribute = [&](char const *name, uint32_t at, char const *format) {
+		out << "\"" << name << "\":{\"src\":\"bench-mipmaps.b72\",\"offset\":" << at << ",\"stride\":48,\"format\":\"" << format << "\"}";
+	};
+	out << "[\"s72-v2\",\n";
+	out << "{\"type\":\"SCENE\",\"name\":\"bench\",\"roots\":[\"ground\",\"camera\"]},\n";
+	out << "{\"type\":\"NODE\",\"name\":\"ground\",\"mesh\":\"ground\"},\n";
+	//camera 2 units up, looking along +y and 30 degrees down (so the ground fills the frame out to the horizon):
+	out << "{\"type\":\"NODE\",\"name\":\"camera\",\"translation\":[0,0,2],\"rotation\":[0.5,0,0,0.8660254],\"camera\":\"main\"},\n";
+	out << "{\"type\":\"CAMERA\",\"name\":\"main\",\"perspective\":{\"aspect\":1.777778,\"vfov\":1.0471976,\"near\":0.1,\"far\":5000}},\n";
+	out << "{\"type\":\"MESH\",\"name\":\"ground\",\"topology\":\"TRIANGLE_LIST\",\"count\":" << Cells * Cells * 6 << ",\"attributes\":{";
+	attribute("POSITION", 0, "R32G32B32_SFLOAT"); out << ",";
+	attribute("NORMAL", 12, "R32G32B32_SFLOAT"); out << ",";
+	attribute("TANGENT", 24, "R32G32B32A32_SFLOAT"); out << ",";
+	attribute("TEXCOORD", 40, "R32G32_SFLOAT");
+	out << "},\"material\":\"ground\"},\n";
+	out << "{\"type\":\"MATERIAL\",\"name\":\"ground\",\"lambertian\":{\"albedo\":{\"src\":\"bench-mipmaps.png\"}}}\n";
+	out << "]\n";
+	if (!out) throw std::runtime_error("Failed to write '" + folder + "/bench-mipmaps.s72'.");
+}
+
+//run the viewer once; returns the GPU averages (us) from its PERF lines, minus the first:
+std::vector< double > run_viewer(std::string const &command) {
+	FILE *pipe = popen(command.c_str(), "r");
+	if (!pipe) throw std::runtime_error("Failed to run '" + command + "'.");
+
+	std::vector< double > gpu;
+	std::string line;
+	char buffer[1024];
+	while (fgets(buffer, sizeof(buffer), pipe)) {
+		line += buffer;
+		if (line.empty() || line.back() != '\n') continue; //(partial line)
+		//"PERF avg(last 60) cpu: X ms, gpu: Y us, FPS: Z"
+		if (line.starts_with("PERF ")) {
+			if (auto at = line.find("gpu: "); at != std::string::npos) {
+				gpu.emplace_back(std::stod(line.substr(at + 5)));
+			}
+		}
+		line.clear();
+	}
+	int status = pclose(pipe);
+	if (status != 0) throw std::runtime_error("'" + command + "' exited with status " + std::to_string(status) + ".");
+
+	if (gpu.size() < 2) throw std::runtime_error("'" + command + "' printed fewer than two PERF lines (too few frames, or no timestamp queries?).");
+	gpu.erase(gpu.begin()); //(warm-up)
+	return gpu;
+}
+
+} //namespace
+
+int main(int argc, char **argv) {
+	std::string viewer = "bin/viewer";
+	uint32_t frames = 600;
+	uint32_t runs = 3;
+	std::string folder = std::filesystem::temp_directory_path().string();
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if ((arg == "--viewer" || arg == "--frames" || arg == "--runs" || arg == "--dir") && argi + 1 >= argc) {
+			std::cerr << arg << " requires a parameter." << std::endl;
+			return 1;
+		}
+		if (arg == "--viewer") {
+			argi += 1;
+			viewer = argv[argi];
+		} else if (arg == "--frames") {
+			argi += 1;
+			frames = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--runs") {
+			argi += 1;
+			runs = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--dir") {
+			argi += 1;
+			folder = argv[argi];
+		} else {
+			std::cerr << "Unrecognized argument '" << arg << "'." << std::endl;
+			std::cerr << "Usage: bench-mipmaps [--viewer path] [--frames F] [--runs R] [--dir folder]" << std::endl;
+			return 1;
+		}
+	}
+	if (frames < 120 || runs == 0) {
+		std::cerr << "Need at least 120 frames (two PERF lines) and one run." << std::endl;
+		return 1;
+	}
+
+	try {
+		write_scene(folder);
+
+		std::string events = folder + "/bench-mipmaps-events.txt";
+		{
+			std::ofstream out(events);
+			for (uint32_t f = 0; f < frames; ++f) {
+				out << "AVAILABLE 0.016\n";
+			}
+			if (!out) throw std::runtime_error("Failed to write '" + events + "'.");
+		}
+
+		struct Config {
+			char const *name;
+			char const *flags;
+			double best = std::numeric_limits< double >::infinity();
+			double total = 0.0;
+			uint32_t count = 0;
+		};
+		std::vector< Config > configs{
+			Config{ .name = "no mipmaps (nearest)", .flags = "--no-mipmaps" },
+			Config{ .name = "mipmaps, trilinear", .flags = "--anisotropy 1" },
+			Config{ .name = "mipmaps, trilinear + anisotropic (default)", .flags = "" },
+		};
+
+		//interleave configurations, so drift (clocks, thermals) affects them all alike:
+		for (uint32_t run = 0; run < runs; ++run) {
+			for (Config &config : configs) {
+				std::string command = "\"" + viewer + "\" --headless --drawing-size 1920 1080"
+					" --scene \"" + folder + "/bench-mipmaps.s72\" --camera main " + config.flags
+					+ " < \"" + events + "\"";
+				for (double gpu : run_viewer(command)) {
+					config.best = std::min(config.best, gpu);
+					config.total += gpu;
+					config.count += 1;
+				}
+			}
+		}
+
+		std::cout << "GPU time per frame (average of 60-frame PERF windows), " << runs << " runs of " << frames << " frames at 1920x1080:" << std::endl;
+		double baseline = configs[0].total / configs[0].count;
+		for (Config const &config : configs) {
+			double mean = config.total / config.count;
+			std::cout << "  " << config.name << ": mean " << mean << " us, best " << config.best << " us"
+			          << " (" << mean / baseline << "x no mipmaps)." << std::endl;
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Benchmark failed:\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
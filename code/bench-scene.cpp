@@ -0,0 +1,162 @@
+//Scene loading benchmark:
+//  bench-scene [--nodes N] [--runs R] [--dir folder]
+//
+//Writes a synthetic bench-scene.s72 to folder (a binary tree of N transformed nodes, each with a mesh,
+// plus materials, textures, a camera, and drivers in proportion), then loads it R times and reports
+// the time S72::load spends in each phase (see S72::LoadTimings).
+// Only the .s72 is written; the data files and images it names are never opened by S72::load.
+
+#include "S72.hpp"
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void write_scene(std::string const &path, uint32_t nodes) {
+	std::ofstream out(path);
+	if (!out) throw std::runtime_error("Failed to open '" + path + "' for writing.");
+
+	uint32_t meshes = std::max(1u, nodes / 100);
+	uint32_t materials = std::max(1u, meshes / 4);
+	uint32_t textures = std::max(1u, materials / 2);
+	uint32_t data_files = std::max(1u, meshes / 16);
+	uint32_t drivers = std::max(1u, nodes / 100);
+
+	out << "[\"s72-v2\",\n";
+	out << "{\"type\":\"SCENE\",\"name\":\"bench\",\"roots\":[\"node0\",\"camera\"]}";
+
+	//nodes, as a binary tree rooted at node0:
+	for (uint32_t n = 0; n < nodes; ++n) {
+		out << ",\n{\"type\":\"NODE\",\"name\":\"node" << n << "\""
+		    << ",\"translation\":[" << float(n % 17) * 0.5f << "," << float(n % 5) << ",-" << float(n % 3) << "]"
+		    << ",\"rotation\":[0,0,0.38268343,0.9238795]"
+		    << ",\"scale\":[1,1,1]";
+		if (2 * n + 1 < nodes) {
+			out << ",\"children\":[\"node" << 2 * n + 1 << "\"";
+			if (2 * n + 2 < nodes) out << ",\"node" << 2 * n + 2 << "\"";
+			out << "]";
+		}
+		out << ",\"mesh\":\"mesh" << n % meshes << "\"}";
+	}
+	out << ",\n{\"type\":\"NODE\",\"name\":\"camera\",\"translation\":[0,-10,2],\"camera\":\"main\"}";
+	out << ",\n{\"type\":\"CAMERA\",\"name\":\"main\",\"perspective\":{\"aspect\":1.777,\"vfov\":1.04,\"near\":0.1,\"far\":1000}}";
+
+	for (uint32_t m = 0; m < meshes; ++m) {
+		std::string src = "data" + std::to_string(m % data_files) + ".b72";
+		uint32_t offset = (m / data_files) * 48 * 300;
+		auto attribute = [&](char const *name, uint32_t at, char const *format) {
+			out << "\"" << name << "\":{\"src\":\"" << src << "\",\"offset\":" << offset + at << ",\"stride\":48,\"format\":\"" << format << "\"}";
+		};
+		out << ",\n{\"type\":\"MESH\",\"name\":\"mesh" << m << "\",\"topology\":\"TRIANGLE_LIST\",\"count\":300,\"attributes\":{";
+		attribute("POSITION", 0, "R32G32B32_SFLOAT"); out << ",";
+		attribute("NORMAL", 12, "R32G32B32_SFLOAT"); out << ",";
+		attribute("TANGENT", 24, "R32G32B32A32_SFLOAT"); out << ",";
+		attribute("TEXCOORD", 40, "R32G32_SFLOAT");
+		out << "},\"material\":\"material" << m % materials << "\"}";
+	}
+
+	for (uint32_t m = 0; m < materials; ++m) {
+		out << ",\n{\"type\":\"MATERIAL\",\"name\":\"material" << m << "\""
+		    << ",\"normalMap\":{\"src\":\"normal" << m % textures << ".png\"}"
+		    << ",\"pbr\":{\"albedo\":{\"src\":\"albedo" << m % textures << ".png\"},\"roughness\":0.5,\"metalness\":0.0}}";
+	}
+
+	//drivers, with a few seconds of keys each:
+	for (uint32_t d = 0; d < drivers; ++d) {
+		out << ",\n{\"type\":\"DRIVER\",\"name\":\"driver" << d << "\",\"node\":\"node" << (d * 97) % nodes << "\",\"channel\":\"translation\",\"times\":[";
+		for (uint32_t k = 0; k < 60; ++k) out << (k ? "," : "") << float(k) / 24.0f;
+		out << "],\"values\":[";
+		for (uint32_t k = 0; k < 60; ++k) out << (k ? "," : "") << float(k) * 0.1f << ",0," << float(d % 7);
+		out << "]}";
+	}
+
+	out << "\n]\n";
+	if (!out) throw std::runtime_error("Failed to write '" + path + "'.");
+}
+
+} //namespace
+
+int main(int argc, char **argv) {
+	uint32_t nodes = 120'000;
+	uint32_t runs = 5;
+	std::string folder = std::filesystem::temp_directory_path().string();
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if ((arg == "--nodes" || arg == "--runs" || arg == "--dir") && argi + 1 >= argc) {
+			std::cerr << arg << " requires a parameter." << std::endl;
+			return 1;
+		}
+		if (arg == "--nodes") {
+			argi += 1;
+			nodes = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--runs") {
+			argi += 1;
+			runs = uint32_t(std::stoul(argv[argi]));
+		} else if (arg == "--dir") {
+			argi += 1;
+			folder = argv[argi];
+		} else {
+			std::cerr << "Unrecognized argument '" << arg << "'." << std::endl;
+			std::cerr << "Usage: bench-scene [--nodes N] [--runs R] [--dir folder]" << std::endl;
+			return 1;
+		}
+	}
+	if (nodes == 0 || runs == 0) {
+		std::cerr << "Need at least one node and one run." << std::endl;
+		return 1;
+	}
+
+	try {
+		std::string path = folder + "/bench-scene.s72";
+		write_scene(path, nodes);
+
+		//per-phase best and mean, in the order of LoadTimings' members:
+		struct Phase {
+			char const *name;
+			double best = std::numeric_limits< double >::infinity();
+			double total = 0.0;
+			void add(double ms) {
+				best = std::min(best, ms);
+				total += ms;
+			}
+		};
+		Phase parse{ .name = "parse" };
+		Phase resolve{ .name = "resolve" };
+		Phase paths{ .name = "paths" };
+		Phase total{ .name = "total" };
+
+		for (uint32_t run = 0; run < runs; ++run) {
+			S72::LoadTimings timings;
+			S72 s72;
+			{
+				Timer timer([&](double elapsed){ total.add(elapsed * 1000.0); });
+				s72 = S72::load(path, &timings);
+			}
+			parse.add(timings.parse);
+			resolve.add(timings.resolve);
+			paths.add(timings.paths);
+
+			if (run == 0) {
+				std::cout << "Scene '" << path << "': " << s72.nodes.size() << " nodes, " << s72.meshes.size() << " meshes, "
+				          << s72.materials.size() << " materials, " << s72.textures.size() << " textures, "
+				          << s72.data_files.size() << " data files, " << s72.drivers.size() << " drivers." << std::endl;
+			}
+		}
+
+		for (Phase const *phase : { &parse, &resolve, &paths, &total }) {
+			std::cout << "  " << phase->name << ": best " << phase->best << " ms, mean " << phase->total / runs << " ms over " << runs << " runs." << std::endl;
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Benchmark failed:\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -195,6 +195,25 @@ inline glm::vec3 rgbe_to_float(glm::u8vec4 col) {
 	);
 }
 
+//RGBE -> VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 bits, without going through float:
+// rgbe_to_float gives (m + 0.5) / 256 * 2^(e - 128) = (2m + 1) * 2^(e - 137),
+// and E5B9G9R9 stores m9 * 2^(E - 24), so m9 = 2m + 1 and E = e - 113 (exact when 113 <= e <= 144).
+// Smaller exponents shift mantissa bits out; larger ones saturate.
+inline uint32_t rgbe_to_e5b9g9r9(glm::u8vec4 col) {
+	if (col == glm::u8vec4(0,0,0,0)) return 0;
+
+	int exp = int(col.a) - 113;
+	uint32_t r = 2u * col.r + 1u, g = 2u * col.g + 1u, b = 2u * col.b + 1u;
+	if (exp < 0) {
+		if (exp < -9) return 0;
+		r >>= -exp; g >>= -exp; b >>= -exp;
+		exp = 0;
+	} else if (exp > 31) {
+		return 0xffffffffu;
+	}
+	return r | (g << 9) | (b << 18) | (uint32_t(exp) << 27);
+}
+
 inline glm::u8vec4 float_to_rgbe(glm::vec3 col) {
 
 	float d = std::max(col.r, std::max(col.g, col.b));
@@ -0,0 +1,44 @@
+#version 450 // GLSL version 4.5
+
+//objects.vert for PosNorTanTexPackedVertex:
+// Position is UNORM in the mesh's AABB; the AABB is already folded into CLIP_FROM_LOCAL / WORLD_FROM_LOCAL
+layout(location = 0) in vec4 Position;     // xyz = quantized position, w = handedness (0 => -1, 1 => +1)
+layout(location = 1) in vec2 Normal;       // octahedral
+layout(location = 2) in vec2 Tangent;      // octahedral
+layout(location = 3) in vec2 TexCoord;
+
+struct InstanceData {
+    mat4 CLIP_FROM_LOCAL;
+    mat4 WORLD_FROM_LOCAL;
+    mat4 WORLD_FROM_LOCAL_NORMAL;
+    uint MATERIAL_INDEX;
+};
+
+layout(set=1, binding=0, std140) readonly buffer SSBO_InstanceData {
+    InstanceData INSTANCEDATA[];
+};
+
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec3 normal;
+layout(location = 2) out vec2 texCoord;
+layout(location = 3) flat out uint materialId;
+layout(location = 4) out vec3 tangent;     // World-space tangent
+layout(location = 5) out float handedness; // Bitangent handedness (±1)
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0 ? -t : t);
+    n.y += (n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = INSTANCEDATA[gl_InstanceIndex].CLIP_FROM_LOCAL * vec4(Position.xyz, 1.0);
+    position = mat4x3(INSTANCEDATA[gl_InstanceIndex].WORLD_FROM_LOCAL) * vec4(Position.xyz, 1.0);
+    normal = mat3(INSTANCEDATA[gl_InstanceIndex].WORLD_FROM_LOCAL_NORMAL) * oct_decode(Normal);
+    tangent = mat3(INSTANCEDATA[gl_InstanceIndex].WORLD_FROM_LOCAL_NORMAL) * oct_decode(Tangent);
+    texCoord = TexCoord;
+    materialId = INSTANCEDATA[gl_InstanceIndex].MATERIAL_INDEX;
+    handedness = Position.w * 2.0 - 1.0;
+}
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require //(for the runtime-sized TEXTURES array)
 
 #include "tonemap.glsl"
 
@@ -14,41 +15,66 @@ layout(set=0, binding=0) uniform World{
 // Material flags packing in bits:
 // bits 0-1: BRDF type
 // bits 2-6: hasAlbedoTex, hasNormalTex, hasRoughnessTex, hasMetalnessTex, hasDisplacementTex
+// bit 7: normal texture is two-channel
 #define MAT_FLAG_BRDF_MASK              0x00000003u
 #define MAT_FLAG_HAS_ALBEDO_TEX         0x00000004u
 #define MAT_FLAG_HAS_NORMAL_TEX         0x00000008u
 #define MAT_FLAG_HAS_ROUGHNESS_TEX      0x00000010u
 #define MAT_FLAG_HAS_METALNESS_TEX      0x00000020u
 #define MAT_FLAG_HAS_DISPLACEMENT_TEX   0x00000040u
+#define MAT_FLAG_NORMAL_TEX_XY          0x00000080u
 
 struct Material {
     // Slot 0 (16 bytes)
     vec4 albedo;                    // RGBA color or placeholder
     
     // Slot 1 (16 bytes) - packed scalars
-    uint flags;                     // brdf type (bits 0-1) + texture flags (bits 2-6)
+    uint flags;                     // brdf type (bits 0-1) + texture flags (bits 2-7)
     float roughness;                // default roughness when not textured
     float metalness;                // default metalness when not textured
-    uint padding_scalar;            // padding to align slot
-    
+    uint displacement_tex;          // texture id (when MAT_FLAG_HAS_DISPLACEMENT_TEX)
+
+    // Slot 2 (16 bytes) - texture ids (each used only when its MAT_FLAG_HAS_*_TEX bit is set)
+    uint albedo_tex;
+    uint normal_tex;
+    uint roughness_tex;
+    uint metalness_tex;
 };
 
 layout(set=2, binding=0, std140) readonly buffer SSBO_Materials {
     Material MATERIALS[];
 };
 
+// where each texture id lives: TEXTURES[index], at offset + fract(uv) * scale (a sub-rectangle when packed into an atlas page)
+struct TextureRect {
+    vec2 scale;
+    vec2 offset;
+    uint index;
+    uint pad0, pad1, pad2;
+};
+
+layout(set=2, binding=1, std430) readonly buffer SSBO_TextureRects {
+    TextureRect TEXTURE_RECTS[];
+};
+
 // Material flag unpacking helpers
 uint brdfType(Material mat) { return mat.flags & MAT_FLAG_BRDF_MASK; }
 bool hasAlbedoTex(Material mat) { return (mat.flags & MAT_FLAG_HAS_ALBEDO_TEX) != 0u; }
 bool hasNormalTex(Material mat) { return (mat.flags & MAT_FLAG_HAS_NORMAL_TEX) != 0u; }
 bool hasRoughnessTex(Material mat) { return (mat.flags & MAT_FLAG_HAS_ROUGHNESS_TEX) != 0u; }
 bool hasMetalnessTex(Material mat) { return (mat.flags & MAT_FLAG_HAS_METALNESS_TEX) != 0u; }
+bool normalTexXY(Material mat) { return (mat.flags & MAT_FLAG_NORMAL_TEX_XY) != 0u; }
+
+// every material texture in the scene (materialId is the same for a whole draw, so indexing is dynamically uniform)
+layout(set=3, binding=0) uniform sampler2D TEXTURES[];
+
+// sample texture id 'tex' with repeat wrapping (done here, so it stays inside atlas rectangles; derivatives come from the
+// unwrapped uv so mip selection doesn't jump at the seams)
+vec4 sampleTexture(uint tex, vec2 uv) {
+    TextureRect r = TEXTURE_RECTS[tex];
+    return textureGrad(TEXTURES[r.index], r.offset + fract(uv) * r.scale, dFdx(uv) * r.scale, dFdy(uv) * r.scale);
+}
 
-layout(set=3, binding=0) uniform sampler2D TEXTURE_Albedo;
-layout(set=3, binding=1) uniform sampler2D TEXTURE_Normal;
-layout(set=3, binding=2) uniform sampler2D TEXTURE_Displacement;
-layout(set=3, binding=3) uniform sampler2D TEXTURE_Roughness;
-layout(set=3, binding=4) uniform sampler2D TEXTURE_Metalness;
 layout(set=0, binding=1) uniform samplerCube ENVIRONMENT_MAP;
 layout(set=0, binding=2) uniform samplerCube ENVIRONMENT_LAMBERTIAN_MAP;
 
@@ -75,14 +101,18 @@ void main() {
     // Sample albedo texture if available
     vec3 baseColor = mat.albedo.rgb;
     if (hasAlbedoTex(mat)) {
-        baseColor = texture(TEXTURE_Albedo, texCoord).rgb;
+        baseColor = sampleTexture(mat.albedo_tex, texCoord).rgb;
     }
     
     // Sample and apply normal map if available
     if (hasNormalTex(mat)) {
-        vec3 normal_sample = texture(TEXTURE_Normal, texCoord).rgb;
+        vec3 normal_sample = sampleTexture(mat.normal_tex, texCoord).rgb;
         // Scale and bias: [0,1] -> [-1,1]
         vec3 normal_ts = normal_sample * 2.0 - 1.0;
+        // Baked (BC5) normal maps only store x and y
+        if (normalTexXY(mat)) {
+            normal_ts.z = sqrt(max(0.0, 1.0 - dot(normal_ts.xy, normal_ts.xy)));
+        }
         
         // Construct TBN matrix (tangent space -> world space)
         vec3 bitangent = cross(n, ws_tangent) * handedness;
@@ -93,8 +123,8 @@ void main() {
     }
     
     // Roughness and metalness values available for PBR calculations:
-    // - mat.roughness: default value or from TEXTURE_Roughness when hasRoughnessTex(mat)
-    // - mat.metalness: default value or from TEXTURE_Metalness when hasMetalnessTex(mat)
+    // - mat.roughness: default value or from sampleTexture(mat.roughness_tex, ...) when hasRoughnessTex(mat)
+    // - mat.metalness: default value or from sampleTexture(mat.metalness_tex, ...) when hasMetalnessTex(mat)
     
     if (brdfType(mat) == BRDF_LAMBERTIAN || brdfType(mat) == BRDF_PBR) {
         baseColor = baseColor / 3.1415926; // divide by pi for energy conservation
@@ -1,25 +1,55 @@
 #include "sejp.hpp"
 
+#include "MappedFile.hpp"
+
 #include <stdexcept>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <charconv>
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 namespace sejp {
 
 struct parsed {
-	std::vector< std::optional< std::string > > strings;
+	std::string buffer; //whole source text; strings are unescaped in place and referenced by view
+	std::deque< std::string > owned_strings; //strings that aren't in buffer (e.g., from sejp::builder)
+
+	struct range {
+		uint32_t begin; //first entry in elements / members (or number_arrays, for arrays of numbers)
+		uint32_t count;
+		bool numbers = false; //array of only numbers
+	};
+
+	std::vector< std::string_view > strings;
 	std::vector< std::optional< double > > numbers;
 	//(nothing to store for booleans and nulls)
-	std::vector< std::optional< std::vector< value > > > arrays;
-	std::vector< std::optional< std::map< std::string, value > > > objects;
+	std::vector< range > arrays;
+	std::vector< uint32_t > elements; //value indices of all arrays' elements, each array contiguous
+	std::vector< double > number_arrays; //contents of all arrays of numbers, each array contiguous
+	std::vector< range > objects;
+	std::vector< object_view::member > members; //members of all objects, each object contiguous + sorted by key
+
+	//std::string / std::vector / std::map versions, built on first request by the value::as_* accessors:
+	// (node-based maps, so references handed out stay valid as more are added)
+	mutable std::mutex legacy_mutex;
+	mutable std::unordered_map< uint32_t, std::optional< std::string > > legacy_strings;
+	mutable std::unordered_map< uint32_t, std::optional< double > > legacy_numbers; //elements of arrays of numbers
+	mutable std::unordered_map< uint32_t, std::optional< std::vector< value > > > legacy_arrays;
+	mutable std::unordered_map< uint32_t, std::optional< std::map< std::string, value > > > legacy_objects;
 };
 
 enum Masks : uint32_t {
 	TypeBits  = 0xe0000000,
-	IndexBits = 0x1fffffff
+	IndexBits = 0x1fffffff,
+	InNumberArray = 0x10000000, //<--- flag on Number indices that refer to number_arrays
+	NumberIndexBits = 0x0fffffff,
 };
 
 enum Types : uint32_t {
@@ -33,273 +63,429 @@ enum Types : uint32_t {
 	Empty   = 0xe0000000, //<--- used during parsing
 };
 
-value parse(std::istream &from) {
-	//helpers to read from string:
+//lexing helpers; all advance 'p' past what they read:
 
-	auto skip_wsp = [&from]() {
-		for(;;) {
-			std::istream::int_type c = from.peek();
-			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-				from.get();
-			} else {
-				break;
-			}
-		}
-	};
+void skip_wsp(char const *&p, char const *end) {
+	while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+}
 
-	auto read_char = [&from]() -> char {
-		char c;
-		if (!from.get(c)) throw std::runtime_error("parse error: unexpected EOF.");
-		return c;
-	};
-	
-	auto read_exactly = [&read_char](std::string const &expect) {
-		for (auto e : expect) {
-			char c = read_char();
-			if (c != e) throw std::runtime_error(std::string("parse error: expected '") + e + "', got '" + c + "'.");
-		}
-	};
+char read_char(char const *&p, char const *end) {
+	if (p == end) throw std::runtime_error("parse error: unexpected EOF.");
+	return *p++;
+}
+
+void read_exactly(char const *&p, char const *end, std::string_view expect) {
+	for (auto e : expect) {
+		char c = read_char(p, end);
+		if (c != e) throw std::runtime_error(std::string("parse error: expected '") + e + "', got '" + c + "'.");
+	}
+}
 
-	auto read_number = [&from,&read_char](char first) -> double {
-		std::string acc;
-		acc += first;
-	
-		if (first == '-') {
-			//advance to first digit:
-			first = read_char();
-			acc += first;
+//advance past a run of ASCII digits, eight bytes at a time where possible:
+char const *skip_digits(char const *p, char const *end) {
+	if constexpr (std::endian::native == std::endian::little) {
+		while (end - p >= 8) {
+			uint64_t v;
+			std::memcpy(&v, p, 8);
+			//per byte, zero iff '0'-'9': high nibble must be 3 and low nibble + 6 must not carry out
+			// (bytes that carry are non-digits, so they only disturb bytes after the first non-digit)
+			uint64_t non_digit = ((v & 0xf0f0f0f0f0f0f0f0ull) ^ 0x3030303030303030ull)
+			                   | (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) ^ 0x3030303030303030ull);
+			if (non_digit) return p + std::countr_zero(non_digit) / 8;
+			p += 8;
 		}
+	}
+	while (p != end && '0' <= *p && *p <= '9') ++p;
+	return p;
+}
+
+//number starting at p[-1] (already consumed):
+double read_number(char const *&p, char const *end) {
+	char const *begin = p - 1;
+	char first = *begin;
+
+	if (first == '-') {
+		//advance to first digit:
+		first = read_char(p, end);
+	}
+
+	if (first == '0') {
+		//proceed to fraction
+	} else if ('1' <= first && first <= '9') {
+		//might be more digits
+		p = skip_digits(p, end);
+	} else {
+		throw std::runtime_error(std::string("parse error: unexpected '") + first + "' in number.");
+	}
+
+	//fraction:
+	if (p != end && *p == '.') {
+		++p;
+		char c = read_char(p, end);
+		if (!('0' <= c && c <= '9')) throw std::runtime_error(std::string("parse error: wanted fraction digits, got '") + c + "'.");
+		p = skip_digits(p, end);
+	}
+
+	//exponent:
+	if (p != end && (*p == 'E' || *p == 'e')) {
+		++p;
+		if (p != end && (*p == '-' || *p == '+')) ++p;
+		char c = read_char(p, end);
+		if (!('0' <= c && c <= '9')) throw std::runtime_error(std::string("parse error: wanted exponent digits, got '") + c + "'.");
+		p = skip_digits(p, end);
+	}
+
+	double val;
+	#ifdef __APPLE__
+	//parse in the default locale
+	// -- based on https://www.reddit.com/r/cpp/comments/2e68nd/stdstod_is_locale_dependant_but_the_docs_does_not/
+	std::istringstream iss(std::string(begin, p));
+	iss.imbue(std::locale("C"));
+	iss >> val;
+	#else
+	std::from_chars(begin, p, val);
+	#endif
+	return val;
+}
 
-		auto digits = [&acc,&from]() {
-			for(;;) {
-				std::istream::int_type p = from.peek();
-				if ('0' <= p && p <= '9') {
-					acc += char(p);
-					from.get();
-				} else {
-					break;
+//string contents starting at p (opening '"' already consumed) through the closing '"':
+// writes the unescaped string to 'out', which may be p itself (escapes only get shorter); returns end of output
+char *unescape_string(char const *&p, char const *end, char *out) {
+	for (char c = read_char(p, end); c != '"'; c = read_char(p, end)) {
+		if (c == '\\') {
+			//handle escapes:
+			c = read_char(p, end);
+			if      (c == '\\' || c == '/' || c == '"') *out++ = c;
+			else if (c == 'b') *out++ = '\b';
+			else if (c == 'f') *out++ = '\f';
+			else if (c == 'n') *out++ = '\n';
+			else if (c == 'r') *out++ = '\r';
+			else if (c == 't') *out++ = '\t';
+			else if (c == 'u') {
+				uint32_t value = 0;
+				for (uint32_t i = 0; i < 4; ++i) {
+					value <<= 4;
+					c = read_char(p, end);
+					if      ('0' <= c && c <= '9') value += (c - '0');
+					else if ('a' <= c && c <= 'f') value += (c - 'a') + 10;
+					else if ('A' <= c && c <= 'F') value += (c - 'A') + 10;
+					else throw std::runtime_error(std::string("parse error: invalid character '") + c + "' in \\uNNNN escape.");
+				}
+				assert(value <= 0xffff);
+				//TODO: handle surrogate pairs!
+				// (might result in value > 0xffff)
+
+				//re-encode as UTF8:
+				if (value <= 0x007f) {
+					*out++ = char(value);
+				} else if (value <= 0x07ff) {
+					*out++ = char(0xc0 | (value >> 6));
+					*out++ = char(0x80 | (value & 0x3f));
+				} else if (value <= 0xffff) {
+					*out++ = char(0xe0 | (value >> 12));
+					*out++ = char(0x80 | ((value >> 6) & 0x3f));
+					*out++ = char(0x80 | (value & 0x3f));
+				} else { assert(value <= 0x10ffff);
+					*out++ = char(0xf0 | (value >> 18));
+					*out++ = char(0x80 | ((value >> 12) & 0x3f));
+					*out++ = char(0x80 | ((value >> 6) & 0x3f));
+					*out++ = char(0x80 | (value & 0x3f));
 				}
+			} else {
+				throw std::runtime_error(std::string("parse error: invalid escape '\\") + c + "'.");
 			}
-		};
-
-		if (first == '0') {
-			//proceed to fraction
-		} else if ('1' <= first && first <= '9') {
-			//might be more digits
-			digits();
 		} else {
-			throw std::runtime_error(std::string("parse error: unexpected '") + first + "' in number.");
+			//plain old boring character:
+			*out++ = c;
 		}
+	}
+	return out;
+}
 
-		//fraction:
-		if (from.peek() == '.') {
-			acc += read_char();
-			char c = read_char();
-			if (!('0' <= c && c <= '9')) throw std::runtime_error(std::string("parse error: wanted fraction digits, got '") + c + "'.");
-			acc += c;
-			digits();
+//Tokenizes [begin, end) and sends the resulting events to handler:
+// if 'writable' is set, strings are unescaped in place (so the views passed on point into [begin, end));
+// otherwise, strings without escapes are passed as views of [begin, end) and others go through a scratch buffer.
+// (a template so the DOM builder's calls get resolved statically)
+template< typename Handler >
+void tokenize(char const *begin, char const *end, bool writable, Handler &handler) {
+	char const *p = begin;
+
+	std::string scratch; //unescaped strings, when not writable
+	std::vector< double > number_scratch; //arrays of numbers
+
+	auto read_string = [&]() -> std::string_view {
+		if (writable) {
+			char *out = const_cast< char * >(p);
+			char *out_end = unescape_string(p, end, out);
+			return std::string_view(out, out_end - out);
 		}
-
-		//exponent:
-		if (from.peek() == 'E' || from.peek() == 'e') {
-			acc += read_char();
-			if (from.peek() == '-' || from.peek() == '+') {
-				acc += read_char();
-			}
-			char c = read_char();
-			if (!('0' <= c && c <= '9')) throw std::runtime_error(std::string("parse error: wanted exponent digits, got '") + c + "'.");
-			acc += c;
-			digits();
+		//look for the end of the string, noting if there are any escapes:
+		char const *q = p;
+		while (q != end && *q != '"' && *q != '\\') ++q;
+		if (q != end && *q == '"') {
+			std::string_view ret(p, q - p);
+			p = q + 1;
+			return ret;
 		}
-
-		double val;
-		#ifdef __APPLE__
-		//parse in the default locale
-		// -- based on https://www.reddit.com/r/cpp/comments/2e68nd/stdstod_is_locale_dependant_but_the_docs_does_not/
-		std::istringstream iss(acc);
-		iss.imbue(std::locale("C"));
-		iss >> val;
-		#else
-		const char *begin = acc.data();
-		std::from_chars(begin, begin + acc.size(), val);
-		#endif
-		return val;
+		//find the closing quote (skipping escaped characters), since the string's raw length bounds its unescaped size:
+		while (q != end && *q != '"') {
+			if (*q == '\\' && q + 1 != end) ++q;
+			++q;
+		}
+		scratch.resize(q - p);
+		char *out_end = unescape_string(p, end, scratch.data());
+		return std::string_view(scratch.data(), out_end - scratch.data());
 	};
 
-	auto read_string = [&read_char]() -> std::string {
-		std::string ret;
-		for (char c = read_char(); c != '"'; c = read_char()) {
-			if (c == '\\') {
-				//handle escapes:
-				c = read_char();
-				if      (c == '\\' || c == '/' || c == '"') ret += c;
-				else if (c == 'b') ret += '\b';
-				else if (c == 'f') ret += '\f';
-				else if (c == 'n') ret += '\n';
-				else if (c == 'r') ret += '\r';
-				else if (c == 't') ret += '\t';
-				else if (c == 'u') {
-					uint32_t value = 0;
-					for (uint32_t i = 0; i < 4; ++i) {
-						value <<= 4;
-						c = read_char();
-						if      ('0' <= c && c <= '9') value += (c - '0');
-						else if ('a' <= c && c <= 'f') value += (c - 'a') + 10;
-						else if ('A' <= c && c <= 'F') value += (c - 'A') + 10;
-						else throw std::runtime_error(std::string("parse error: invalid character '") + c + "' in \\uNNNN escape.");
-					}
-					assert(value <= 0xffff);
-					//TODO: handle surrogate pairs!
-					// (might result in value > 0xffff)
-
-					//re-encode as UTF8:
-					if (value <= 0x007f) {
-						ret += char(value);
-					} else if (value <= 0x07ff) {
-						ret += char(0xc0 | (value >> 6));
-						ret += char(0x80 | (value & 0x3f));
-					} else if (value <= 0xffff) {
-						ret += char(0xe0 | (value >> 12));
-						ret += char(0x80 | ((value >> 6) & 0x3f));
-						ret += char(0x80 | (value & 0x3f));
-					} else { assert(value <= 0x10ffff);
-						ret += char(0xf0 | (value >> 18));
-						ret += char(0x80 | ((value >> 12) & 0x3f));
-						ret += char(0x80 | ((value >> 6) & 0x3f));
-						ret += char(0x80 | (value & 0x3f));
-					}
-				} else {
-					throw std::runtime_error(std::string("parse error: invalid escape '\\") + c + "'.");
-				}
+	//array of only numbers starting at p (opening '[' already consumed):
+	// if something other than a number shows up, rewinds and returns false so the general parser can handle it
+	auto read_number_array = [&]() -> bool {
+		char const *const start = p;
+		number_scratch.clear();
+		skip_wsp(p, end);
+		while (p != end && (*p == '-' || ('0' <= *p && *p <= '9'))) {
+			++p;
+			number_scratch.emplace_back(read_number(p, end));
+			skip_wsp(p, end);
+			if (p != end && *p == ',') {
+				++p;
+				skip_wsp(p, end);
+			} else if (p != end && *p == ']') {
+				++p;
+				handler.numbers(std::span< double const >(number_scratch));
+				return true;
 			} else {
-				//plain old boring character:
-				ret += c;
+				break;
 			}
 		}
-		return ret;
+		p = start;
+		return false;
 	};
 
-
 	//-------------------
 	//parsing:
 
-	std::shared_ptr< sejp::parsed > parsed = std::make_shared< sejp::parsed >();
-
-	value root = value(parsed, -1U);
-	std::vector< uint32_t > parents; //containing maps/arrays
+	//containing maps/arrays:
+	struct Parent {
+		bool object;
+		bool empty;
+	};
+	std::vector< Parent > parents;
+	bool have_root = false;
 
 	//overall parsing idea:
-	//value: (target is empty)
+	//value:
 	// whitespace
-	//  set up next entry if target is object or array:
-	//    (only if) target is object:
-	//         '}' -> finish target, continue
+	//  set up next entry if parent is object or array:
+	//    (only if) parent is object:
+	//         '}' -> finish parent, continue
 	//         expect ',' if non-empty
-	//         '"' -> expect key, ':', push empty, fall through
-	//    (only if) target is array:
-	//         ']' -> finish target, continue
+	//         '"' -> expect key, ':', fall through
+	//    (only if) parent is array:
+	//         ']' -> finish parent, continue
 	//         expect ',' if non-empty
-	//         push empty, fall through
-	//  now target is empty, fill with value:
-	//  '{' -> key_or_object_end [new object, set target to object, continue]
-	//  '[' -> value_or_array_end [new array, set target to array, continue]
+	//         fall through
+	//  now read a value:
+	//  '{' -> key_or_object_end [new object, set parent to object, continue]
+	//  '[' -> value_or_array_end [new array (or whole array of numbers), set parent to array, continue]
 	//   '"' -> string
 	//   '-', '0'-'9' -> number
 	//   't' -> bool ("true")
 	//   'f' -> bool ("false")
 	//   'n' -> null ("null")
-	//   finish target
 
-	while (root.index == -1U || !parents.empty()) {
-		skip_wsp();
-		char c = read_char(); //first character of value
+	while (!have_root || !parents.empty()) {
+		skip_wsp(p, end);
+		char c = read_char(p, end); //first character of value
 
-		//value to be filled in later:
-		value *target = nullptr;
-
-		//figure out which value to fill in:
+		//figure out where the value goes:
 		if (parents.empty()) {
-			target = &root;
-		} else if ((parents.back() & TypeBits) == Object) {
+			have_root = true;
+		} else if (parents.back().object) {
 			if (c == '}') {
 				parents.pop_back();
+				handler.end_object();
 				continue;
 			}
-			std::map< std::string, value > &map = parsed->objects.at( parents.back() & IndexBits ).value();
-			if (!map.empty()) {
+			if (!parents.back().empty) {
 				//consume comma between entries:
 				if (c != ',') throw std::runtime_error("parse error: expected ',' between object members.");
-				skip_wsp();
-				c = read_char();
+				skip_wsp(p, end);
+				c = read_char(p, end);
 			}
+			parents.back().empty = false;
 			if (c != '"') throw std::runtime_error("parse error: expecting '\"' at start of key.");
-			std::string key = read_string();
-			skip_wsp();
-			c = read_char();
+			handler.key(read_string());
+			skip_wsp(p, end);
+			c = read_char(p, end);
 			if (c != ':') throw std::runtime_error("parse error: expecting ':' after value.");
-			skip_wsp();
-			c = read_char(); //actual first character of value
-			auto ret = map.insert_or_assign(key, value(parsed, -1U));
-			target = &ret.first->second;
+			skip_wsp(p, end);
+			c = read_char(p, end); //actual first character of value
 			//(fall through to value-getting code)
-		} else if ((parents.back() & TypeBits) == Array) {
+		} else {
 			if (c == ']') {
 				parents.pop_back();
+				handler.end_array();
 				continue;
 			}
-			std::vector< value > &array = parsed->arrays.at( parents.back() & IndexBits ).value();
-			if (!array.empty()) {
+			if (!parents.back().empty) {
 				if (c != ',') throw std::runtime_error(std::string("parse error: expected ',' between array entries; got '") + c + "'.");
-				skip_wsp();
-				c = read_char(); //actual first character of value
+				skip_wsp(p, end);
+				c = read_char(p, end); //actual first character of value
 			}
-			array.emplace_back(parsed, -1U);
-			target = &array.back();
+			parents.back().empty = false;
 			//(fall through to value-getting code)
 		}
 
-		//actually fill in the value:
-		assert(target && (target->index & TypeBits) == Empty);
-
+		//actually read the value:
 		if        (c == '{') { //object
-			if (uint32_t(parsed->objects.size()) & ~IndexBits) throw std::runtime_error("parser error: too many objects.");
-			target->index = Object | uint32_t(parsed->objects.size());
-			parents.emplace_back(target->index);
-			parsed->objects.emplace_back(std::in_place);
-			continue;
+			parents.emplace_back(Parent{ .object = true, .empty = true });
+			handler.begin_object();
 		} else if (c == '[') { //array
-			if (uint32_t(parsed->arrays.size()) & ~IndexBits) throw std::runtime_error("parser error: too many arrays.");
-			target->index = Array | uint32_t(parsed->arrays.size());
-			parents.emplace_back(target->index);
-			parsed->arrays.emplace_back(std::in_place);
-			continue;
+			if (read_number_array()) continue; //(already closed)
+			parents.emplace_back(Parent{ .object = false, .empty = true });
+			handler.begin_array();
 		} else if (c == '"') { //string
-			if (uint32_t(parsed->strings.size()) & ~IndexBits) throw std::runtime_error("parser error: too many strings.");
-			target->index = String | uint32_t(parsed->strings.size());
-			parsed->strings.emplace_back(read_string());
+			handler.string(read_string());
 		} else if (c == '-' || (c >= '0' && c <= '9')) { //number
-			if (uint32_t(parsed->numbers.size()) & ~IndexBits) throw std::runtime_error("parser error: too many numbers.");
-			target->index = Number | uint32_t(parsed->numbers.size());
-			parsed->numbers.emplace_back(read_number(c));
+			handler.number(read_number(p, end));
 		} else if (c == 't') { //true
-			read_exactly("rue");
-			target->index = True;
+			read_exactly(p, end, "rue");
+			handler.boolean(true);
 		} else if (c == 'f') { //false
-			read_exactly("alse");
-			target->index = False;
+			read_exactly(p, end, "alse");
+			handler.boolean(false);
 		} else if (c == 'n') { //null
-			read_exactly("ull");
-			target->index = Null;
+			read_exactly(p, end, "ull");
+			handler.null();
 		} else {
 			throw std::runtime_error(std::string("parse error: value cannot start with '") + c + "'.");
 		}
 	}
 
-	skip_wsp();
+	skip_wsp(p, end);
+
+	if (p != end) throw std::runtime_error("parse error: trailing junk.");
+}
+
+//tokenizes parsed->buffer in place, building values directly into parsed:
+value parse(std::shared_ptr< parsed > const &parsed) {
+	builder builder;
+	builder.data = parsed;
+	builder.copy_strings = false;
+	tokenize(parsed->buffer.data(), parsed->buffer.data() + parsed->buffer.size(), true, builder);
+	return builder.finish();
+}
+
+//------------------------------------------
+
+void handler::numbers(std::span< double const > numbers) {
+	begin_array();
+	for (double n : numbers) {
+		number(n);
+	}
+	end_array();
+}
+
+builder::builder() : data(std::make_shared< parsed >()), root(Empty) {
+}
+
+value builder::finish() {
+	if (root == Empty || !parents.empty()) throw std::runtime_error("sejp::builder: value is not complete.");
+	return value(data, root);
+}
+
+void builder::attach(uint32_t index) {
+	if (parents.empty()) {
+		if (root != Empty) throw std::runtime_error("sejp::builder: more than one top-level value.");
+		root = index;
+	} else if ((parents.back().index & TypeBits) == Object) {
+		pending_members.emplace_back(object_view::member{ .key = pending_key, .index = index });
+	} else {
+		pending_elements.emplace_back(index);
+	}
+}
+
+void builder::begin_object() {
+	if (uint32_t(data->objects.size()) & ~IndexBits) throw std::runtime_error("parser error: too many objects.");
+	uint32_t index = Object | uint32_t(data->objects.size());
+	data->objects.emplace_back(parsed::range{ .begin = 0, .count = 0 });
+	attach(index);
+	parents.emplace_back(Parent{ .index = index, .first = uint32_t(pending_members.size()) });
+}
+
+void builder::key(std::string_view key) {
+	if (copy_strings) key = data->owned_strings.emplace_back(key);
+	pending_key = key;
+}
+
+void builder::end_object() {
+	assert(!parents.empty() && (parents.back().index & TypeBits) == Object);
+	Parent const &parent = parents.back();
+
+	//sort by key, keeping only the last of any duplicates:
+	auto begin = pending_members.begin() + parent.first;
+	std::stable_sort(begin, pending_members.end(), [](object_view::member const &a, object_view::member const &b) {
+		return a.key < b.key;
+	});
+	parsed::range &range = data->objects[parent.index & IndexBits];
+	range.begin = uint32_t(data->members.size());
+	for (auto m = begin; m != pending_members.end(); ++m) {
+		if (m + 1 != pending_members.end() && (m + 1)->key == m->key) continue;
+		data->members.emplace_back(*m);
+	}
+	range.count = uint32_t(data->members.size()) - range.begin;
+	pending_members.resize(parent.first);
+	parents.pop_back();
+}
+
+void builder::begin_array() {
+	if (uint32_t(data->arrays.size()) & ~IndexBits) throw std::runtime_error("parser error: too many arrays.");
+	uint32_t index = Array | uint32_t(data->arrays.size());
+	data->arrays.emplace_back(parsed::range{ .begin = 0, .count = 0 });
+	attach(index);
+	parents.emplace_back(Parent{ .index = index, .first = uint32_t(pending_elements.size()) });
+}
+
+void builder::end_array() {
+	assert(!parents.empty() && (parents.back().index & TypeBits) == Array);
+	Parent const &parent = parents.back();
+
+	parsed::range &range = data->arrays[parent.index & IndexBits];
+	range.begin = uint32_t(data->elements.size());
+	range.count = uint32_t(pending_elements.size() - parent.first);
+	data->elements.insert(data->elements.end(), pending_elements.begin() + parent.first, pending_elements.end());
+	pending_elements.resize(parent.first);
+	parents.pop_back();
+}
+
+void builder::string(std::string_view string) {
+	if (uint32_t(data->strings.size()) & ~IndexBits) throw std::runtime_error("parser error: too many strings.");
+	if (copy_strings) string = data->owned_strings.emplace_back(string);
+	attach(String | uint32_t(data->strings.size()));
+	data->strings.emplace_back(string);
+}
+
+void builder::number(double number) {
+	if (uint32_t(data->numbers.size()) & ~NumberIndexBits) throw std::runtime_error("parser error: too many numbers.");
+	attach(Number | uint32_t(data->numbers.size()));
+	data->numbers.emplace_back(number);
+}
+
+void builder::boolean(bool boolean) {
+	attach(boolean ? True : False);
+}
 
-	if (from.peek() != std::iostream::traits_type::eof()) throw std::runtime_error("parse error: trailing junk.");
+void builder::null() {
+	attach(Null);
+}
 
-	return root;
+void builder::numbers(std::span< double const > numbers) {
+	if (uint32_t(data->arrays.size()) & ~IndexBits) throw std::runtime_error("parser error: too many arrays.");
+	if ((data->number_arrays.size() + numbers.size()) & ~size_t(NumberIndexBits)) throw std::runtime_error("parser error: too many numbers.");
+	attach(Array | uint32_t(data->arrays.size()));
+	data->arrays.emplace_back(parsed::range{ .begin = uint32_t(data->number_arrays.size()), .count = uint32_t(numbers.size()), .numbers = true });
+	data->number_arrays.insert(data->number_arrays.end(), numbers.begin(), numbers.end());
 }
 
 //------------------------------------------
@@ -308,7 +494,10 @@ value parse(std::istream &from) {
 std::optional< std::string > const &value::as_string() const {
 	static std::optional< std::string > const empty;
 	if ((index & TypeBits) == String) {
-		return data->strings[index & IndexBits];
+		std::lock_guard< std::mutex > lock(data->legacy_mutex);
+		auto ret = data->legacy_strings.try_emplace(index & IndexBits);
+		if (ret.second) ret.first->second.emplace(data->strings[index & IndexBits]);
+		return ret.first->second;
 	} else {
 		return empty;
 	}
@@ -317,7 +506,13 @@ std::optional< std::string > const &value::as_string() const {
 std::optional< double > const &value::as_number() const {
 	static std::optional< double > const empty;
 	if ((index & TypeBits) == Number) {
-		return data->numbers[index & IndexBits];
+		if (index & InNumberArray) {
+			std::lock_guard< std::mutex > lock(data->legacy_mutex);
+			auto ret = data->legacy_numbers.try_emplace(index & NumberIndexBits);
+			if (ret.second) ret.first->second.emplace(data->number_arrays[index & NumberIndexBits]);
+			return ret.first->second;
+		}
+		return data->numbers[index & NumberIndexBits];
 	} else {
 		return empty;
 	}
@@ -349,7 +544,18 @@ std::optional< nullptr_t > const &value::as_null() const {
 std::optional< std::vector< value > > const &value::as_array() const {
 	static std::optional< std::vector< value > > const empty;
 	if ((index & TypeBits) == Array) {
-		return data->arrays[index & IndexBits];
+		std::lock_guard< std::mutex > lock(data->legacy_mutex);
+		auto ret = data->legacy_arrays.try_emplace(index & IndexBits);
+		if (ret.second) {
+			parsed::range const &range = data->arrays[index & IndexBits];
+			std::vector< value > &array = ret.first->second.emplace();
+			array.reserve(range.count);
+			for (uint32_t i = 0; i < range.count; ++i) {
+				if (range.numbers) array.emplace_back(data, uint32_t(Number) | InNumberArray | (range.begin + i));
+				else array.emplace_back(data, data->elements[range.begin + i]);
+			}
+		}
+		return ret.first->second;
 	} else {
 		return empty;
 	}
@@ -358,22 +564,110 @@ std::optional< std::vector< value > > const &value::as_array() const {
 std::optional< std::map< std::string, value > > const &value::as_object() const {
 	static std::optional< std::map< std::string, value > > const empty;
 	if ((index & TypeBits) == Object) {
-		return data->objects[index & IndexBits];
+		std::lock_guard< std::mutex > lock(data->legacy_mutex);
+		auto ret = data->legacy_objects.try_emplace(index & IndexBits);
+		if (ret.second) {
+			parsed::range const &range = data->objects[index & IndexBits];
+			std::map< std::string, value > &map = ret.first->second.emplace();
+			for (uint32_t i = 0; i < range.count; ++i) {
+				object_view::member const &member = data->members[range.begin + i];
+				//(members are sorted, so each insert goes at the end)
+				map.emplace_hint(map.end(), std::string(member.key), value(data, member.index));
+			}
+		}
+		return ret.first->second;
 	} else {
 		return empty;
 	}
 }
 
+std::optional< std::string_view > value::as_string_view() const {
+	if ((index & TypeBits) == String) {
+		return data->strings[index & IndexBits];
+	} else {
+		return std::nullopt;
+	}
+}
+
+std::optional< array_view > value::as_array_view() const {
+	if ((index & TypeBits) == Array) {
+		parsed::range const &range = data->arrays[index & IndexBits];
+		if (range.numbers) {
+			return array_view{ .data = data, .elements = nullptr, .first_number = range.begin, .count = range.count };
+		} else {
+			return array_view{ .data = data, .elements = data->elements.data() + range.begin, .first_number = 0, .count = range.count };
+		}
+	} else {
+		return std::nullopt;
+	}
+}
+
+std::optional< std::span< double const > > value::as_numbers() const {
+	if ((index & TypeBits) == Array) {
+		parsed::range const &range = data->arrays[index & IndexBits];
+		if (range.numbers) return std::span< double const >(data->number_arrays.data() + range.begin, range.count);
+		else if (range.count == 0) return std::span< double const >();
+	}
+	return std::nullopt;
+}
+
+value array_view::operator[](uint32_t i) const {
+	if (elements) return value(data, elements[i]);
+	else return value(data, uint32_t(Number) | InNumberArray | (first_number + i));
+}
+
+std::optional< object_view > value::as_object_view() const {
+	if ((index & TypeBits) == Object) {
+		parsed::range const &range = data->objects[index & IndexBits];
+		return object_view{ .data = data, .members = data->members.data() + range.begin, .count = range.count };
+	} else {
+		return std::nullopt;
+	}
+}
+
+std::optional< value > object_view::find(std::string_view key) const {
+	member const *f = std::lower_bound(members, members + count, key, [](member const &m, std::string_view k) {
+		return m.key < k;
+	});
+	if (f != members + count && f->key == key) {
+		return value(data, f->index);
+	} else {
+		return std::nullopt;
+	}
+}
+
 //-------------------------------
 
 value load(std::string const &filename) {
+	std::shared_ptr< sejp::parsed > parsed = std::make_shared< sejp::parsed >();
+
+	//read the whole file in one go:
 	std::ifstream in(filename, std::ios::binary);
-	return parse(in);
+	if (!in) throw std::runtime_error("Failed to open '" + filename + "'.");
+	in.seekg(0, std::ios::end);
+	std::streamoff size = in.tellg();
+	in.seekg(0, std::ios::beg);
+	if (size < 0) throw std::runtime_error("Failed to get size of '" + filename + "'.");
+	parsed->buffer.resize(size_t(size));
+	if (!in.read(parsed->buffer.data(), size)) throw std::runtime_error("Failed to read '" + filename + "'.");
+
+	return parse(parsed);
 }
 
 value parse(std::string const &string) {
-	std::istringstream in(string, std::ios::binary);
-	return parse(in);
+	std::shared_ptr< sejp::parsed > parsed = std::make_shared< sejp::parsed >();
+	parsed->buffer = string;
+	return parse(parsed);
+}
+
+void load(std::string const &filename, handler &handler) {
+	MappedFile file(filename);
+	char const *begin = reinterpret_cast< char const * >(file.data());
+	tokenize(begin, begin + file.size(), false, handler);
+}
+
+void parse(std::string const &string, handler &handler) {
+	tokenize(string.data(), string.data() + string.size(), false, handler);
 }
 
 } //namespace sejp
@@ -5,16 +5,21 @@
 //then provides a generic "value" handle to the root.
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <optional>
 #include <memory>
+#include <span>
 #include <cstdint>
 
 namespace sejp {
 	//sejp::parsed represents the results of scanning a JSON file:
 	struct parsed;
-	
+
+	struct array_view;
+	struct object_view;
+
 	//generic value:
 	struct value {
 		//internals:
@@ -24,19 +29,120 @@ namespace sejp {
 
 		//interface:
 		//  NOTE: these functions take O(1) time
+		//  NOTE: string/array/object results are materialized on first request (thread-safe) and cached
 		std::optional< std::string > const &as_string() const;
 		std::optional< double > const &as_number() const;
 		std::optional< bool > const &as_bool() const;
 		std::optional< nullptr_t > const &as_null() const;
 		std::optional< std::vector< value > > const &as_array() const;
 		std::optional< std::map< std::string, value > > const &as_object() const;
+
+		//zero-copy interface:
+		//  NOTE: views point into the parsed data, so remain valid while any value refers to it
+		std::optional< std::string_view > as_string_view() const;
+		std::optional< array_view > as_array_view() const;
+		std::optional< object_view > as_object_view() const;
+		//arrays holding only numbers are stored contiguously, so can be viewed as a span:
+		//  NOTE: nullopt if not an array of numbers; empty span for an empty array
+		std::optional< std::span< double const > > as_numbers() const;
+	};
+
+	//array elements, in order:
+	struct array_view {
+		std::shared_ptr< parsed const > data;
+		uint32_t const *elements; //nullptr for arrays of numbers
+		uint32_t first_number; //first entry in number storage, for arrays of numbers
+		uint32_t count;
+
+		uint32_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		value operator[](uint32_t i) const;
+	};
+
+	//object members, sorted by key (duplicate keys keep the last value, as in as_object()):
+	struct object_view {
+		struct member {
+			std::string_view key;
+			uint32_t index;
+		};
+		std::shared_ptr< parsed const > data;
+		member const *members;
+		uint32_t count;
+
+		uint32_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		std::string_view key(uint32_t i) const { return members[i].key; }
+		value operator[](uint32_t i) const { return value(data, members[i].index); }
+		//O(log n) lookup:
+		std::optional< value > find(std::string_view key) const;
+	};
+
+	//streaming ("SAX-style") interface:
+	//  events arrive in document order; nothing is retained by the parser
+	//  NOTE: string_views passed to key() / string() are only valid during the call
+	//  NOTE: an exception thrown from a handler aborts the parse
+	struct handler {
+		virtual ~handler() = default;
+		virtual void begin_object() = 0;
+		virtual void key(std::string_view key) = 0; //(before each member's value)
+		virtual void end_object() = 0;
+		virtual void begin_array() = 0;
+		virtual void end_array() = 0;
+		virtual void string(std::string_view string) = 0;
+		virtual void number(double number) = 0;
+		virtual void boolean(bool boolean) = 0;
+		virtual void null() = 0;
+		//a non-empty array of only numbers; by default forwarded as begin_array(), number()..., end_array():
+		virtual void numbers(std::span< double const > numbers);
+	};
+
+	//handler that builds a value out of the events it receives:
+	//  (e.g., to keep just one part of a stream as a value)
+	struct builder final : handler {
+		builder();
+		//the value built so far; call once the outermost value has ended:
+		//  NOTE: throws if called before a complete value has been received
+		value finish();
+
+		void begin_object() override;
+		void key(std::string_view key) override;
+		void end_object() override;
+		void begin_array() override;
+		void end_array() override;
+		void string(std::string_view string) override;
+		void number(double number) override;
+		void boolean(bool boolean) override;
+		void null() override;
+		void numbers(std::span< double const > numbers) override;
+
+		//internals:
+		std::shared_ptr< parsed > data;
+		bool copy_strings = true; //false => views passed to key() / string() already point into data->buffer
+		uint32_t root;
+		struct Parent {
+			uint32_t index;
+			uint32_t first; //first child in pending_elements / pending_members
+		};
+		std::vector< Parent > parents; //containing maps/arrays; their children collect on the pending_* stacks until closed
+		std::vector< uint32_t > pending_elements;
+		std::vector< object_view::member > pending_members;
+		std::string_view pending_key;
+		void attach(uint32_t index);
 	};
 
 	//how you make values:
 	//  NOTE: O(length of data) time, space.
+	//  NOTE: the whole file is read into one buffer and tokenized in place
+	//  NOTE: arrays of only numbers are parsed with a fast path straight into contiguous storage
 	//  NOTE: loaded data is retained via shared_ptr until values referring to it go out of scope
 	//  NOTE: throws on parse error
 	value load(std::string const &filename);
 	value parse(std::string const &string);
 
+	//stream events to a handler instead:
+	//  NOTE: load() memory-maps the file, so no copy of the text is made
+	//  NOTE: throws on parse error
+	void load(std::string const &filename, handler &handler);
+	void parse(std::string const &string, handler &handler);
+
 } //namespace sejp